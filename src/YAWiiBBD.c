@@ -1,4 +1,8 @@
 #include "YAWiiBBessentials.h"
+#include "YAWiiBBcapture.h"
+#include "YAWiiBBcache.h"
+#include "YAWiiBBserver.h"
+#include "YAWiiBBtransport.h"
 /**
  * @mainpage YAWiiBBD Project Documentation
  * 
@@ -37,13 +41,10 @@
  *
  * ## Compilation Instructions
  * Compile the application using the following commands based on the intended configuration:
- * - **Standard Version**: Basic setup for data streaming.
+ * One build contains every output level; the extended output (DECODE, DEBUG) that used 
+ * to need `-DYAWIIBB_EXTENDED` is selected at runtime with `-l`.
  *   @code
- *   gcc -Wall -o YAWiiBBD YAWiiBBD.c -lbluetooth
- *   @endcode
- * - **Extended Version**: Includes additional features and functions found in `YAWiiBBessentials.c`.
- *   @code
- *   gcc -DYAWIIBB_EXTENDED -Wall -o YAwiiBBD YAWiiBBD.c YAWiiBBessentials.c -lbluetooth
+ *   gcc -Wall -o YAWiiBBD YAWiiBBD.c YAWiiBBessentials.c YAWiiBBring.c YAWiiBBbatch.c YAWiiBBcapture.c YAWiiBBcache.c YAWiiBBhistogram.c YAWiiBBshm.c YAWiiBBserver.c YAWiiBBwriter.c YAWiiBBreport.c YAWiiBBtransport.c YAWiiBBsway.c YAWiiBBfilter.c YAWiiBBaggregate.c -lbluetooth -lm
  *   @endcode
  * 
  * @note Ensure all required Bluetooth dependencies are installed and configured 
@@ -52,50 +53,116 @@
 
 
 /**
- * @brief Default logging level for output verbosity, dependent on compilation mode.
+ * @brief Logging level the boards start with, selected with the `-l` option.
+ *
+ * `RAW` (default) limits the output to raw, uninterpreted data; `decode`, `debug` 
+ * and `verbose` select the other levels (`DECODE`, `DEBUG`, `VERBOSE`). The level 
+ * can be changed while running with `l <level>` + Enter.
+ */
+LogLevel debug_level = RAW; //Options RAW, DECODE, DEBUG, VERBOSE
+
+/**
+ * @brief Output format selected with the `-o` option, text by default.
+ *
+ * With `-o binary` every data report is written as a fixed-size record as 
+ * described in `YAWiiBBbinary.h`; all other messages go to stderr then, so 
+ * stdout carries nothing but the binary stream. With `-o shm` the same records 
+ * go into the shared-memory ring `shm_output` (`YAWiiBBshm.h`).
+ */
+OutputFormat output_format = OUTPUT_TEXT;
+
+/**
+ * @brief Shared-memory ring of `-o shm`, opened in `main()` before the output thread starts.
+ */
+ShmRing shm_output;
+
+/**
+ * @brief Reception time in front of every text line, selected with the `-t` option.
+ */
+bool text_timestamps = false;
+
+/**
+ * @brief Handler of `SIGUSR1`, requests the timing statistics from the event loop.
+ */
+static void request_stats(int signum) {
+    (void)signum;
+    stats_requested = 1;
+}
+
+/**
+ * @brief Prints the command line synopsis to stderr.
  *
- * The `debug_level` constant controls the verbosity of output logging for the Wii Balance Board.
- * - When compiled without the `YAWIIBB_EXTENDED` flag, the logging level is set to the only available option `RAW`, 
- *   limiting output to raw, uninterpreted data.
- * - When compiled with the `YAWIIBB_EXTENDED` flag, the logging level defaults to `DEBUG`, 
- *   allowing the selection between multiple verbosity levels (`RAW`, `DECODE`, `DEBUG`, and optionally `VERBOSE`).
+ * @param program Name of the program (`argv[0]`).
  */
-#ifdef YAWIIBB_EXTENDED
-const LogLevel debug_level = DEBUG; //Options RAW, DECODE, DEBUG, (VERBOSE)
-#else
-const LogLevel debug_level = RAW; 
-#endif // YAWIIBB_EXTENDED
+static void print_usage(const char* program) {
+    fprintf(stderr, "Aufruf: %s [-o text|binary|shm] [-l raw|decode|debug] [-m Name] [-u Socket] [-t] [-r Slots] [-d oldest|newest] [-c Datei] [-i Datei [-f]] [-s Verzeichnis] [-w ms] [-b l2cap|hidraw|evdev] [-a off|add|only] [-F Filter] [-R Hz] [-W ms,...] [MAC ...]\n", program);
+}
 
 
 /**
  * @brief Main loop of the application.
  *
  * This function executes the core operations of the application, performing 
- * various actions based on the flags set within the `WiiBalanceBoard` object. 
+ * various actions based on the flags set within each `WiiBalanceBoard` object. 
  * These actions include status checks, calibration, activation, and toggling 
- * the LED on or off. The received data from the Balance Board is processed 
+ * the LED on or off. The received data from the Balance Boards is processed 
  * and handled within this loop.
  *
- * The loop includes a 10-millisecond delay to reduce CPU load and ensure 
- * efficient processing of data. It runs continuously until a termination 
- * signal is received.
+ * Instead of polling with a fixed delay, the loop blocks in `epoll_wait()` until 
+ * either a `receive_sock` becomes readable or the timerfd fires. Readable data is 
+ * drained completely by `drain_receive_sock()` into the report ring, from where the 
+ * output thread writes it to stdout, so a slow consumer of stdout never stops the 
+ * loop from draining the sockets. The timer tick (`TIMER_INTERVAL_MS`) is used for timed 
+ * work, currently to notice a termination or a statistics request of the input thread and to 
+ * close boards stopped by the output thread (power button).
+ *
+ * All boards of the daemon share this one loop; a board that stops (power button 
+ * or receive error) is closed on its own while the others continue.
  *
- * @param board A pointer to the `WiiBalanceBoard` object containing current 
- *              status information and control flags.
+ * @param daemon A pointer to the `BoardDaemon` object containing the boards and 
+ *               the descriptors of the event loop.
  */
 
 
-void main_loop(WiiBalanceBoard* board) {
-    if (board->needStatus) handle_status(board);
-    if (board->needCalibration) handle_calibration(board);
-    if (!board->led) handle_led_on(board);
-    if (board->needActivation) handle_activation(board);
-    if (board->needDumpStart) handle_data_dump(board);
+void main_loop(BoardDaemon* daemon) {
+    for (int i = 0; i < daemon->count; i++) {
+        WiiBalanceBoard* board = &daemon->boards[i];
+        if (!board->is_running || board->state != BOARD_CONNECTED) continue;
+        send_init_commands(board);
+    }
 
-    int bytes_read = recv(board->receive_sock, buffer, sizeof(buffer), 0);
-    process_received_data(bytes_read, buffer, board);
+    struct epoll_event events[MAX_EVENTS];
+    int n = epoll_wait(daemon->epoll_fd, events, MAX_EVENTS, -1);
+    if (n < 0 && errno != EINTR) {
+        perror("Fehler beim Warten auf Ereignisse");
+        daemon->is_running = false;
+        return;
+    }
+    // SIGUSR1 unterbricht epoll_wait(), s + Enter wird spätestens mit dem nächsten Takt bemerkt
+    if (stats_requested) {
+        stats_requested = 0;
+        for (int i = 0; i < daemon->count; i++) print_report_stats(&daemon->boards[i]);
+        print_receive_stats(daemon);
+    }
 
-    usleep(10000);
+    for (int i = 0; i < n; i++) {
+        WiiBalanceBoard* board = events[i].data.ptr;
+        if (board != NULL) {
+            if (board->state == BOARD_CONNECTED) drain_receive_sock(daemon, board);
+            else if (board->state != BOARD_WAITING) continue_reconnect(daemon, board);
+            if (!board->is_running) close_board(daemon, board);
+        } else {
+            uint64_t expirations;
+            if (read(daemon->timer_fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+                perror("Fehler beim Lesen des Timers");
+            // Vom Ausgabethread gestoppte Boards schließen
+            for (int j = 0; j < daemon->count; j++)
+                if (!daemon->boards[j].is_running && (daemon->boards[j].receive_sock >= 0 || daemon->boards[j].control_sock >= 0))
+                    close_board(daemon, &daemon->boards[j]);
+            // Watchdog und fällige Reconnects
+            check_connections(daemon);
+        }
+    }
 }
 
 /**
@@ -111,16 +178,83 @@ void main_loop(WiiBalanceBoard* board) {
  * printf("YOU MAY USE \"%s %s\" FOR IMMEDIATE CONNECTION\n", argv[0], board.mac);
  * @endcode
  *
- * A background thread is started to handle user input. Currently, this 
- * thread only supports program termination commands, allowing the user 
- * to end the main loop. However, in future versions, this thread could 
- * be expanded to accept additional commands, such as status requests 
- * or calibration triggers, by setting corresponding flags in the 
+ * ### Daemon Mode
+ * If more than one MAC address is passed, every address becomes its own board 
+ * and all boards are served by the same event loop. Each output line is then 
+ * prefixed with the index of the board in the argument list (`[0] `, `[1] `, ...).
+ * @code
+ * ./YAWiiBBD 00:23:CC:43:DC:C2 00:23:CC:43:DC:C3
+ * @endcode
+ *
+ * ### Options
+ * - `-o text` (default): text output as selected by `debug_level`.
+ * - `-l raw|decode|debug|verbose`: level of the text output (default `raw`), 
+ *   changeable at runtime with `l <level>` + Enter.
+ * - `-o binary`: compact binary records, see `YAWiiBBbinary.h`.
+ * - `-o shm`: the binary records go into a shared-memory ring that consumers map 
+ *   read-only, see `YAWiiBBshm.h`; stdout only shows the remaining reports as text. The 
+ *   same object holds a seqlock-protected "latest" slot per board with masses, total 
+ *   weight and centre of pressure for displays.
+ * - `-m name`: name of the shared-memory object (default `/yawiibb`).
+ * - `-u path`: additionally serves the reports on a Unix socket to up to 16 
+ *   subscribers, each with its own format and decimation, see `YAWiiBBserver.h`.
+ * - `-t`: text lines start with the reception time of their report (`CLOCK_MONOTONIC`, 
+ *   seconds with microseconds); the binary records always carry it.
+ * - `-r slots`: number of slots of the report ring between receive and output thread 
+ *   (default `RING_DEFAULT_SLOTS`).
+ * - `-d oldest|newest`: which report is dropped when the ring is full (default `oldest`).
+ * - `-c file`: records every received report to a capture file, see `YAWiiBBcapture.h`.
+ * - `-i file`: replays a capture file instead of connecting to boards (no MAC addresses).
+ * - `-f`: replays as fast as possible instead of in real time and prints the throughput.
+ * - `-s dir`: connects to the board simulator (`testing/simBoard.c`) listening in `dir` 
+ *   instead of using Bluetooth; the MAC addresses of the simulated boards are required.
+ * - `-w ms`: watchdog, a board that sends nothing for this time is reconnected 
+ *   (default `WATCHDOG_DEFAULT_MS`, 0 switches it off).
+ * - `-b l2cap|hidraw|evdev`: transport to the boards (default `l2cap`). With `hidraw` 
+ *   the boards are paired and connected by the kernel and opened as `/dev/hidrawN`, 
+ *   with `evdev` the calibrated axes of the `hid-wiimote` driver are read from 
+ *   `/dev/input/eventN`, see `YAWiiBBtransport.h`; without a MAC address the first 
+ *   board found is used.
+ * - `-a off|add|only`: centre of pressure and sway metrics (path length, mean 
+ *   velocity, RMS, 95 % ellipse area) after every data line (`add`) or instead of it 
+ *   (`only`), text output only, see `YAWiiBBsway.h`; the metrics of the whole run 
+ *   are printed with the statistics.
+ * - `-F list`, `-R Hz`: filter and resampling stage after `calc_mass()`. The masses of 
+ *   every calibrated board are resampled to exactly `Hz` samples per second (default 
+ *   `FILTER_DEFAULT_RATE`) and put through a cascade of biquads, e.g. `-F lp:8,notch:25`; 
+ *   all outputs then get the filtered samples instead of the data reports, see 
+ *   `YAWiiBBfilter.h`. `-R` alone only resamples.
+ * - `-W ms,...`: aggregation mode of the text output. Instead of the data lines, one 
+ *   record per board and window with count, minimum, mean, maximum and standard 
+ *   deviation of every sensor and the total, for up to `AGGREGATE_MAX_WINDOWS` window 
+ *   sizes at once (each a multiple of the smallest), see `YAWiiBBaggregate.h`. Not 
+ *   together with `-a`.
+ *
+ * ### Reconnect
+ * A lost connection no longer ends the program: the board is reconnected with 
+ * exponential backoff (`RECONNECT_MIN_MS` to `RECONNECT_MAX_MS`) while the other 
+ * boards and the output continue. Calibration and output stream are kept, only the 
+ * dump is restarted. The initial connect still fails immediately, so a wrong MAC 
+ * address is reported at once. Replays are never reconnected.
+ *
+ * ### Timing Statistics
+ * Every report is stamped on reception, with the kernel timestamp (`SO_TIMESTAMPNS`) 
+ * where the socket supports it. The histograms of the report intervals and of the 
+ * receive-to-stdout delay, the gap and the duplicate counters (`ReportStats`) are 
+ * printed to stderr on exit, on `SIGUSR1` and when `s` + Enter is typed:
+ * @code
+ * kill -USR1 $(pidof YAWiiBBD)
+ * @endcode
+ *
+ * A background thread is started to handle user input. Besides `s` (statistics) 
+ * and `l <level>` (text level), any line ends the main loop. In future versions, 
+ * this thread could be expanded to accept additional commands, such as 
+ * calibration triggers, by setting corresponding flags in the 
  * `WiiBalanceBoard` object.
  * 
- * The main loop operates as long as the `is_running` flag remains set to `true`.
+ * The main loop operates as long as the `is_running` flag of the daemon remains set to `true`.
  * Upon termination, the function performs cleanup by releasing all 
- * resources and closing the Bluetooth connection to the Balance Board.
+ * resources and closing the Bluetooth connections to the Balance Boards.
  *
  * @param argc Number of arguments passed to the program at startup.
  * @param argv Array of strings containing the arguments passed.
@@ -128,36 +262,245 @@ void main_loop(WiiBalanceBoard* board) {
  */
 
 int main(int argc, char *argv[]) {
-    WiiBalanceBoard board = {
+    const WiiBalanceBoard board_defaults = {
         .needStatus = true,
         .needCalibration = true,
         .needActivation = true,
+        .needLed = true,
         .led = false,
         .needDumpStart = true,
-        .is_running = true
+        .is_running = true,
+        .id = -1,
+        .control_sock = -1,
+        .receive_sock = -1,
+        .transport = &l2cap_transport
     };
+    BoardDaemon daemon = { .is_running = true };
 
+    uint32_t ring_slots = RING_DEFAULT_SLOTS;
+    uint32_t watchdog_ms = WATCHDOG_DEFAULT_MS;
+    DropPolicy drop_policy = DROP_OLDEST;
+    const char* capture_path = NULL;
+    const char* replay_path = NULL;
+    bool replay_paced = true;
+    const char* simulator_dir = NULL;
+    const char* shm_name = YAWIIBB_SHM_DEFAULT_NAME;
+    const char* server_path = NULL;
+    FanoutServer server;
+    char adapter[19];
+    ReplaySource replay;
+    const Transport* transport = &l2cap_transport;
+    const char* filter_spec = NULL;
+    uint32_t filter_rate = 0;
 
-    if (is_valid_mac(argc, argv)) strcpy(board.mac,argv[1]);
-    else if(find_wii_balance_board(&board) != 0) strcpy(board.mac, WII_BALANCE_BOARD_ADDR);
+    int opt;
+    while ((opt = getopt(argc, argv, "o:l:m:u:tr:d:c:i:fs:w:b:a:F:R:W:")) != -1) {
+        switch (opt) {
+            case 'o':
+                if (strcmp(optarg, "text") == 0) output_format = OUTPUT_TEXT;
+                else if (strcmp(optarg, "binary") == 0) output_format = OUTPUT_BINARY;
+                else if (strcmp(optarg, "shm") == 0) output_format = OUTPUT_SHM;
+                else { print_usage(argv[0]); exit(1); }
+                break;
+            case 'l': {
+                int level = parse_log_level(optarg);
+                if (level < 0) { print_usage(argv[0]); exit(1); }
+                debug_level = (LogLevel)level;
+                break;
+            }
+            case 'm':
+                shm_name = optarg;
+                break;
+            case 'u':
+                server_path = optarg;
+                break;
+            case 't':
+                text_timestamps = true;
+                break;
+            case 'r':
+                ring_slots = (uint32_t)strtoul(optarg, NULL, 10);
+                if (ring_slots == 0) { print_usage(argv[0]); exit(1); }
+                break;
+            case 'd':
+                if (strcmp(optarg, "oldest") == 0) drop_policy = DROP_OLDEST;
+                else if (strcmp(optarg, "newest") == 0) drop_policy = DROP_NEWEST;
+                else { print_usage(argv[0]); exit(1); }
+                break;
+            case 'c':
+                capture_path = optarg;
+                break;
+            case 'i':
+                replay_path = optarg;
+                break;
+            case 'f':
+                replay_paced = false;
+                break;
+            case 's':
+                simulator_dir = optarg;
+                break;
+            case 'w':
+                watchdog_ms = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'b':
+                transport = find_transport(optarg);
+                if (transport == NULL) { print_usage(argv[0]); exit(1); }
+                break;
+            case 'a':
+                if (strcmp(optarg, "off") == 0) sway_output = SWAY_OFF;
+                else if (strcmp(optarg, "add") == 0) sway_output = SWAY_ADD;
+                else if (strcmp(optarg, "only") == 0) sway_output = SWAY_ONLY;
+                else { print_usage(argv[0]); exit(1); }
+                break;
+            case 'F':
+                filter_spec = optarg;
+                break;
+            case 'R':
+                filter_rate = (uint32_t)strtoul(optarg, NULL, 10);
+                if (filter_rate == 0) { print_usage(argv[0]); exit(1); }
+                break;
+            case 'W':
+                if (aggregate_configure(&aggregate_config, optarg) != 0) { print_usage(argv[0]); exit(1); }
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(1);
+        }
+    }
+    // Die Schwankungszeilen sind Text, im Binärstrom und neben dem Shared Memory hätten sie keinen Platz
+    if (sway_output != SWAY_OFF && output_format != OUTPUT_TEXT) { print_usage(argv[0]); exit(1); }
+    // Die Fenster-Records ersetzen die Datenzeilen, die -a ergänzen würde
+    if (aggregate_config.count != 0 && (output_format != OUTPUT_TEXT || sway_output != SWAY_OFF)) { print_usage(argv[0]); exit(1); }
+    // -R allein tastet nur um, -F allein gibt FILTER_DEFAULT_RATE aus
+    if (filter_spec != NULL || filter_rate != 0) {
+        if (filter_configure(&filter_config, filter_spec, filter_rate ? filter_rate : FILTER_DEFAULT_RATE) != 0) {
+            print_usage(argv[0]);
+            exit(1);
+        }
+        fprintf(stderr, "Filterstufe: %u Hz, Raster %u Hz", filter_config.rate, filter_config.internal_rate);
+        for (int i = 0; i < filter_config.stages; i++) fprintf(stderr, ", %s", filter_config.description[i]);
+        fprintf(stderr, "\n");
+    }
+    // Nach den Optionen folgen die MAC-Adressen
+    int mac_count = argc - optind;
+    char** macs = argv + optind;
+    // Im Binärmodus gehört stdout allein dem Datenstrom
+    FILE* info = (output_format == OUTPUT_BINARY) ? stderr : stdout;
 
-    board.control_sock = connect_l2cap(board.mac, 0x11);
-    board.receive_sock = connect_l2cap(board.mac, 0x13);
+    if (replay_path != NULL) {
+        // Wiedergabe einer Aufzeichnung anstelle echter Boards
+        if (mac_count > 0) { print_usage(argv[0]); exit(1); }
+        if (replay_open(&replay, &daemon, replay_path, replay_paced, &board_defaults) != 0) exit(1);
+    } else if (simulator_dir != NULL && (mac_count == 0 || transport != &l2cap_transport)) {
+        // Der Simulator kann nicht gesucht werden und bietet nur die beiden Kanäle
+        print_usage(argv[0]);
+        exit(1);
+    } else if (mac_count > 1) {
+        // Daemon-Modus: jede übergebene MAC-Adresse wird ein eigenes Board
+        daemon.count = mac_count;
+        daemon.boards = calloc(daemon.count, sizeof(WiiBalanceBoard));
+        for (int i = 0; i < daemon.count; i++) {
+            if (!is_valid_mac_string(macs[i])) exit(1);
+            daemon.boards[i] = board_defaults;
+            daemon.boards[i].id = i;
+            strcpy(daemon.boards[i].mac, macs[i]);
+            daemon.boards[i].transport = transport;
+        }
+    } else {
+        daemon.count = 1;
+        daemon.boards = calloc(1, sizeof(WiiBalanceBoard));
+        daemon.boards[0] = board_defaults;
+        daemon.boards[0].transport = transport;
+        if (mac_count == 1 && is_valid_mac_string(macs[0])) strcpy(daemon.boards[0].mac, macs[0]);
+        // Mit hidraw und evdev wird unter den Boards gesucht, die der Kernel verbunden hat
+        else if (transport == &l2cap_transport && find_wii_balance_board(&daemon.boards[0]) != 0) strcpy(daemon.boards[0].mac, WII_BALANCE_BOARD_ADDR);
+    }
+
+    for (int i = 0; i < daemon.count && replay_path == NULL; i++) {
+        if (simulator_dir != NULL) {
+            daemon.boards[i].control_sock = connect_simulator(simulator_dir, daemon.boards[i].mac, 0x11);
+            daemon.boards[i].receive_sock = connect_simulator(simulator_dir, daemon.boards[i].mac, 0x13);
+        } else if (transport == &hidraw_transport) {
+            if (hidraw_open(&daemon.boards[i]) != 0) exit(1);
+        } else if (transport == &evdev_transport) {
+            // Der Kernel kalibriert selbst, kein Cache
+            if (evdev_open(&daemon.boards[i]) != 0) exit(1);
+            continue;
+        } else {
+            // Die Suche über den Cache hat den Kontrollkanal eventuell schon geöffnet
+            if (daemon.boards[i].control_sock < 0) daemon.boards[i].control_sock = connect_l2cap(daemon.boards[i].mac, 0x11);
+            daemon.boards[i].receive_sock = connect_l2cap(daemon.boards[i].mac, 0x13);
+            default_adapter_address(adapter);
+            remember_board(daemon.boards[i].mac, adapter);
+        }
+        // Gespeicherte Kalibrierung sofort verwenden, die Abfrage frischt sie im Hintergrund auf
+        daemon.boards[i].persist_calibration = true;
+        if (load_calibration(&daemon.boards[i]) == 0)
+            fprintf(stderr, "Kalibrierung von %s aus dem Cache geladen\n", daemon.boards[i].mac);
+    }
+    // Ausgabe je Board einmal festlegen, "l <Level>" stellt sie später im Ausgabethread um
+    for (int i = 0; i < daemon.count; i++) set_log_level(&daemon.boards[i], debug_level);
+    // Aufzeichnungen enden mit der Datei, dort gibt es nichts neu zu verbinden
+    daemon.reconnect = (replay_path == NULL);
+    daemon.watchdog_ms = (replay_path == NULL) ? watchdog_ms : 0;
+    daemon.simulator_dir = simulator_dir;
+    if (setup_event_loop(&daemon) != 0) exit(1);
+    if (output_format == OUTPUT_BINARY) write_binary_header(daemon.count);
+    if (output_format == OUTPUT_SHM) {
+        if (shm_ring_open(&shm_output, shm_name, YAWIIBB_SHM_DEFAULT_RECORDS, (uint32_t)daemon.count) != 0) exit(1);
+        for (int i = 0; i < daemon.count; i++) shm_ring_set_mac(&shm_output, (uint32_t)i, daemon.boards[i].mac);
+        fprintf(stderr, "Shared-Memory-Ring %s: %u Records\n", shm_output.name, shm_output.mask + 1);
+    }
+    if (server_path != NULL) {
+        if (server_open(&server, server_path, daemon.count) != 0) exit(1);
+        daemon.server = &server;
+    }
+    if (capture_path != NULL && (daemon.capture = capture_open(capture_path, &daemon)) == NULL) exit(1);
+
+    // SIGUSR1 soll nur den Hauptthread in epoll_wait() unterbrechen, die anderen Threads erben die Maske
+    sigset_t usr1, previous;
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &usr1, &previous);
+
+    // Ausgabethread, der die Reports aus dem Ring dekodiert und schreibt
+    pthread_t outputThreadId;
+    createOutputThread(&daemon, ring_slots, drop_policy, &outputThreadId);
 
     // Thread erstellen, der im Hintergrund läuft
     pthread_t threadId;
-    createThread(&board, &threadId);
+    createThread(&daemon, &threadId);
+    if (replay_path != NULL) replay_start(&replay);
+
+    struct sigaction action = { .sa_handler = request_stats };
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, NULL);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
 
     // Hauptschleife, die so lange läuft, wie is_running true ist
-    while (board.is_running) {
-        main_loop(&board);
+    daemon.loop_cpu_ns = thread_cpu_ns();
+    while (daemon.is_running) {
+        main_loop(&daemon);
     }
+    print_receive_stats(&daemon);
 
     // Ressourcen aufräumen
+    stopOutputThread(&daemon, outputThreadId);
+    shm_ring_close(&shm_output);
+    if (daemon.server != NULL) server_close(daemon.server);
+    // Der Eingabethread wartet eventuell noch auf Enter (Power-Taste, Ende der Wiedergabe)
+    pthread_cancel(threadId);
     pthread_join(threadId, NULL);
-    close(board.control_sock);
-    close(board.receive_sock);
-    printf("\n");
-    printf("YOU MAY USE \"%s %s\" FOR IMMEDIATE CONNECTION\n",argv[0], board.mac);
+    if (daemon.capture != NULL) fclose(daemon.capture);
+    for (int i = 0; i < daemon.count; i++) close_board(&daemon, &daemon.boards[i]);
+    close(daemon.timer_fd);
+    close(daemon.epoll_fd);
+    fflush(stdout);
+    fprintf(info, "\n");
+    for (int i = 0; i < daemon.count; i++) print_report_stats(&daemon.boards[i]);
+    if (replay_path != NULL) replay_finish(&replay, &daemon);
+    fprintf(info, "YOU MAY USE \"%s", argv[0]);
+    for (int i = 0; i < daemon.count; i++) fprintf(info, " %s", daemon.boards[i].mac);
+    fprintf(info, "\" FOR IMMEDIATE CONNECTION\n");
+    free(daemon.boards);
     return 0;
 }
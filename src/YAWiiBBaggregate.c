@@ -0,0 +1,156 @@
+#include "YAWiiBBaggregate.h"
+#include "YAWiiBBwriter.h"
+#include <math.h>
+#include <stdlib.h>
+/**
+ * @file YAWiiBBaggregate.c
+ * @brief Core file for the windowed aggregation predefined in YAWiiBBaggregate.h.
+ */
+
+AggregateConfig aggregate_config;
+
+
+static int compare_sizes(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+int aggregate_configure(AggregateConfig* config, const char* spec) {
+    config->count = 0;
+    const char* p = spec;
+    while (*p != '\0') {
+        char* end;
+        unsigned long size = strtoul(p, &end, 10);
+        if (end == p || (*end != ',' && *end != '\0') || size < 1 || size > AGGREGATE_MAX_MS) {
+            fprintf(stderr, "Fehler: Fenstergröße \"%s\", erwartet 1 bis %u ms\n", p, AGGREGATE_MAX_MS);
+            return -1;
+        }
+        if (config->count == AGGREGATE_MAX_WINDOWS) {
+            fprintf(stderr, "Fehler: höchstens %d Fenstergrößen\n", AGGREGATE_MAX_WINDOWS);
+            return -1;
+        }
+        config->size_ms[config->count++] = (uint32_t)size;
+        p = *end == ',' ? end + 1 : end;
+    }
+    if (config->count == 0) {
+        fprintf(stderr, "Fehler: keine Fenstergröße angegeben\n");
+        return -1;
+    }
+    qsort(config->size_ms, (size_t)config->count, sizeof(config->size_ms[0]), compare_sizes);
+    // Nur dann liegt jedes kleinste Fenster ganz in einem Fenster jeder größeren Größe
+    for (int i = 1; i < config->count; i++) {
+        if (config->size_ms[i] == config->size_ms[i - 1] || config->size_ms[i] % config->size_ms[0] != 0) {
+            fprintf(stderr, "Fehler: Fenster von %u ms ist doppelt oder kein Vielfaches von %u ms\n",
+                    config->size_ms[i], config->size_ms[0]);
+            config->count = 0;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static inline uint64_t size_ns(const AggregateConfig* config, int index) {
+    return config->size_ms[index] * 1000000ull;
+}
+
+int aggregate_due(const AggregateConfig* config, const AggregateState* state, uint64_t now) {
+    for (int i = 0; i < config->count; i++) {
+        const AggregateWindow* window = &state->window[i];
+        if (window->count > 0 && now >= window->start_ns + size_ns(config, i)) return i;
+    }
+    return -1;
+}
+
+uint64_t aggregate_next_end(const AggregateConfig* config, const AggregateState* state) {
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < config->count; i++) {
+        const AggregateWindow* window = &state->window[i];
+        if (window->count > 0 && window->start_ns + size_ns(config, i) < next) next = window->start_ns + size_ns(config, i);
+    }
+    return next;
+}
+
+// Chan et al.: Mittelwert und Abweichungsquadrate zweier Teilmengen zusammenführen
+static void merge_window(AggregateWindow* target, const AggregateWindow* source, uint64_t target_size_ns) {
+    if (target->count == 0) {
+        *target = *source;
+        target->start_ns = source->start_ns - source->start_ns % target_size_ns;
+        return;
+    }
+    double n_a = (double)target->count, n_b = (double)source->count, n = n_a + n_b;
+    for (int v = 0; v < AGGREGATE_VALUES; v++) {
+        double delta = source->mean[v] - target->mean[v];
+        target->mean[v] += delta * n_b / n;
+        target->m2[v] += source->m2[v] + delta * delta * n_a * n_b / n;
+        if (source->min[v] < target->min[v]) target->min[v] = source->min[v];
+        if (source->max[v] > target->max[v]) target->max[v] = source->max[v];
+    }
+    target->count += source->count;
+}
+
+void aggregate_close(const AggregateConfig* config, AggregateState* state, int index) {
+    // Die größeren Fenster bekommen ihre Werte nur über das kleinste, nie untereinander
+    if (index == 0)
+        for (int i = 1; i < config->count; i++) merge_window(&state->window[i], &state->window[0], size_ns(config, i));
+    uint64_t end = state->window[index].start_ns + size_ns(config, index);
+    if (end > state->closed_ns) state->closed_ns = end;
+    state->window[index].count = 0;
+    state->records++;
+}
+
+void aggregate_add(const AggregateConfig* config, AggregateState* state, const uint32_t mass[4], uint64_t received_ns) {
+    AggregateWindow* window = &state->window[0];
+    uint32_t value[AGGREGATE_VALUES] = { mass[0], mass[1], mass[2], mass[3], mass[0] + mass[1] + mass[2] + mass[3] };
+    state->samples++;
+    // Nach dem Ende eines schon ausgegebenen Fensters empfangen, sonst gäbe es sein Record zweimal
+    if (received_ns < state->closed_ns) {
+        received_ns = state->closed_ns;
+        state->late++;
+    }
+    if (window->count == 0) {
+        window->start_ns = received_ns - received_ns % size_ns(config, 0);
+        for (int v = 0; v < AGGREGATE_VALUES; v++) {
+            window->min[v] = window->max[v] = value[v];
+            window->mean[v] = window->m2[v] = 0;
+        }
+    }
+    // Welford: Mittelwert und Abweichungsquadrate in einem Durchgang
+    window->count++;
+    for (int v = 0; v < AGGREGATE_VALUES; v++) {
+        if (value[v] < window->min[v]) window->min[v] = value[v];
+        if (value[v] > window->max[v]) window->max[v] = value[v];
+        double delta = value[v] - window->mean[v];
+        window->mean[v] += delta / window->count;
+        window->m2[v] += delta * (value[v] - window->mean[v]);
+    }
+}
+
+static const char* const value_labels[AGGREGATE_VALUES] = { " TR ", " BR ", " TL ", " BL ", " Summe " };
+
+char* aggregate_format(const AggregateWindow* window, uint32_t size_ms, char* out) {
+    out = format_u64(out, window->start_ns / 1000000000ull);
+    *out++ = '.';
+    out = format_u64_padded(out, window->start_ns % 1000000000ull / 1000000, 3);
+    *out++ = ' ';
+    out = format_u32(out, size_ms);
+    out = format_text(out, " ms ");
+    out = format_u64(out, window->count);
+    out = format_text(out, " Werte");
+    for (int v = 0; v < AGGREGATE_VALUES; v++) {
+        out = format_text(out, value_labels[v]);
+        out = format_u32(out, window->min[v]);
+        *out++ = ' ';
+        out = format_tenths(out, window->mean[v]);
+        *out++ = ' ';
+        out = format_u32(out, window->max[v]);
+        *out++ = ' ';
+        out = format_tenths(out, sqrt(window->m2[v] / window->count));
+    }
+    *out++ = '\n';
+    return out;
+}
+
+void aggregate_print(const AggregateState* state, const char* prefix, FILE* out) {
+    fprintf(out, "%sAggregation: %llu Werte in %llu Fenster-Records, %llu verspätet\n", prefix,
+            (unsigned long long)state->samples, (unsigned long long)state->records, (unsigned long long)state->late);
+}
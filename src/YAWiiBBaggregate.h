@@ -0,0 +1,151 @@
+#ifndef YAWIIBBAGGREGATE_H
+#define YAWIIBBAGGREGATE_H
+
+/**
+ * @file YAWiiBBaggregate.h
+ * @brief Windowed aggregation of the masses, one text record per window (`-W`).
+ *
+ * Many consumers only log trends: they read every data line at 100 Hz per board and
+ * throw most of it away. With `-W 1000,10000,60000` the text output instead
+ * accumulates the masses of every calibrated board in fixed time windows and writes one
+ * record per window and board. The record holds the count and, for each of the four
+ * sensors and their total, the minimum, mean, maximum and standard deviation in gram
+ * (population, from the variance kept with Welford's method):
+ * @code
+ * [0] 6781.000 1000 ms 100 Werte TR 12345 12400.2 12500 21.3 BR ... TL ... BL ... Summe 49380 49600.8 50000 40.1
+ * @endcode
+ * The time is the start of the window in seconds of `CLOCK_MONOTONIC`. Windows are
+ * aligned to multiples of their size, so the windows of all boards close at the same
+ * instants; a window is written with the first sample after its end and only if it
+ * holds samples. The output thread also wakes up `AGGREGATE_IDLE_DELAY_MS` after the
+ * end of the next open window, so a board nobody stands on or one that was lost
+ * still gets its last record in time; the open windows are written on exit. A
+ * sample that arrives after its window was closed this way counts into the next one
+ * (`late`). All other reports are printed as before. Text
+ * subscribers of the fan-out server get the same records as stdout.
+ *
+ * Several window sizes are computed in one pass: a sample only updates the smallest
+ * window. Every size must be a multiple of the smallest, so each small window lies
+ * inside one window of every larger size; when it closes it is merged into them with
+ * the parallel form of Welford's update (Chan et al.), which is exact. The work per
+ * sample therefore does not grow with the number of sizes, and the state of a board
+ * has a fixed size.
+ *
+ * @code
+ * int i;
+ * while ((i = aggregate_due(&aggregate_config, &board->aggregate, received_ns)) >= 0) {
+ *     print(&board->aggregate.window[i]);
+ *     aggregate_close(&aggregate_config, &board->aggregate, i);
+ * }
+ * aggregate_add(&aggregate_config, &board->aggregate, mass, received_ns);
+ * @endcode
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define AGGREGATE_MAX_WINDOWS 8           /**< Window sizes at the same time */
+#define AGGREGATE_MAX_MS 86400000u        /**< Largest window, one day */
+#define AGGREGATE_VALUES 5                /**< TR, BR, TL, BL and the total */
+#define AGGREGATE_LINE_MAX 384            /**< Longest line of `aggregate_format()` */
+#define AGGREGATE_IDLE_DELAY_MS 250       /**< Without a new sample a window is closed this long after its end */
+
+/**
+ * @struct AggregateConfig
+ * @brief Window sizes shared by all boards, set up once from `-W`.
+ */
+typedef struct {
+    int count;                      /**< Number of sizes, 0 = aggregation off */
+    uint32_t size_ms[AGGREGATE_MAX_WINDOWS]; /**< Sizes in ascending order */
+} AggregateConfig;
+
+extern AggregateConfig aggregate_config;   /**< Selected with `-W` */
+
+/**
+ * @struct AggregateWindow
+ * @brief Running statistics of one open window.
+ */
+typedef struct {
+    uint64_t start_ns;              /**< Start of the window (multiple of its size) */
+    uint64_t count;                 /**< Samples, 0 = empty */
+    uint32_t min[AGGREGATE_VALUES];  /**< Smallest masses in gram */
+    uint32_t max[AGGREGATE_VALUES];  /**< Largest masses in gram */
+    double mean[AGGREGATE_VALUES];   /**< Mean (Welford) */
+    double m2[AGGREGATE_VALUES];     /**< Sum of squared deviations from the mean */
+} AggregateWindow;
+
+/**
+ * @struct AggregateState
+ * @brief Open windows of one board, one per size.
+ */
+typedef struct {
+    AggregateWindow window[AGGREGATE_MAX_WINDOWS]; /**< Same order as `AggregateConfig.size_ms` */
+    uint64_t samples;               /**< Samples added */
+    uint64_t records;               /**< Windows closed with samples */
+    uint64_t closed_ns;             /**< Latest end of a closed window */
+    uint64_t late;                  /**< Samples older than `closed_ns`, counted at `closed_ns` */
+} AggregateState;
+
+/**
+ * @brief Sets up the window sizes from a list.
+ *
+ * @param config Configuration to fill.
+ * @param spec   Comma-separated sizes in ms, e.g. `"1000,10000,60000"`; every size a
+ *               multiple of the smallest, at most `AGGREGATE_MAX_WINDOWS` of them.
+ * @return 0 on success, -1 for an invalid list (message printed).
+ */
+int aggregate_configure(AggregateConfig* config, const char* spec);
+
+/**
+ * @brief Returns a window that ends at or before @p now and holds samples.
+ *
+ * Smaller windows come first, so a window is only returned once all of its
+ * samples have been merged into it. `UINT64_MAX` returns every non-empty window (exit).
+ *
+ * @return Index into `AggregateState.window`, or -1 if none is due.
+ */
+int aggregate_due(const AggregateConfig* config, const AggregateState* state, uint64_t now);
+
+/**
+ * @brief Returns the end of the open window that ends first.
+ *
+ * @return `CLOCK_MONOTONIC` in ns, or `UINT64_MAX` if all windows are empty.
+ */
+uint64_t aggregate_next_end(const AggregateConfig* config, const AggregateState* state);
+
+/**
+ * @brief Merges a window into the larger ones and empties it.
+ */
+void aggregate_close(const AggregateConfig* config, AggregateState* state, int index);
+
+/**
+ * @brief Adds one sample to the smallest window.
+ *
+ * All due windows must have been closed before (`aggregate_due()`). A sample older
+ * than the end of a closed window is counted as if received at that end.
+ *
+ * @param config      Configured sizes.
+ * @param state       State of the board.
+ * @param mass        Masses TR, BR, TL, BL in gram.
+ * @param received_ns Reception of the sample (`CLOCK_MONOTONIC`).
+ */
+void aggregate_add(const AggregateConfig* config, AggregateState* state, const uint32_t mass[4], uint64_t received_ns);
+
+/**
+ * @brief Formats the record of a window (without board tag), returns the end.
+ *
+ * Needs at most `AGGREGATE_LINE_MAX` bytes.
+ */
+char* aggregate_format(const AggregateWindow* window, uint32_t size_ms, char* out);
+
+/**
+ * @brief Prints the counters of a board.
+ *
+ * @param state  State of the board.
+ * @param prefix Board tag (`"[0] "` or empty).
+ * @param out    Target stream (stderr).
+ */
+void aggregate_print(const AggregateState* state, const char* prefix, FILE* out);
+
+#endif // YAWIIBBAGGREGATE_H
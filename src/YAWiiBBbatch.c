@@ -0,0 +1,219 @@
+#include "YAWiiBBbatch.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define YAWIIBB_X86
+#endif
+/**
+ * @file YAWiiBBbatch.c
+ * @brief Core file for the batch kernels predefined in YAWiiBBbatch.h.
+ */
+
+
+typedef void (*decode_kernel)(const unsigned char* reports, size_t stride, size_t n, SampleBlock* block);
+typedef void (*mass_kernel)(const MassCoefficients* c, int pos, const uint16_t* raw, uint32_t* mass, size_t n);
+
+static pthread_once_t kernel_once = PTHREAD_ONCE_INIT;
+static decode_kernel decode_impl;
+static mass_kernel mass_impl;
+static const char* kernel_name = "scalar";
+
+// Bytes 4-11 einer Probe als 64-Bit-Wert (unaligned)
+static inline uint64_t load_sensor_bytes(const unsigned char* report) {
+    uint64_t value;
+    memcpy(&value, report + 4, sizeof(value));
+    return value;
+}
+
+/* ---------- Skalar ---------- */
+
+static void decode_scalar(const unsigned char* reports, size_t stride, size_t n, SampleBlock* block) {
+    for (size_t i = 0; i < n; i++) {
+        const unsigned char* r = reports + i * stride;
+        for (int s = 0; s < 4; s++) block->raw[s][i] = (uint16_t)((r[4 + 2 * s] << 8) | r[5 + 2 * s]);
+    }
+}
+
+static void mass_scalar(const MassCoefficients* c, int pos, const uint16_t* raw, uint32_t* mass, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int seg = (raw[i] >= c->upper[pos][0]) + (raw[i] >= c->upper[pos][1]);
+        int32_t delta = (int32_t)raw[i] - c->base[pos][seg];
+        delta &= ~(delta >> 31);
+        mass[i] = c->offset[pos][seg] + (uint32_t)(((uint64_t)delta * c->slope[pos][seg]) >> 32);
+    }
+}
+
+#ifdef YAWIIBB_X86
+/*
+ * Byte-Shuffle für zwei Proben in einem 128-Bit-Lane:
+ * Eingang  [TRh TRl BRh BRl TLh TLl BLh BLl] (Probe 0) [..] (Probe 1)
+ * Ausgang  TR0 TR1 | BR0 BR1 | TL0 TL1 | BL0 BL1 als Little-Endian uint16
+ */
+#define SWAP_TRANSPOSE_MASK 1, 0, 9, 8, 3, 2, 11, 10, 5, 4, 13, 12, 7, 6, 15, 14
+
+/* ---------- SSE4.1 ---------- */
+
+__attribute__((target("sse4.1")))
+static void decode_sse41(const unsigned char* reports, size_t stride, size_t n, SampleBlock* block) {
+    const __m128i shuffle = _mm_setr_epi8(SWAP_TRANSPOSE_MASK);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const unsigned char* r = reports + i * stride;
+        __m128i v = _mm_set_epi64x((long long)load_sensor_bytes(r + stride), (long long)load_sensor_bytes(r));
+        v = _mm_shuffle_epi8(v, shuffle);
+        for (int s = 0; s < 4; s++) {
+            uint32_t pair = (uint32_t)_mm_extract_epi32(v, 0);
+            memcpy(&block->raw[s][i], &pair, sizeof(pair));
+            v = _mm_srli_si128(v, 4);
+        }
+    }
+    decode_scalar(reports + i * stride, stride, n - i, &(SampleBlock){ .raw = {
+        block->raw[0] + i, block->raw[1] + i, block->raw[2] + i, block->raw[3] + i } });
+}
+
+__attribute__((target("sse4.1")))
+static void mass_sse41(const MassCoefficients* c, int pos, const uint16_t* raw, uint32_t* mass, size_t n) {
+    const __m128i up0 = _mm_set1_epi32((int)c->upper[pos][0] - 1);
+    const __m128i up1 = _mm_set1_epi32((int)c->upper[pos][1] - 1);
+    __m128i base[3], off[3], slo[3], shi[3];
+    for (int seg = 0; seg < 3; seg++) {
+        base[seg] = _mm_set1_epi32(c->base[pos][seg]);
+        off[seg] = _mm_set1_epi32((int)c->offset[pos][seg]);
+        slo[seg] = _mm_set1_epi32((int)(uint32_t)c->slope[pos][seg]);
+        shi[seg] = _mm_set1_epi32((int)(uint32_t)(c->slope[pos][seg] >> 32));
+    }
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i r = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(raw + i)));
+        __m128i m1 = _mm_cmpgt_epi32(r, up0);
+        __m128i m2 = _mm_cmpgt_epi32(r, up1);
+        __m128i b = _mm_blendv_epi8(_mm_blendv_epi8(base[0], base[1], m1), base[2], m2);
+        __m128i o = _mm_blendv_epi8(_mm_blendv_epi8(off[0], off[1], m1), off[2], m2);
+        __m128i lo = _mm_blendv_epi8(_mm_blendv_epi8(slo[0], slo[1], m1), slo[2], m2);
+        __m128i hi = _mm_blendv_epi8(_mm_blendv_epi8(shi[0], shi[1], m1), shi[2], m2);
+        __m128i delta = _mm_max_epi32(_mm_sub_epi32(r, b), _mm_setzero_si128());
+        // (delta * slope) >> 32 = delta * hi + ((delta * lo) >> 32)
+        __m128i even = _mm_srli_epi64(_mm_mul_epu32(delta, lo), 32);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(delta, 32), _mm_srli_epi64(lo, 32));
+        __m128i frac = _mm_blend_epi16(even, odd, 0xCC);
+        __m128i m = _mm_add_epi32(_mm_add_epi32(o, _mm_mullo_epi32(delta, hi)), frac);
+        _mm_storeu_si128((__m128i*)(mass + i), m);
+    }
+    mass_scalar(c, pos, raw + i, mass + i, n - i);
+}
+
+/* ---------- AVX2 ---------- */
+
+__attribute__((target("avx2")))
+static void decode_avx2(const unsigned char* reports, size_t stride, size_t n, SampleBlock* block) {
+    const __m256i shuffle = _mm256_setr_epi8(SWAP_TRANSPOSE_MASK, SWAP_TRANSPOSE_MASK);
+    // Lane 0 enthält Proben 0/1, Lane 1 Proben 2/3: Paare je Sensor zusammenführen
+    const __m256i gather = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const unsigned char* r = reports + i * stride;
+        __m256i v = _mm256_set_epi64x((long long)load_sensor_bytes(r + 3 * stride), (long long)load_sensor_bytes(r + 2 * stride),
+                                      (long long)load_sensor_bytes(r + stride), (long long)load_sensor_bytes(r));
+        v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, shuffle), gather);
+        uint64_t quads[4];
+        _mm256_storeu_si256((__m256i*)quads, v);
+        for (int s = 0; s < 4; s++) memcpy(&block->raw[s][i], &quads[s], sizeof(quads[s]));
+    }
+    decode_scalar(reports + i * stride, stride, n - i, &(SampleBlock){ .raw = {
+        block->raw[0] + i, block->raw[1] + i, block->raw[2] + i, block->raw[3] + i } });
+}
+
+__attribute__((target("avx2")))
+static void mass_avx2(const MassCoefficients* c, int pos, const uint16_t* raw, uint32_t* mass, size_t n) {
+    const __m256i up0 = _mm256_set1_epi32((int)c->upper[pos][0] - 1);
+    const __m256i up1 = _mm256_set1_epi32((int)c->upper[pos][1] - 1);
+    // Koeffizienten der drei Segmente als Tabellen, die per Segmentindex permutiert werden
+    const __m256i base = _mm256_setr_epi32(c->base[pos][0], c->base[pos][1], c->base[pos][2], 0, 0, 0, 0, 0);
+    const __m256i off = _mm256_setr_epi32((int)c->offset[pos][0], (int)c->offset[pos][1], (int)c->offset[pos][2], 0, 0, 0, 0, 0);
+    const __m256i slo = _mm256_setr_epi32((int)(uint32_t)c->slope[pos][0], (int)(uint32_t)c->slope[pos][1],
+                                          (int)(uint32_t)c->slope[pos][2], 0, 0, 0, 0, 0);
+    const __m256i shi = _mm256_setr_epi32((int)(c->slope[pos][0] >> 32), (int)(c->slope[pos][1] >> 32),
+                                          (int)(c->slope[pos][2] >> 32), 0, 0, 0, 0, 0);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i r = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(raw + i)));
+        // Vergleichsmasken sind -1/0: Segment = -(m1 + m2)
+        __m256i seg = _mm256_sub_epi32(_mm256_setzero_si256(),
+                                       _mm256_add_epi32(_mm256_cmpgt_epi32(r, up0), _mm256_cmpgt_epi32(r, up1)));
+        __m256i b = _mm256_permutevar8x32_epi32(base, seg);
+        __m256i o = _mm256_permutevar8x32_epi32(off, seg);
+        __m256i lo = _mm256_permutevar8x32_epi32(slo, seg);
+        __m256i hi = _mm256_permutevar8x32_epi32(shi, seg);
+        __m256i delta = _mm256_max_epi32(_mm256_sub_epi32(r, b), _mm256_setzero_si256());
+        // (delta * slope) >> 32 = delta * hi + ((delta * lo) >> 32)
+        __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(delta, lo), 32);
+        __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(delta, 32), _mm256_srli_epi64(lo, 32));
+        __m256i frac = _mm256_blend_epi32(even, odd, 0xAA);
+        __m256i m = _mm256_add_epi32(_mm256_add_epi32(o, _mm256_mullo_epi32(delta, hi)), frac);
+        _mm256_storeu_si256((__m256i*)(mass + i), m);
+    }
+    mass_scalar(c, pos, raw + i, mass + i, n - i);
+}
+#endif // YAWIIBB_X86
+
+static void select_kernel(void) {
+    decode_impl = decode_scalar;
+    mass_impl = mass_scalar;
+    #ifdef YAWIIBB_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        decode_impl = decode_avx2;
+        mass_impl = mass_avx2;
+        kernel_name = "avx2";
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        decode_impl = decode_sse41;
+        mass_impl = mass_sse41;
+        kernel_name = "sse4.1";
+    }
+    #endif // YAWIIBB_X86
+}
+
+int sample_block_init(SampleBlock* block, size_t capacity) {
+    memset(block, 0, sizeof(*block));
+    // Auf 32 Byte ausgerichtet, auf volle 32 Byte aufgerundet (aligned_alloc verlangt Vielfache)
+    size_t raw_bytes = (capacity * sizeof(uint16_t) + 31) & ~(size_t)31;
+    size_t mass_bytes = (capacity * sizeof(uint32_t) + 31) & ~(size_t)31;
+    for (int s = 0; s < 4; s++) {
+        block->raw[s] = aligned_alloc(32, raw_bytes ? raw_bytes : 32);
+        block->mass[s] = aligned_alloc(32, mass_bytes ? mass_bytes : 32);
+        if (block->raw[s] == NULL || block->mass[s] == NULL) {
+            sample_block_free(block);
+            return -1;
+        }
+    }
+    block->capacity = capacity;
+    pthread_once(&kernel_once, select_kernel);
+    return 0;
+}
+
+void sample_block_free(SampleBlock* block) {
+    for (int s = 0; s < 4; s++) {
+        free(block->raw[s]);
+        free(block->mass[s]);
+        block->raw[s] = NULL;
+        block->mass[s] = NULL;
+    }
+    block->capacity = block->count = 0;
+}
+
+size_t decode_reports_batch(const unsigned char* reports, size_t stride, size_t n, SampleBlock* block) {
+    if (n > block->capacity) n = block->capacity;
+    decode_impl(reports, stride, n, block);
+    block->count = n;
+    return n;
+}
+
+void calibrate_block(const WiiBalanceBoard* board, SampleBlock* block) {
+    for (int s = 0; s < 4; s++) mass_impl(&board->coefficients, s, block->raw[s], block->mass[s], block->count);
+}
+
+const char* batch_kernel_name(void) {
+    pthread_once(&kernel_once, select_kernel);
+    return kernel_name;
+}
@@ -0,0 +1,96 @@
+#ifndef YAWIIBBBATCH_H
+#define YAWIIBBBATCH_H
+
+/**
+ * @file YAWiiBBbatch.h
+ * @brief Batched decoding and calibration of many 0x32 reports at once.
+ *
+ * `process_received_data()` handles one report at a time, which is right for the
+ * live stream. For re-processing recorded sessions or for ingesting many boards,
+ * this module converts a whole array of reports into a structure-of-arrays block:
+ * four contiguous arrays of raw values (TR, BR, TL, BL) and four of masses in gram.
+ *
+ * The work is split into two passes:
+ * 1. **Decode**: the big-endian sensor bytes 4-11 of every report are byte-swapped
+ *    and transposed into the four raw arrays.
+ * 2. **Calibrate**: per sensor, the segment of every sample is selected with
+ *    vector compares and the mass is computed with the integer coefficients of
+ *    `MassCoefficients` (same exact result as `calc_mass()`).
+ *
+ * Both passes have an AVX2, an SSE4.1 and a scalar implementation. The fastest
+ * one supported by the CPU is selected once at runtime (see `batch_kernel_name()`).
+ *
+ * The output thread of the daemon takes up to `OUTPUT_BATCH` slots out of the ring 
+ * and runs the kernel over every run of at least `OUTPUT_BATCH_MIN` data reports of 
+ * one board (stride `sizeof(ReportSlot)`); the results go into `ReportView.data.mass`.
+ *
+ * @code
+ * SampleBlock block;
+ * sample_block_init(&block, n);
+ * decode_reports_batch(reports, BUFFER_SIZE, n, &block);
+ * calibrate_block(board, &block);
+ * // block.raw[0][i], block.mass[3][i], ...
+ * sample_block_free(&block);
+ * @endcode
+ */
+
+#include "YAWiiBBessentials.h"
+
+/**
+ * @struct SampleBlock
+ * @brief Structure-of-arrays output of the batch kernel.
+ *
+ * The arrays are 32 byte aligned and hold `capacity` entries each.
+ */
+typedef struct {
+    size_t capacity;                /**< Number of samples the arrays can hold */
+    size_t count;                   /**< Number of valid samples */
+    uint16_t* raw[4];               /**< Raw sensor values TR, BR, TL, BL */
+    uint32_t* mass[4];              /**< Masses in gram TR, BR, TL, BL */
+} SampleBlock;
+
+/**
+ * @brief Allocates the arrays of a block.
+ *
+ * @param block    Block to initialise.
+ * @param capacity Maximum number of samples.
+ * @return 0 on success, -1 if the memory could not be allocated.
+ */
+int sample_block_init(SampleBlock* block, size_t capacity);
+
+/**
+ * @brief Releases the arrays of a block.
+ */
+void sample_block_free(SampleBlock* block);
+
+/**
+ * @brief Decodes the raw sensor values of @p n reports into @p block.
+ *
+ * Every report must be a 0x32 report of at least 12 bytes; the reports are
+ * located @p stride bytes apart (e.g. `BUFFER_SIZE` for an array of buffers or
+ * `sizeof(ReportSlot)` offsets for ring slots). At most `capacity` reports are decoded.
+ *
+ * @param reports Pointer to the first report.
+ * @param stride  Distance between two reports in bytes.
+ * @param n       Number of reports.
+ * @param block   Receives the raw values, `count` is set.
+ * @return Number of decoded reports.
+ */
+size_t decode_reports_batch(const unsigned char* reports, size_t stride, size_t n, SampleBlock* block);
+
+/**
+ * @brief Calculates the masses of all samples in @p block.
+ *
+ * Uses the coefficients of `board` like `calc_mass()` and gives bit-identical results.
+ *
+ * @param board Board with precomputed `MassCoefficients`.
+ * @param block Block filled by `decode_reports_batch()`.
+ */
+void calibrate_block(const WiiBalanceBoard* board, SampleBlock* block);
+
+/**
+ * @brief Returns the name of the selected kernel (`"avx2"`, `"sse4.1"` or `"scalar"`).
+ */
+const char* batch_kernel_name(void);
+
+#endif // YAWIIBBBATCH_H
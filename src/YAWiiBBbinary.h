@@ -0,0 +1,158 @@
+#ifndef YAWIIBBBINARY_H
+#define YAWIIBBBINARY_H
+
+/**
+ * @file YAWiiBBbinary.h
+ * @brief Layout of the compact binary output format (`-o binary`).
+ *
+ * Instead of one hex dump line per report, the binary output mode writes one
+ * fixed-size little-endian record per data report to stdout. The stream starts
+ * with a single header that carries a magic, the format version and the record
+ * size, so a reader can reject streams it does not understand.
+ *
+ * Later versions only append fields to the end of a record and raise `record_size`;
+ * the fields below keep their offsets. A reader therefore accepts any version from
+ * `YAWIIBB_BINARY_VERSION` on, steps through the stream by `record_size` and ignores
+ * the bytes it does not know.
+ *
+ * This header only depends on the C standard library, so readers (see
+ * `testing/readBinary.c`) can include it without the Bluetooth headers.
+ *
+ * ## Stream Layout
+ * | Offset | Size | Field         | Description                                   |
+ * |--------|------|---------------|-----------------------------------------------|
+ * | 0      | 4    | magic         | `"YWBB"`                                      |
+ * | 4      | 2    | version       | `YAWIIBB_BINARY_VERSION`                      |
+ * | 6      | 2    | record_size   | `YAWIIBB_BINARY_RECORD_SIZE`                  |
+ * | 8      | 4    | board_count   | Number of boards served by the process        |
+ *
+ * followed by records of `record_size` bytes each:
+ *
+ * | Offset | Size | Field         | Description                                   |
+ * |--------|------|---------------|-----------------------------------------------|
+ * | 0      | 8    | timestamp_ns  | `CLOCK_MONOTONIC` at reception, nanoseconds   |
+ * | 8      | 2    | board_id      | Index of the board (0 for a single board)     |
+ * | 10     | 1    | report_type   | Report ID, e.g. `0x32`                        |
+ * | 11     | 1    | flags         | `BINARY_FLAG_*`                               |
+ * | 12     | 8    | raw[4]        | Raw sensor values TR, BR, TL, BL              |
+ * | 20     | 16   | mass[4]       | Masses in gram TR, BR, TL, BL                 |
+ *
+ * All fields are little-endian. `mass` is only meaningful if `BINARY_FLAG_MASS_VALID`
+ * is set (calibration received).
+ *
+ * `timestamp_ns` is the kernel receive timestamp of the report (`SO_TIMESTAMPNS`,
+ * converted to `CLOCK_MONOTONIC`) where the socket supports it, otherwise the time
+ * right after `recvmsg()`. The spacing of the timestamps therefore shows the real
+ * sample spacing including radio jitter; do not assume a uniform rate. With the filter
+ * stage (`-F`, `-R`, see `YAWiiBBfilter.h`) the data records are filtered samples on a
+ * fixed grid instead: `timestamp_ns` is the grid time, `mass` the filtered masses,
+ * `raw` the values of the latest report, and `BINARY_FLAG_FILTERED` is set.
+ *
+ * For numpy the records can be read with
+ * @code
+ * np.dtype([("timestamp_ns", "<u8"), ("board_id", "<u2"), ("report_type", "u1"),
+ *           ("flags", "u1"), ("raw", "<u2", 4), ("mass", "<u4", 4)])
+ * @endcode
+ * after skipping the 12 byte header.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#define YAWIIBB_BINARY_MAGIC "YWBB"           /**< Magic at the start of every binary stream */
+#define YAWIIBB_BINARY_VERSION 1              /**< Current version of the record layout */
+#define YAWIIBB_BINARY_HEADER_SIZE 12         /**< Size of the encoded stream header */
+#define YAWIIBB_BINARY_RECORD_SIZE 36         /**< Size of one encoded record */
+
+#define BINARY_FLAG_MASS_VALID 0x01           /**< `mass` contains calibrated values */
+#define BINARY_FLAG_BUTTON 0x02               /**< The main button was pressed in this report */
+#define BINARY_FLAG_FILTERED 0x04             /**< `mass` and `timestamp_ns` come from the filter stage */
+
+/**
+ * @struct BinaryHeader
+ * @brief Decoded form of the stream header.
+ */
+typedef struct {
+    uint16_t version;               /**< Format version, see `YAWIIBB_BINARY_VERSION` */
+    uint16_t record_size;           /**< Size of every following record in bytes */
+    uint32_t board_count;           /**< Number of boards in the stream */
+} BinaryHeader;
+
+/**
+ * @struct BinarySample
+ * @brief Decoded form of one record.
+ */
+typedef struct {
+    uint64_t timestamp_ns;          /**< `CLOCK_MONOTONIC` at reception */
+    uint16_t board_id;              /**< Index of the board */
+    uint8_t report_type;            /**< Report ID */
+    uint8_t flags;                  /**< `BINARY_FLAG_*` */
+    uint16_t raw[4];                /**< Raw sensor values TR, BR, TL, BL */
+    uint32_t mass[4];               /**< Masses in gram TR, BR, TL, BL */
+} BinarySample;
+
+/** @brief Stores @p value little-endian at @p out (@p bytes bytes). */
+static inline void binary_put_le(unsigned char* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out[i] = (unsigned char)(value >> (8 * i));
+}
+
+/** @brief Reads a little-endian value of @p bytes bytes from @p in. */
+static inline uint64_t binary_get_le(const unsigned char* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) value |= (uint64_t)in[i] << (8 * i);
+    return value;
+}
+
+/**
+ * @brief Encodes the stream header into @p out (`YAWIIBB_BINARY_HEADER_SIZE` bytes).
+ */
+static inline void binary_encode_header(unsigned char* out, uint32_t board_count) {
+    memcpy(out, YAWIIBB_BINARY_MAGIC, 4);
+    binary_put_le(out + 4, YAWIIBB_BINARY_VERSION, 2);
+    binary_put_le(out + 6, YAWIIBB_BINARY_RECORD_SIZE, 2);
+    binary_put_le(out + 8, board_count, 4);
+}
+
+/**
+ * @brief Decodes a stream header.
+ *
+ * Newer versions are accepted as long as their records are at least
+ * `YAWIIBB_BINARY_RECORD_SIZE` bytes long; the caller skips the extra bytes by
+ * reading `record_size` bytes per record.
+ *
+ * @return 0 if the magic matches and the records can be read, -1 otherwise.
+ */
+static inline int binary_decode_header(const unsigned char* in, BinaryHeader* header) {
+    if (memcmp(in, YAWIIBB_BINARY_MAGIC, 4) != 0) return -1;
+    header->version = (uint16_t)binary_get_le(in + 4, 2);
+    header->record_size = (uint16_t)binary_get_le(in + 6, 2);
+    header->board_count = (uint32_t)binary_get_le(in + 8, 4);
+    if (header->version < YAWIIBB_BINARY_VERSION || header->record_size < YAWIIBB_BINARY_RECORD_SIZE) return -1;
+    return 0;
+}
+
+/**
+ * @brief Encodes one record into @p out (`YAWIIBB_BINARY_RECORD_SIZE` bytes).
+ */
+static inline void binary_encode_sample(unsigned char* out, const BinarySample* sample) {
+    binary_put_le(out, sample->timestamp_ns, 8);
+    binary_put_le(out + 8, sample->board_id, 2);
+    out[10] = sample->report_type;
+    out[11] = sample->flags;
+    for (int i = 0; i < 4; i++) binary_put_le(out + 12 + 2 * i, sample->raw[i], 2);
+    for (int i = 0; i < 4; i++) binary_put_le(out + 20 + 4 * i, sample->mass[i], 4);
+}
+
+/**
+ * @brief Decodes one record from @p in.
+ */
+static inline void binary_decode_sample(const unsigned char* in, BinarySample* sample) {
+    sample->timestamp_ns = binary_get_le(in, 8);
+    sample->board_id = (uint16_t)binary_get_le(in + 8, 2);
+    sample->report_type = in[10];
+    sample->flags = in[11];
+    for (int i = 0; i < 4; i++) sample->raw[i] = (uint16_t)binary_get_le(in + 12 + 2 * i, 2);
+    for (int i = 0; i < 4; i++) sample->mass[i] = (uint32_t)binary_get_le(in + 20 + 4 * i, 4);
+}
+
+#endif // YAWIIBBBINARY_H
@@ -0,0 +1,127 @@
+#include "YAWiiBBcache.h"
+#include <sys/stat.h>
+#include <strings.h>
+/**
+ * @file YAWiiBBcache.c
+ * @brief Core file for the board cache predefined in YAWiiBBcache.h.
+ */
+
+
+// Legt alle Verzeichnisse eines Pfades an (wie mkdir -p)
+static int make_dirs(char* path) {
+    for (char* p = path + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = 0;
+        int result = mkdir(path, 0700);
+        *p = '/';
+        if (result < 0 && errno != EEXIST) return -1;
+    }
+    return 0;
+}
+
+int cache_path(const char* name, char* path, size_t size) {
+    const char* dir = getenv("YAWIIBB_CACHE_DIR");
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    int length;
+
+    if (dir != NULL && *dir) length = snprintf(path, size, "%s/%s", dir, name);
+    else if (xdg != NULL && *xdg) length = snprintf(path, size, "%s/yawiibb/%s", xdg, name);
+    else if (home != NULL && *home) length = snprintf(path, size, "%s/.cache/yawiibb/%s", home, name);
+    else return -1;
+
+    if (length < 0 || (size_t)length >= size) return -1;
+    return make_dirs(path);
+}
+
+int load_known_boards(KnownBoard* boards, int max) {
+    char path[512];
+    if (cache_path(CACHE_BOARDS_FILE, path, sizeof(path)) < 0) return 0;
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return 0; // Noch kein Cache
+
+    int count = 0;
+    long long last_seen;
+    while (count < max && fscanf(file, "%18s %18s %lld", boards[count].mac, boards[count].adapter, &last_seen) == 3) {
+        boards[count].last_seen = (time_t)last_seen;
+        if (strcmp(boards[count].adapter, "-") == 0) boards[count].adapter[0] = 0;
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+void remember_board(const char* mac, const char* adapter) {
+    KnownBoard boards[CACHE_MAX_BOARDS];
+    int count = load_known_boards(boards, CACHE_MAX_BOARDS);
+
+    char path[512], temp[520];
+    if (cache_path(CACHE_BOARDS_FILE, path, sizeof(path)) < 0) return;
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE* file = fopen(temp, "w");
+    if (file == NULL) {
+        perror("Fehler beim Schreiben des Board-Caches");
+        return;
+    }
+
+    // Neuester Eintrag zuerst, alte Einträge desselben Boards entfallen
+    fprintf(file, "%s %s %lld\n", mac, (adapter != NULL && *adapter) ? adapter : "-", (long long)time(NULL));
+    int written = 1;
+    for (int i = 0; i < count && written < CACHE_MAX_BOARDS; i++) {
+        if (strcasecmp(boards[i].mac, mac) == 0) continue;
+        fprintf(file, "%s %s %lld\n", boards[i].mac, boards[i].adapter[0] ? boards[i].adapter : "-", (long long)boards[i].last_seen);
+        written++;
+    }
+
+    if (fclose(file) != 0 || rename(temp, path) < 0) {
+        perror("Fehler beim Schreiben des Board-Caches");
+        unlink(temp);
+    }
+}
+
+// Liest eine Tabelle: drei Zeilen (0, 17, 34 kg) mit je vier Rohwerten (TR, BR, TL, BL)
+static int read_calibration(const char* mac, uint16_t calibration[3][4]) {
+    char name[64], path[512];
+    snprintf(name, sizeof(name), CACHE_CALIBRATION_DIR "/%s", mac);
+    if (cache_path(name, path, sizeof(path)) < 0) return -1;
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return -1;
+
+    int values = 0;
+    for (int level = 0; level < 3; level++)
+        for (int pos = 0; pos < 4; pos++)
+            values += fscanf(file, "%hu", &calibration[level][pos]);
+    fclose(file);
+    return values == 12 ? 0 : -1;
+}
+
+int load_calibration(WiiBalanceBoard* board) {
+    if (read_calibration(board->mac, board->calibration) < 0) return -1;
+    precompute_mass_coefficients(board);
+    board->calibrated = true;
+    return 0;
+}
+
+void store_calibration(const WiiBalanceBoard* board) {
+    uint16_t cached[3][4];
+    if (read_calibration(board->mac, cached) == 0 && memcmp(cached, board->calibration, sizeof(cached)) == 0) return;
+
+    char name[64], path[512], temp[520];
+    snprintf(name, sizeof(name), CACHE_CALIBRATION_DIR "/%s", board->mac);
+    if (cache_path(name, path, sizeof(path)) < 0) return;
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE* file = fopen(temp, "w");
+    if (file == NULL) {
+        perror("Fehler beim Schreiben des Kalibrier-Caches");
+        return;
+    }
+    for (int level = 0; level < 3; level++)
+        fprintf(file, "%u %u %u %u\n", board->calibration[level][0], board->calibration[level][1],
+                board->calibration[level][2], board->calibration[level][3]);
+    if (fclose(file) != 0 || rename(temp, path) < 0) {
+        perror("Fehler beim Schreiben des Kalibrier-Caches");
+        unlink(temp);
+        return;
+    }
+    fprintf(stderr, "Kalibrierung von %s im Cache gespeichert\n", board->mac);
+}
@@ -0,0 +1,90 @@
+#ifndef YAWIIBBCACHE_H
+#define YAWIIBBCACHE_H
+
+/**
+ * @file YAWiiBBcache.h
+ * @brief Persistent cache of known Wii Balance Boards.
+ *
+ * Without a MAC address on the command line, `find_wii_balance_board()` used to
+ * run a full HCI inquiry of about 10 s on every start. Every board the driver has
+ * connected to is therefore remembered together with the adapter it was seen on
+ * and the time it was last seen. On the next start the known boards are tried
+ * first with a direct connect; the inquiry only runs if none of them answers.
+ *
+ * The calibration table of every board is cached as well
+ * (`calibration/<MAC>`). It is loaded at connect time, so the very first 0x32 report
+ * is already calibrated. The calibration read of the init sequence still runs and
+ * replaces the cached table if the board reports different values.
+ *
+ * The board cache is a plain text file with one board per line,
+ * `<MAC> <adapter MAC> <last seen (Unix time)>`, newest first. It lives in
+ * `$YAWIIBB_CACHE_DIR`, `$XDG_CACHE_HOME/yawiibb` or `~/.cache/yawiibb`
+ * (the first one that is set).
+ */
+
+#include "YAWiiBBessentials.h"
+
+#define CACHE_MAX_BOARDS 16            /**< Number of boards kept in the cache */
+#define CACHE_BOARDS_FILE "boards"     /**< File name of the board list in the cache directory */
+#define CACHE_CALIBRATION_DIR "calibration" /**< Subdirectory of the calibration tables */
+
+/**
+ * @struct KnownBoard
+ * @brief One entry of the board cache.
+ */
+typedef struct {
+    char mac[19];                   /**< MAC address of the board */
+    char adapter[19];               /**< MAC address of the local adapter it was seen on */
+    time_t last_seen;               /**< Time of the last successful connection */
+} KnownBoard;
+
+/**
+ * @brief Builds the path of a file in the cache directory and creates the directory.
+ *
+ * @param name Name of the file (may contain a subdirectory, which is created as well).
+ * @param path Receives the full path.
+ * @param size Size of `path`.
+ * @return 0 on success, -1 if no cache directory can be determined or created.
+ */
+int cache_path(const char* name, char* path, size_t size);
+
+/**
+ * @brief Reads the known boards, newest first.
+ *
+ * @param boards Array receiving the entries.
+ * @param max    Size of `boards`.
+ * @return Number of entries read (0 if there is no cache yet).
+ */
+int load_known_boards(KnownBoard* boards, int max);
+
+/**
+ * @brief Stores a board as seen now on the given adapter.
+ *
+ * An existing entry of the board is moved to the front; the oldest entries are
+ * dropped beyond `CACHE_MAX_BOARDS`. The file is replaced atomically.
+ *
+ * @param mac     MAC address of the board.
+ * @param adapter MAC address of the local adapter (empty if unknown).
+ */
+void remember_board(const char* mac, const char* adapter);
+
+/**
+ * @brief Loads the cached calibration table of a board.
+ *
+ * On success `calibration` and `coefficients` are set and the board counts as calibrated.
+ *
+ * @param board Board whose `mac` selects the table.
+ * @return 0 if a table was loaded, -1 if there is none.
+ */
+int load_calibration(WiiBalanceBoard* board);
+
+/**
+ * @brief Stores the calibration table of a board if it differs from the cached one.
+ *
+ * Called from `process_calibration_data()` when the second 0x21 packet arrived.
+ *
+ * @param board Board with a complete `calibration` table.
+ */
+void store_calibration(const WiiBalanceBoard* board);
+
+#endif // YAWIIBBCACHE_H
@@ -0,0 +1,188 @@
+#include "YAWiiBBcapture.h"
+#include "YAWiiBBtransport.h"
+/**
+ * @file YAWiiBBcapture.c
+ * @brief Core file for recording and replay predefined in YAWiiBBcapture.h.
+ */
+
+#define MAC_FIELD_SIZE 18 // 17 Zeichen + abschließende 0
+
+
+FILE* capture_open(const char* path, const BoardDaemon* daemon) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        perror("Fehler beim Anlegen der Aufzeichnung");
+        return NULL;
+    }
+    setvbuf(file, NULL, _IOFBF, CAPTURE_BUFFER_SIZE);
+
+    unsigned char header[8];
+    memcpy(header, YAWIIBB_CAPTURE_MAGIC, 4);
+    binary_put_le(header + 4, YAWIIBB_CAPTURE_VERSION, 2);
+    binary_put_le(header + 6, (uint64_t)daemon->count, 2);
+    fwrite(header, sizeof(header), 1, file);
+    for (int i = 0; i < daemon->count; i++) {
+        char mac[MAC_FIELD_SIZE];
+        memcpy(mac, daemon->boards[i].mac, MAC_FIELD_SIZE);
+        mac[MAC_FIELD_SIZE - 1] = 0;
+        fwrite(mac, sizeof(mac), 1, file);
+    }
+    return file;
+}
+
+void capture_report(FILE* file, const WiiBalanceBoard* board, uint64_t received_ns, const unsigned char* data, int length) {
+    unsigned char record[11];
+    binary_put_le(record, received_ns, 8);
+    binary_put_le(record + 8, board->id < 0 ? 0 : (uint64_t)board->id, 2);
+    record[10] = (unsigned char)length;
+    fwrite(record, sizeof(record), 1, file);
+    fwrite(data, (size_t)length, 1, file);
+}
+
+int replay_open(ReplaySource* replay, BoardDaemon* daemon, const char* path, bool paced, const WiiBalanceBoard* defaults) {
+    memset(replay, 0, sizeof(*replay));
+    replay->paced = paced;
+    replay->file = fopen(path, "rb");
+    if (replay->file == NULL) {
+        perror("Fehler beim Öffnen der Aufzeichnung");
+        return -1;
+    }
+
+    unsigned char header[8];
+    if (fread(header, sizeof(header), 1, replay->file) != 1 || memcmp(header, YAWIIBB_CAPTURE_MAGIC, 4) != 0 ||
+        binary_get_le(header + 4, 2) != YAWIIBB_CAPTURE_VERSION) {
+        fprintf(stderr, "Fehler: %s ist keine gültige Aufzeichnung\n", path);
+        goto fail;
+    }
+    replay->count = (int)binary_get_le(header + 6, 2);
+    if (replay->count == 0) {
+        fprintf(stderr, "Fehler: Aufzeichnung ohne Boards\n");
+        goto fail;
+    }
+
+    daemon->boards = calloc(replay->count, sizeof(WiiBalanceBoard));
+    replay->peers = malloc(replay->count * sizeof(int));
+    replay->control_peers = malloc(replay->count * sizeof(int));
+    if (daemon->boards == NULL || replay->peers == NULL || replay->control_peers == NULL) {
+        perror("Fehler beim Anlegen der Boards");
+        goto fail;
+    }
+    // -1 = noch nicht geöffnet, damit fail: nur angelegte Sockets schließt
+    for (int i = 0; i < replay->count; i++) {
+        daemon->boards[i].receive_sock = daemon->boards[i].control_sock = -1;
+        replay->peers[i] = replay->control_peers[i] = -1;
+    }
+
+    for (int i = 0; i < replay->count; i++) {
+        WiiBalanceBoard* board = &daemon->boards[i];
+        char mac[MAC_FIELD_SIZE];
+        if (fread(mac, sizeof(mac), 1, replay->file) != 1) {
+            fprintf(stderr, "Fehler: Aufzeichnung ist unvollständig\n");
+            goto fail;
+        }
+        mac[MAC_FIELD_SIZE - 1] = 0;
+        *board = *defaults;
+        strcpy(board->mac, mac);
+        board->id = replay->count > 1 ? i : -1;
+        // Die Aufzeichnung enthält die Antworten bereits, es gibt keine Init-Sequenz
+        board->needStatus = board->needCalibration = board->needLed = false;
+        board->needActivation = board->needDumpStart = false;
+
+        // Socketpairs anstelle der beiden L2CAP-Kanäle, auch wenn -b hidraw gewählt ist
+        board->transport = &l2cap_transport;
+        int data_pair[2], control_pair[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, data_pair) < 0) {
+            perror("Fehler beim Erstellen der Replay-Sockets");
+            goto fail;
+        }
+        board->receive_sock = data_pair[0];
+        replay->peers[i] = data_pair[1];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, control_pair) < 0) {
+            perror("Fehler beim Erstellen der Replay-Sockets");
+            goto fail;
+        }
+        board->control_sock = control_pair[0];
+        replay->control_peers[i] = control_pair[1];
+    }
+    daemon->count = replay->count;
+    return 0;
+
+fail:
+    for (int i = 0; daemon->boards != NULL && replay->peers != NULL && replay->control_peers != NULL && i < replay->count; i++) {
+        int fds[4] = { daemon->boards[i].receive_sock, daemon->boards[i].control_sock, replay->peers[i], replay->control_peers[i] };
+        for (int k = 0; k < 4; k++) if (fds[k] >= 0) close(fds[k]);
+    }
+    free(daemon->boards);
+    free(replay->peers);
+    free(replay->control_peers);
+    daemon->boards = NULL;
+    daemon->count = 0;
+    fclose(replay->file);
+    memset(replay, 0, sizeof(*replay));
+    return -1;
+}
+
+/**
+ * @brief Thread function sending the recorded reports into the socketpairs.
+ */
+static void* replay_thread(void* arg) {
+    ReplaySource* replay = (ReplaySource*)arg;
+    unsigned char record[11];
+    unsigned char data[256];
+    uint64_t first_ns = 0;
+    int closed = 0;
+
+    while (fread(record, sizeof(record), 1, replay->file) == 1) {
+        uint64_t timestamp = binary_get_le(record, 8);
+        int id = (int)binary_get_le(record + 8, 2);
+        int length = record[10];
+        if (fread(data, (size_t)length, 1, replay->file) != 1 || id >= replay->count) break;
+
+        if (replay->paced) {
+            // Ursprüngliche Abstände einhalten (absoluter Zeitpunkt, damit sich kein Fehler aufsummiert)
+            if (replay->reports == 0) first_ns = timestamp;
+            uint64_t due = replay->started_ns + (timestamp - first_ns);
+            struct timespec ts = { .tv_sec = due / 1000000000ull, .tv_nsec = due % 1000000000ull };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        }
+        // Ein bereits geschlossenes Board (Power-Taste) wird übersprungen, die anderen laufen weiter
+        if (replay->peers[id] < 0) continue;
+        if (send(replay->peers[id], data, length, MSG_NOSIGNAL) < 0) {
+            close(replay->peers[id]);
+            replay->peers[id] = -1;
+            if (++closed == replay->count) break;
+            continue;
+        }
+        replay->reports++;
+    }
+
+    // Ende der Aufzeichnung: wie ein Verbindungsabbruch
+    for (int i = 0; i < replay->count; i++) {
+        if (replay->peers[i] >= 0) close(replay->peers[i]);
+        close(replay->control_peers[i]);
+    }
+    return NULL;
+}
+
+void replay_start(ReplaySource* replay) {
+    replay->started_ns = monotonic_ns();
+    if (pthread_create(&replay->thread, NULL, replay_thread, replay) != 0) {
+        perror("Fehler beim Erstellen des Replay-Threads");
+        exit(1);
+    }
+}
+
+void replay_finish(ReplaySource* replay, const BoardDaemon* daemon) {
+    pthread_join(replay->thread, NULL);
+    double seconds = (monotonic_ns() - replay->started_ns) / 1e9;
+
+    uint64_t processed = 0;
+    for (int i = 0; i < daemon->count; i++) processed += daemon->boards[i].stats.delay.total;
+    fprintf(stderr, "Replay: %llu Reports gesendet, %llu verarbeitet in %.3f s = %.0f Reports/s (%s)\n",
+            (unsigned long long)replay->reports, (unsigned long long)processed, seconds,
+            seconds > 0 ? processed / seconds : 0.0, replay->paced ? "Echtzeit" : "ungebremst");
+
+    fclose(replay->file);
+    free(replay->peers);
+    free(replay->control_peers);
+}
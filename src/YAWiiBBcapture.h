@@ -0,0 +1,115 @@
+#ifndef YAWIIBBCAPTURE_H
+#define YAWIIBBCAPTURE_H
+
+/**
+ * @file YAWiiBBcapture.h
+ * @brief Recording of received reports and replay of such recordings.
+ *
+ * With `-c file` every report received on a `receive_sock` is appended to a
+ * capture file together with its `CLOCK_MONOTONIC` reception time. With `-i file`
+ * such a file is played back instead of connecting to real boards: every board of
+ * the recording gets a socketpair instead of its L2CAP sockets, and a replay thread
+ * sends the recorded reports into it. The event loop, the report ring, calibration
+ * and all output formats therefore run exactly as with a live board, which makes
+ * performance measurements and regression tests possible without hardware.
+ *
+ * The replay is paced in real time by default; `-f` sends as fast as possible and
+ * the reports per second printed at the end serve as throughput benchmark.
+ *
+ * ## File Layout (little-endian)
+ * Header:
+ * | Size            | Field         | Description                          |
+ * |-----------------|---------------|--------------------------------------|
+ * | 4               | magic         | `"YWBC"`                             |
+ * | 2               | version       | `YAWIIBB_CAPTURE_VERSION`            |
+ * | 2               | board_count   | Number of boards                     |
+ * | 18 * boards     | mac           | MAC address of every board (0 terminated) |
+ *
+ * followed by one record per report:
+ * | Size   | Field         | Description                                   |
+ * |--------|---------------|-----------------------------------------------|
+ * | 8      | timestamp_ns  | `CLOCK_MONOTONIC` at reception                |
+ * | 2      | board_id      | Index of the board (0 for a single board)     |
+ * | 1      | length        | Number of report bytes                        |
+ * | length | data          | Report as received from the board             |
+ */
+
+#include "YAWiiBBessentials.h"
+
+#define YAWIIBB_CAPTURE_MAGIC "YWBC"      /**< Magic at the start of every capture file */
+#define YAWIIBB_CAPTURE_VERSION 1         /**< Current version of the capture layout */
+#define CAPTURE_BUFFER_SIZE (1 << 16)     /**< stdio buffer of the capture file */
+
+/**
+ * @struct ReplaySource
+ * @brief State of a running replay.
+ */
+typedef struct {
+    FILE* file;                     /**< Capture file positioned behind the header */
+    int count;                      /**< Number of boards in the recording */
+    int* peers;                     /**< Replay end of the data socketpair of every board */
+    int* control_peers;             /**< Replay end of the control socketpair of every board */
+    bool paced;                     /**< Keep the recorded timing (real time) */
+    uint64_t started_ns;            /**< Start of the replay */
+    uint64_t reports;               /**< Number of reports sent */
+    pthread_t thread;               /**< Replay thread */
+} ReplaySource;
+
+/**
+ * @brief Creates a capture file and writes its header.
+ *
+ * @param path   Path of the capture file (overwritten if it exists).
+ * @param daemon Daemon whose boards are recorded.
+ * @return The opened file or `NULL` on failure (an error message is printed).
+ */
+FILE* capture_open(const char* path, const BoardDaemon* daemon);
+
+/**
+ * @brief Appends one received report to the capture file.
+ *
+ * Called by `drain_receive_sock()` for every report. The record is buffered by stdio.
+ *
+ * @param file        Capture file.
+ * @param board       Board that received the report.
+ * @param received_ns Reception time.
+ * @param data        Report bytes.
+ * @param length      Number of report bytes.
+ */
+void capture_report(FILE* file, const WiiBalanceBoard* board, uint64_t received_ns, const unsigned char* data, int length);
+
+/**
+ * @brief Opens a capture file for replay and prepares the boards of the daemon.
+ *
+ * Reads the header, allocates `daemon->boards` with the recorded MAC addresses
+ * and gives every board a pair of socketpairs instead of L2CAP sockets.
+ *
+ * @param replay   Replay state to initialise.
+ * @param daemon   Daemon that receives the boards.
+ * @param path     Path of the capture file.
+ * @param paced    `true` for real-time replay, `false` for as fast as possible.
+ * @param defaults Initial state of every board (flags of the init sequence).
+ * @return 0 on success, -1 on failure (an error message is printed).
+ */
+int replay_open(ReplaySource* replay, BoardDaemon* daemon, const char* path, bool paced, const WiiBalanceBoard* defaults);
+
+/**
+ * @brief Starts the replay thread.
+ *
+ * The thread sends the recorded reports and closes the socketpairs at the end of
+ * the file, which stops the boards like a lost connection.
+ */
+void replay_start(ReplaySource* replay);
+
+/**
+ * @brief Waits for the replay thread and prints the throughput to stderr.
+ *
+ * The throughput is the number of reports processed by the output thread divided
+ * by the time since `replay_start()`, so it has to be called after the output
+ * thread has been stopped.
+ *
+ * @param replay Replay state.
+ * @param daemon Daemon that processed the replay.
+ */
+void replay_finish(ReplaySource* replay, const BoardDaemon* daemon);
+
+#endif // YAWIIBBCAPTURE_H
@@ -1,4 +1,11 @@
 #include "YAWiiBBessentials.h"
+#include "YAWiiBBtransport.h"
+#include "YAWiiBBcapture.h"
+#include "YAWiiBBcache.h"
+#include "YAWiiBBserver.h"
+#include "YAWiiBBbatch.h"
+#include <stddef.h>
+#include <strings.h>
 /**
  * @file YAWiiBBessentials.c
  * @brief Core file for funktions predefined in YAWiiBBessentials.h.
@@ -6,149 +13,452 @@
 
 
 // Kommandos als konstante Byte-Arrays wie in der Header Datei beschrieben
-const unsigned char status_command[] = { 0x52, 0x12, 0x00, 0x32 };
-const unsigned char activate_command[] = { 0x52, 0x13, 0x04 };
+const unsigned char status_command[] = { 0x52, 0x12, 0x02, 0x32 };
+const unsigned char activate_command[] = { 0x52, 0x13, 0x06 };
 const unsigned char calibration_command[] = { 0x52, 0x17, 0x04, 0xa4, 0x00, 0x24, 0x00, 0x18 };
-const unsigned char led_on_command[] = { 0x52, 0x11, 0x10 };
+const unsigned char led_on_command[] = { 0x52, 0x11, 0x12 };
 const unsigned char data_dump_command[] = { 0x52, 0x15, 0x00, 0x32 };
-unsigned char buffer[BUFFER_SIZE];
-
-
-void print_info(const LogLevel* is_debug_level, const char* message, const unsigned char* buffer, int length, const WiiBalanceBoard* board) {
-    // Ausgabe basierend auf dem Log-Level
-    if(length>1){
-        switch (debug_level) {
-            case RAW:
-                if(buffer[1] == 0x32) {
-                    printf("Sensor:      ");
-                    for (int i = 0; i < length; i++) printf("%i:%02x ", i, buffer[i]);
-                    printf("\n");
-                    }
-                if(buffer[1] == 0x21) {
-                    printf("Kalibration: ");
-                    for (int i = 0; i < length; i++) printf("%i:%02x ", i, buffer[i]);
-                    printf("\n");
-                    }
-                if(buffer[1] == 0x20) {
-                    printf("Status:      ");
-                    for (int i = 0; i < length; i++) printf("%i:%02x ", i, buffer[i]);
-                    printf("\n");
-                    }
+
+volatile sig_atomic_t stats_requested = 0;
+
+volatile sig_atomic_t level_requested = -1;
+
+TextWriter text_writer;
+
+// Reservierte Slots eines Empfangsaufrufs, nur vom Empfangsthread benutzt
+static ReportSlot* receive_slots[RECEIVE_BATCH];
+
+
+// Formatiert eine Zeile "<Bezeichnung>0:a1 1:32 ...\n" wie früher "%i:%02x " pro Byte
+static char* format_bytes(char* p, const char* label, const unsigned char* buffer, int length) {
+    p = format_text(p, label);
+    for (int i = 0; i < length; i++) {
+        p = format_u32(p, (uint32_t)i);
+        *p++ = ':';
+        p = format_hex2(p, buffer[i]);
+        *p++ = ' ';
+    }
+    *p++ = '\n';
+    return p;
+}
+
+// Zeile eines Reports reservieren, danach wird ohne weitere Prüfung formatiert
+static inline char* reserve_line(TextWriter* out, int length) {
+    return writer_reserve(out, WRITER_LINE_MAX + 6 * (size_t)length);
+}
+
+// Bezeichnung der Rohdatenzeile je Reportart, NULL = keine Zeile
+static const char* const raw_labels[] = {
+    [REPORT_INVALID] = NULL,
+    [REPORT_STATUS] = "Status:      ",
+    [REPORT_READ] = "Kalibration: ",
+    [REPORT_ACK] = NULL,
+    [REPORT_DATA] = "Sensor:      ",
+    [REPORT_INPUT] = NULL
+};
+
+// RAW und die Status-/Kalibrationszeilen von DEBUG
+static char* format_report_bytes(const WiiBalanceBoard* board, const ReportView* report, char* p) {
+    const char* label = raw_labels[report->kind];
+    if (label == NULL) return p;
+    p = print_board_tag(board, p);
+    return format_bytes(p, label, report->bytes, report->length);
+}
+
+static void print_raw(const WiiBalanceBoard* board, const ReportView* report, TextWriter* out) {
+    writer_commit(out, format_report_bytes(board, report, reserve_line(out, report->length)));
+}
+
+static void print_decoded(const WiiBalanceBoard* board, const ReportView* report, TextWriter* out) {
+    if (report->kind != REPORT_DATA) return;
+    const uint32_t* gramm = report->data.mass;
+    uint32_t summe = 0;
+    char* p = print_board_tag(board, reserve_line(out, report->length));
+    for (int i = 0; i < 4; i++) {
+        p = format_u32(p, gramm[i]);
+        *p++ = ',';
+        summe += gramm[i]/1000;
+        }
+    p = format_u32(p, summe);
+    p = format_text(p, "       \r");
+    writer_commit(out, p);
+}
+
+static void print_debug(const WiiBalanceBoard* board, const ReportView* report, TextWriter* out) {
+    char* p = reserve_line(out, report->length);
+    if (report->kind == REPORT_DATA) {
+        const uint32_t* gramm = report->data.mass;
+        p = print_board_tag(board, p);
+        // wie "%.2f" von gramm / 1000.0, siehe format_kg()
+        p = format_text(p, "Vorne rechts ");
+        p = format_kg(p, gramm[0]);
+        p = format_text(p, ", hinten rechts ");
+        p = format_kg(p, gramm[1]);
+        p = format_text(p, ", vorne links ");
+        p = format_kg(p, gramm[2]);
+        p = format_text(p, ", hinten links ");
+        p = format_kg(p, gramm[3]);
+        p = format_text(p, " \n");
+    } else {
+        p = format_report_bytes(board, report, p);
+    }
+    writer_commit(out, p);
+}
+
+// "0x" und zwei bzw. vier Hex-Ziffern
+static char* format_hex_prefixed(char* p, uint16_t value, bool wide) {
+    p = format_text(p, "0x");
+    if (wide) p = format_hex2(p, (uint8_t)(value >> 8));
+    return format_hex2(p, (uint8_t)value);
+}
+
+// Jeder Report (auch ungültige) als eine Zeile mit allen Feldern, die parse_report() geliefert hat
+static void print_verbose(const WiiBalanceBoard* board, const ReportView* report, TextWriter* out) {
+    char* p = print_board_tag(board, reserve_line(out, report->length));
+    switch (report->kind) {
+        case REPORT_DATA: {
+            p = format_text(p, "Daten ");
+            p = format_hex_prefixed(p, report->id, false);
+            p = format_text(p, " Tasten ");
+            p = format_hex_prefixed(p, report->buttons, true);
+            p = format_text(p, " roh");
+            uint32_t summe = 0;
+            for (int i = 0; i < 4; i++) {
+                *p++ = i ? ',' : ' ';
+                p = format_u32(p, report_sensor(report, i));
+            }
+            p = format_text(p, " Gramm");
+            for (int i = 0; i < 4; i++) {
+                uint32_t gramm = report->data.mass[i];
+                *p++ = i ? ',' : ' ';
+                p = format_u32(p, gramm);
+                summe += gramm;
+            }
+            p = format_text(p, " Summe ");
+            p = format_kg(p, summe);
+            p = format_text(p, " kg\n");
             break;
-            #ifdef YAWIIBB_EXTENDED
-            case DECODE:
-                if (buffer[1] == 0x32) {                    
-                   uint16_t gramm[4];
-                   for(int i=0; i<4; i++){
-                    uint16_t raw = bytes_to_int_big_endian(buffer, 4 + (2 * i), &length);
-                    gramm[i] = calc_mass(board, raw, i);
-                   }
-                uint16_t summe = 0;
-                for (int i = 0; i < 4; i++) {
-                    printf("%u,", gramm[i]);
-                    summe += (uint16_t)gramm[i]/1000;
-                    }
-                printf("%u       \r", summe);
-                }
-                break;
-            case DEBUG:
-                 if (buffer[1] == 0x32) {                    
-                   uint16_t gramm[4];
-                   for(int i=0; i<4; i++){
-                    uint16_t raw = bytes_to_int_big_endian(buffer, 4 + (2 * i), &length);
-                    gramm[i] = calc_mass(board, raw, i);
-                   }
-                printf("Vorne rechts %.2f, hinten rechts %.2f, vorne links %.2f, hinten links %.2f \n", gramm[0] / 1000.0, gramm[1] / 1000.0, gramm[2] / 1000.0, gramm[3] / 1000.0);
-                 }
-                 if(buffer[1] == 0x21) {
-                    printf("Kalibration: ");
-                    for (int i = 0; i < length; i++) printf("%i:%02x ", i, buffer[i]);
-                    printf("\n");
-                    }
-                if(buffer[1] == 0x20) {
-                    printf("Status:      ");
-                    for (int i = 0; i < length; i++) printf("%i:%02x ", i, buffer[i]);
-                    printf("\n");
-                    }
-                break;
-            case VERBOSE:
-                // noch leer
-                printf("VERBOSE: %s", message);
-                break;
-            #endif //YAWIIBB_EXTENDED
         }
+        case REPORT_INPUT:
+            p = format_text(p, "Eingabe ");
+            p = format_hex_prefixed(p, report->id, false);
+            p = format_text(p, " Tasten ");
+            p = format_hex_prefixed(p, report->buttons, true);
+            p = format_text(p, ", ");
+            p = format_u32(p, (uint32_t)report->length);
+            p = format_text(p, " Byte ohne Sensoren\n");
+            break;
+        case REPORT_STATUS:
+            p = format_text(p, "Status Tasten ");
+            p = format_hex_prefixed(p, report->buttons, true);
+            p = format_text(p, " Flags ");
+            p = format_hex_prefixed(p, report->status.flags, false);
+            p = format_text(p, " Batterie ");
+            p = format_u32(p, report->status.battery);
+            *p++ = '\n';
+            break;
+        case REPORT_READ:
+            p = format_text(p, "Lesen Adresse ");
+            p = format_hex_prefixed(p, report->read.address, true);
+            p = format_text(p, " Fehler ");
+            p = format_u32(p, report->read.error);
+            p = format_text(p, " Größe ");
+            p = format_u32(p, report->read.size);
+            *p++ = ':';
+            for (int i = 0; i < report->read.length; i++) {
+                *p++ = ' ';
+                p = format_hex2(p, report->read.data[i]);
+            }
+            *p++ = '\n';
+            break;
+        case REPORT_ACK:
+            p = format_text(p, "Bestätigung Kommando ");
+            p = format_hex_prefixed(p, report->ack.command, false);
+            p = format_text(p, " Fehler ");
+            p = format_u32(p, report->ack.error);
+            *p++ = '\n';
+            break;
+        case REPORT_INVALID:
+            p = format_bytes(p, "Ungültig:    ", report->bytes, report->length);
+            break;
     }
+    writer_commit(out, p);
+}
+
+static const TextPrinter text_printers[LOG_LEVELS] = {
+    [RAW] = print_raw,
+    [DECODE] = print_decoded,
+    [DEBUG] = print_debug,
+    [VERBOSE] = print_verbose
+};
+
+static const char* const level_names[LOG_LEVELS] = {
+    [RAW] = "raw",
+    [DECODE] = "decode",
+    [DEBUG] = "debug",
+    [VERBOSE] = "verbose"
+};
+
+void print_info(const ReportView* report, const WiiBalanceBoard* board, TextWriter* out) {
+    // Die Ausgabe je Log-Level wurde einmal in set_log_level() gewählt
+    if (report->length > 1) board->print_text(board, report, out);
+}
+
+void set_log_level(WiiBalanceBoard* board, LogLevel level) {
+    board->level = level;
+    board->print_text = text_printers[level];
+}
+
+int parse_log_level(const char* name) {
+    size_t length = strcspn(name, "\n");
+    for (int level = 0; level < LOG_LEVELS; level++)
+        if (strlen(level_names[level]) == length && strncmp(name, level_names[level], length) == 0) return level;
+    return -1;
+}
+
+/**
+ * @brief State of the remote name request of one inquiry candidate.
+ */
+typedef struct {
+    bdaddr_t bdaddr;                /**< Address of the candidate */
+    int dev_id;                     /**< Adapter used for the request */
+    char name[248];                 /**< Resolved name */
+    atomic_bool done;               /**< Set by the thread when the request has finished */
+    bool reported;                  /**< Result already evaluated by the inquiry loop */
+    pthread_t thread;               /**< Thread of the request */
+} NameRequest;
+
+// Jeder Namensabruf hat seinen eigenen HCI-Socket, damit die Abfragen parallel laufen
+static void* resolve_name(void* arg) {
+    NameRequest* request = (NameRequest*)arg;
+    int dd = hci_open_dev(request->dev_id);
+    if (dd < 0 || hci_read_remote_name(dd, &request->bdaddr, sizeof(request->name), request->name, NAME_TIMEOUT_MS) < 0)
+        strcpy(request->name, "[unbekannt]");
+    if (dd >= 0) hci_close_dev(dd);
+    atomic_store(&request->done, true);
+    return NULL;
+}
+
+void default_adapter_address(char* address) {
+    bdaddr_t bdaddr;
+    int dev_id = hci_get_route(NULL);
+    address[0] = 0;
+    if (dev_id >= 0 && hci_devba(dev_id, &bdaddr) == 0) ba2str(&bdaddr, address);
+}
+
+/**
+ * @brief Tries the boards of the discovery cache with a direct connect.
+ *
+ * @return 0 if a cached board answered (`mac` and `control_sock` are set), -1 otherwise.
+ */
+static int connect_cached_board(WiiBalanceBoard* board, const char* adapter) {
+    KnownBoard known[CACHE_MAX_BOARDS];
+    int count = load_known_boards(known, CACHE_MAX_BOARDS);
+    int probes = 0;
+
+    for (int i = 0; i < count && probes < CACHE_MAX_PROBES; i++) {
+        // Nur Boards, die an diesem Adapter gesehen wurden
+        if (adapter[0] && known[i].adapter[0] && strcasecmp(known[i].adapter, adapter) != 0) continue;
+        probes++;
+        fprintf(stderr, "Versuche bekanntes Board %s\n", known[i].mac);
+        int sock = try_connect_l2cap(known[i].mac, 0x11, CACHE_CONNECT_TIMEOUT_MS);
+        if (sock < 0) continue;
+        strcpy(board->mac, known[i].mac);
+        board->control_sock = sock;
+        fprintf(stderr, "Wii Balance Board gefunden: %s (Cache)\n", board->mac);
+        remember_board(board->mac, adapter);
+        return 0;
+    }
+    return -1;
+}
+
+// Kandidaten sind Geräte der Klasse "Peripherie" (Wii Remote und Balance Board: 0x002504)
+static bool is_candidate(const uint8_t* dev_class) {
+    return (dev_class[1] & 0x1f) == 0x05;
 }
 
 int find_wii_balance_board(WiiBalanceBoard* board) {
-    inquiry_info *ii = NULL;
-    int max_rsp, num_rsp;
-    int dev_id, sock, len, flags;
-    char addr[19] = { 0 };
-    char name[248] = { 0 };
-
-    dev_id = hci_get_route(NULL);
-    sock = hci_open_dev(dev_id);
-    if (dev_id < 0 || sock < 0) {
+    char adapter[19];
+    default_adapter_address(adapter);
+    if (connect_cached_board(board, adapter) == 0) return 0;
+
+    int dev_id = hci_get_route(NULL);
+    int dd = hci_open_dev(dev_id);
+    if (dev_id < 0 || dd < 0) {
         perror("Fehler beim Öffnen des lokalen Bluetooth-Geräts");
         return -1;
     }
 
-    len = 8;
-    max_rsp = 255;
-    flags = IREQ_CACHE_FLUSH;
-    ii = (inquiry_info*)malloc(max_rsp * sizeof(inquiry_info));
+    // Nur die Ereignisse der Abfrage empfangen
+    struct hci_filter filter;
+    hci_filter_clear(&filter);
+    hci_filter_set_ptype(HCI_EVENT_PKT, &filter);
+    hci_filter_set_event(EVT_INQUIRY_RESULT, &filter);
+    hci_filter_set_event(EVT_INQUIRY_RESULT_WITH_RSSI, &filter);
+    hci_filter_set_event(EVT_EXTENDED_INQUIRY_RESULT, &filter);
+    hci_filter_set_event(EVT_INQUIRY_COMPLETE, &filter);
+    if (setsockopt(dd, SOL_HCI, HCI_FILTER, &filter, sizeof(filter)) < 0) {
+        perror("Fehler beim Setzen des HCI-Filters");
+        hci_close_dev(dd);
+        return -1;
+    }
 
-    num_rsp = hci_inquiry(dev_id, len, max_rsp, NULL, &ii, flags);
-    if (num_rsp < 0) {
+    // Abfrage starten (GIAC), die Ergebnisse kommen als Ereignisse, während sie läuft
+    inquiry_cp inquiry = { .lap = { 0x33, 0x8b, 0x9e }, .length = INQUIRY_LENGTH, .num_rsp = 0 };
+    if (hci_send_cmd(dd, OGF_LINK_CTL, OCF_INQUIRY, INQUIRY_CP_SIZE, &inquiry) < 0) {
         perror("Fehler bei der Bluetooth-Abfrage");
-        close(sock);
-        free(ii);
+        hci_close_dev(dd);
         return -1;
     }
 
-    for (int i = 0; i < num_rsp; i++) {
-        ba2str(&(ii+i)->bdaddr, addr);
-        if (hci_read_remote_name(sock, &(ii+i)->bdaddr, sizeof(name), name, 0) < 0)
-            strcpy(name, "[unbekannt]");
+    NameRequest* requests = calloc(MAX_NAME_REQUESTS, sizeof(NameRequest));
+    bdaddr_t seen[255];
+    int seen_count = 0, request_count = 0;
+    bool inquiring = true, found = false;
+    uint64_t deadline = monotonic_ns() + (uint64_t)(INQUIRY_LENGTH * 1280 + NAME_TIMEOUT_MS + 1000) * 1000000ull;
+
+    while (!found && monotonic_ns() < deadline) {
+        // Fertig, wenn die Abfrage beendet ist und alle Namen aufgelöst sind
+        bool pending = false;
+        for (int i = 0; i < request_count; i++) pending |= !requests[i].reported;
+        if (!inquiring && !pending) break;
+
+        struct pollfd pfd = { .fd = dd, .events = POLLIN };
+        if (poll(&pfd, 1, 50) > 0) {
+            unsigned char event[HCI_MAX_EVENT_SIZE];
+            ssize_t length = read(dd, event, sizeof(event));
+            if (length >= 1 + HCI_EVENT_HDR_SIZE + 1 && event[0] == HCI_EVENT_PKT) {
+                hci_event_hdr* header = (hci_event_hdr*)(event + 1);
+                unsigned char* data = event + 1 + HCI_EVENT_HDR_SIZE;
+                int results = 0;
+                size_t size = 0;
 
-        printf("Gefundenes Gerät: %s (%s)\n", addr, name);
+                switch (header->evt) {
+                    case EVT_INQUIRY_COMPLETE: inquiring = false; break;
+                    case EVT_INQUIRY_RESULT: results = data[0]; size = INQUIRY_INFO_SIZE; break;
+                    case EVT_INQUIRY_RESULT_WITH_RSSI: results = data[0]; size = INQUIRY_INFO_WITH_RSSI_SIZE; break;
+                    case EVT_EXTENDED_INQUIRY_RESULT: results = data[0]; size = EXTENDED_INQUIRY_INFO_SIZE; break;
+                }
+
+                for (int r = 0; r < results && 1 + (r + 1) * size <= (size_t)(length - 1 - HCI_EVENT_HDR_SIZE); r++) {
+                    unsigned char* result = data + 1 + r * size;
+                    bdaddr_t bdaddr;
+                    memcpy(&bdaddr, result, sizeof(bdaddr));
+                    // Klasse liegt je nach Ereignis hinter 2 oder 3 Bytes Scan-Modus
+                    const uint8_t* dev_class = result + 6 + (header->evt == EVT_INQUIRY_RESULT ? 3 : 2);
+
+                    bool known = false;
+                    for (int i = 0; i < seen_count; i++) known |= (bacmp(&seen[i], &bdaddr) == 0);
+                    if (known || seen_count == 255) continue;
+                    seen[seen_count++] = bdaddr;
+
+                    char addr[19];
+                    ba2str(&bdaddr, addr);
+                    if (!is_candidate(dev_class) || request_count == MAX_NAME_REQUESTS) {
+                        fprintf(stderr, "Gefundenes Gerät: %s (Klasse %02x%02x%02x)\n", addr, dev_class[2], dev_class[1], dev_class[0]);
+                        continue;
+                    }
+                    NameRequest* request = &requests[request_count];
+                    request->bdaddr = bdaddr;
+                    request->dev_id = dev_id;
+                    atomic_init(&request->done, false);
+                    if (pthread_create(&request->thread, NULL, resolve_name, request) == 0) request_count++;
+                }
+            }
+        }
 
-        if (strcmp(name, "Nintendo RVL-WBC-01") == 0) {
-            strcpy(board->mac, addr);
-            printf("Wii Balance Board gefunden: %s\n", board->mac);
-            close(sock);
-            free(ii);
-            return 0; // Erfolg
+        // Aufgelöste Namen auswerten
+        for (int i = 0; i < request_count && !found; i++) {
+            NameRequest* request = &requests[i];
+            if (request->reported || !atomic_load(&request->done)) continue;
+            request->reported = true;
+            char addr[19];
+            ba2str(&request->bdaddr, addr);
+            fprintf(stderr, "Gefundenes Gerät: %s (%s)\n", addr, request->name);
+            if (strcmp(request->name, "Nintendo RVL-WBC-01") == 0) {
+                strcpy(board->mac, addr);
+                found = true;
+            }
         }
     }
 
-    close(sock);
-    free(ii);
-    return -1; // Gerät nicht gefunden
+    // Laufende Abfrage abbrechen, sobald das Board gefunden ist
+    if (inquiring) hci_send_cmd(dd, OGF_LINK_CTL, OCF_INQUIRY_CANCEL, 0, NULL);
+    for (int i = 0; i < request_count; i++) pthread_join(requests[i].thread, NULL);
+    free(requests);
+    hci_close_dev(dd);
+
+    if (!found) return -1; // Gerät nicht gefunden
+    fprintf(stderr, "Wii Balance Board gefunden: %s\n", board->mac);
+    remember_board(board->mac, adapter);
+    return 0; // Erfolg
 }
 
-void send_command(int sock, const unsigned char* command, int length) {
-    if (send(sock, command, length, 0) < 0) {
+int send_command(int sock, const unsigned char* command, int length) {
+    // MSG_NOSIGNAL: eine getrennte Verbindung darf den Prozess nicht per SIGPIPE beenden
+    if (send(sock, command, length, MSG_NOSIGNAL) < 0) {
         perror("Fehler beim Senden des Befehls");
-        exit(1);
+        return -1;
     }
+    return 0;
 }
 
-int connect_l2cap(const char* bdaddr_str, uint16_t psm) {
+int try_connect_l2cap(const char* bdaddr_str, uint16_t psm, int timeout_ms) {
     struct sockaddr_l2 addr = { 0 };
     int sock = socket(AF_BLUETOOTH, SOCK_SEQPACKET, BTPROTO_L2CAP);
-    if (sock < 0) {
-        perror("Fehler beim Erstellen des Sockets");
-        exit(1);
-    }
+    if (sock < 0) return -1;
 
     addr.l2_family = AF_BLUETOOTH;
     addr.l2_psm = htobs(psm);
     str2ba(bdaddr_str, &addr.l2_bdaddr);
 
-    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    if (timeout_ms < 0) {
+        if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0) return sock;
+    } else {
+        // Nicht blockierend verbinden und höchstens timeout_ms auf das Ergebnis warten
+        int flags = fcntl(sock, F_GETFL, 0);
+        fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+        if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0 || errno == EINPROGRESS) {
+            struct pollfd pfd = { .fd = sock, .events = POLLOUT };
+            int error = 0;
+            socklen_t length = sizeof(error);
+            int ready = poll(&pfd, 1, timeout_ms);
+            if (ready > 0 && getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+                fcntl(sock, F_SETFL, flags);
+                return sock;
+            }
+            errno = ready == 0 ? ETIMEDOUT : error;
+        }
+    }
+
+    int saved = errno;
+    close(sock);
+    errno = saved;
+    return -1;
+}
+
+int connect_l2cap(const char* bdaddr_str, uint16_t psm) {
+    int sock = try_connect_l2cap(bdaddr_str, psm, -1);
+    if (sock < 0) {
         perror("Fehler beim Herstellen der Verbindung");
+        exit(1);
+    }
+    return sock;
+}
+
+int connect_simulator(const char* dir, const char* bdaddr_str, uint16_t psm) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/%s.%02x", dir, bdaddr_str, psm) >= (int)sizeof(addr.sun_path)) {
+        fprintf(stderr, "Fehler: Pfad des Simulators zu lang\n");
+        exit(1);
+    }
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        perror("Fehler beim Erstellen des Sockets");
+        exit(1);
+    }
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("Fehler beim Verbinden mit dem Simulator");
         close(sock);
         exit(1);
     }
@@ -156,71 +466,820 @@ int connect_l2cap(const char* bdaddr_str, uint16_t psm) {
 }
 
 
-void handle_status(WiiBalanceBoard* board) {
-    send_command(board->control_sock, status_command, sizeof(status_command));
-    board->needStatus = false;
-    print_info(&debug_level, "Hole Status", 0, 0, 0);
+/**
+ * @brief One entry of the table driving the init sequence.
+ */
+typedef struct {
+    const unsigned char* command;   /**< Command bytes */
+    int length;                     /**< Number of command bytes */
+    size_t flag;                    /**< Offset of the request flag in `WiiBalanceBoard` */
+    unsigned char reply;            /**< Report answering the command (0x22, 0x20 or 0x21) */
+    uint8_t packets;                /**< Number of reply packets */
+    const char* message;            /**< Log message */
+} InitCommand;
+
+// Reihenfolge wie bisher in main_loop(): Status, Kalibrierung, LED, Aktivierung, Dump
+static const InitCommand init_commands[INIT_STEPS] = {
+    [INIT_STATUS] = { status_command, sizeof(status_command), offsetof(WiiBalanceBoard, needStatus), 0x22, 1, "Hole Status" },
+    [INIT_CALIBRATION] = { calibration_command, sizeof(calibration_command), offsetof(WiiBalanceBoard, needCalibration), 0x21, 2, "Hole Kalibrierungsdaten" },
+    [INIT_LED] = { led_on_command, sizeof(led_on_command), offsetof(WiiBalanceBoard, needLed), 0x22, 1, "Schalte LED an" },
+    [INIT_ACTIVATION] = { activate_command, sizeof(activate_command), offsetof(WiiBalanceBoard, needActivation), 0x22, 1, "Sende Aktivierung" },
+    [INIT_DUMP] = { data_dump_command, sizeof(data_dump_command), offsetof(WiiBalanceBoard, needDumpStart), 0x20, 1, "Starte Dump" }
+};
+
+static bool* init_flag(WiiBalanceBoard* board, int step) {
+    return (bool*)((char*)board + init_commands[step].flag);
+}
+
+// Neue Verbindung: alle Antworten und Zeiten zurücksetzen
+static void start_init(WiiBalanceBoard* board, uint64_t now) {
+    memset(&board->init, 0, sizeof(board->init));
+    board->init.started_ns = now;
+}
+
+// Zeit bis zum ersten Report ausgeben, sobald alle Antworten da sind
+static void report_init(WiiBalanceBoard* board) {
+    InitTracker* init = &board->init;
+    if (init->reported || init->waiting != 0 || init->first_sample_ns == 0) return;
+    init->reported = true;
+    if (init->sent == 0) return; // Wiedergabe: keine Init-Sequenz gesendet
+
+    unsigned retries = 0;
+    for (int step = 0; step < INIT_STEPS; step++) retries += init->retries[step];
+    fprintf(stderr, "Init von %s: erster Report nach %.1f ms, alle Antworten nach %.1f ms, %u Wiederholungen\n",
+            board->mac, (init->first_sample_ns - init->started_ns) / 1e6,
+            (init->done_ns - init->started_ns) / 1e6, retries);
 }
 
-void handle_calibration(WiiBalanceBoard* board) {
-    send_command(board->control_sock, calibration_command, sizeof(calibration_command));
-    board->needCalibration = false;
-    print_info(&debug_level, "Hole Kalibrierungsdaten", 0, 0, 0);
+static void finish_init_command(WiiBalanceBoard* board, int step, uint64_t now, bool confirmed) {
+    board->init.waiting &= ~(1u << step);
+    if (step == INIT_LED) board->led = confirmed;
+    if (board->init.waiting == 0) board->init.done_ns = now;
+    report_init(board);
 }
 
-void handle_led_on(WiiBalanceBoard* board) {
-    send_command(board->control_sock, led_on_command, sizeof(led_on_command));
-    board->led = true;
-    print_info(&debug_level, "Schalte LED an", 0, 0, 0);
+// Kommando im nächsten Durchlauf von main_loop() erneut senden oder nach INIT_MAX_RETRIES aufgeben
+static void retry_init_command(WiiBalanceBoard* board, int step, const char* reason, uint64_t now) {
+    if (board->init.retries[step] < INIT_MAX_RETRIES) {
+        board->init.retries[step]++;
+        board->init.waiting &= ~(1u << step);
+        *init_flag(board, step) = true;
+        return;
+    }
+    fprintf(stderr, "%s: Kommando 0x%02x (%s) nach %d Wiederholungen aufgegeben, %s\n", board->mac,
+            init_commands[step].command[1], init_commands[step].message, INIT_MAX_RETRIES, reason);
+    finish_init_command(board, step, now, false);
+}
+
+void handle_send_command(WiiBalanceBoard* board, InitStep step) {
+    const InitCommand* entry = &init_commands[step];
+    // Ein Sendefehler wird wie eine verlorene Antwort wiederholt
+    board->transport->send(board, entry->command, entry->length);
+    *init_flag(board, step) = false;
+    board->init.waiting |= 1u << step;
+    board->init.sent |= 1u << step;
+    board->init.packets[step] = entry->packets;
+    board->init.sent_ns[step] = monotonic_ns();
+}
+
+void send_init_commands(WiiBalanceBoard* board) {
+    // Alle anstehenden Kommandos direkt hintereinander, die Antworten werden nicht abgewartet
+    for (int step = 0; step < INIT_STEPS; step++)
+        if (*init_flag(board, step)) handle_send_command(board, (InitStep)step);
+}
+
+void track_init_reply(WiiBalanceBoard* board, const ReportView* report, uint64_t received_ns) {
+    InitTracker* init = &board->init;
+    if (report->kind == REPORT_DATA) {
+        if (init->first_sample_ns == 0) init->first_sample_ns = received_ns;
+        report_init(board);
+        return;
+    }
+
+    for (int step = 0; step < INIT_STEPS; step++) {
+        const InitCommand* entry = &init_commands[step];
+        if (!(init->waiting & (1u << step)) || report->kind == REPORT_INVALID || entry->reply != report->id) continue;
+        int error = 0;
+        if (report->kind == REPORT_ACK) {
+            // RR ist das bestätigte Kommando, EE der Fehlercode
+            if (report->ack.command != entry->command[1]) continue;
+            error = report->ack.error;
+        } else if (report->kind == REPORT_READ) {
+            error = report->read.error;
+        }
+        if (error != 0) {
+            char reason[32];
+            snprintf(reason, sizeof(reason), "Fehlercode %d", error);
+            retry_init_command(board, step, reason, received_ns);
+        } else if (--init->packets[step] == 0) {
+            finish_init_command(board, step, received_ns, true);
+        }
+        return;
+    }
 }
 
-void handle_activation(WiiBalanceBoard* board) {
-    send_command(board->control_sock, activate_command, sizeof(activate_command));
-    board->needActivation = false;
-    print_info(&debug_level, "Sende Aktivierung", 0, 0, 0);
+void check_init_replies(WiiBalanceBoard* board, uint64_t now) {
+    for (int step = 0; step < INIT_STEPS; step++)
+        if ((board->init.waiting & (1u << step)) && now - board->init.sent_ns[step] > INIT_REPLY_TIMEOUT_MS * 1000000ull)
+            retry_init_command(board, step, "keine Antwort", now);
+}
+
+// Schwankungszeile nach (oder anstelle) der Datenzeile
+static void print_sway(const WiiBalanceBoard* board, bool valid, TextWriter* out) {
+    char* p = print_board_tag(board, writer_reserve(out, WRITER_LINE_MAX + SWAY_LINE_MAX));
+    writer_commit(out, sway_format(&board->sway, valid, p));
+}
+
+// Records der abgelaufenen Fenster, nur mit dem Index des Boards (die Zeit steht im Record)
+static void print_due_windows(WiiBalanceBoard* board, uint64_t now, TextWriter* out) {
+    int index;
+    while ((index = aggregate_due(&aggregate_config, &board->aggregate, now)) >= 0) {
+        char* p = writer_reserve(out, WRITER_LINE_MAX + AGGREGATE_LINE_MAX);
+        if (board->id >= 0) {
+            *p++ = '[';
+            p = format_u32(p, (uint32_t)board->id);
+            p = format_text(p, "] ");
+        }
+        writer_commit(out, aggregate_format(&board->aggregate.window[index], aggregate_config.size_ms[index], p));
+        aggregate_close(&aggregate_config, &board->aggregate, index);
+    }
 }
 
-void handle_data_dump(WiiBalanceBoard* board) {
-    send_command(board->control_sock, data_dump_command, sizeof(data_dump_command));
-    board->needDumpStart = false;
-    print_info(&debug_level, "Starte Dump", 0, 0, 0);
+// Text eines Reports: Datenzeile, Schwankungszeile oder die Records der abgelaufenen Fenster
+static void print_report_text(const ReportView* report, WiiBalanceBoard* board, TextWriter* out) {
+    // Nur kalibrierte Massen ergeben einen Druckmittelpunkt bzw. gehen in die Fenster ein
+    bool sway = sway_output != SWAY_OFF && report->kind == REPORT_DATA && board->calibrated;
+    bool valid = sway && sway_update(&board->sway, report->data.mass, board->received_ns);
+    bool aggregate = aggregate_config.count != 0 && report->kind == REPORT_DATA && board->calibrated;
+    if (aggregate) {
+        print_due_windows(board, board->received_ns, out);
+        aggregate_add(&aggregate_config, &board->aggregate, report->data.mass, board->received_ns);
+    } else if (!sway || sway_output == SWAY_ADD) {
+        print_info(report, board, out);
+    }
+    if (sway) print_sway(board, valid, out);
 }
 
-void process_received_data(int bytes_read, unsigned char* buffer, WiiBalanceBoard* board) {
-    if (bytes_read > 1) {
-        print_info(&debug_level, "Empfangene Daten: ", buffer, bytes_read, board);
-        if (buffer[1] == 0x32 && buffer[3] == 0x08) board->is_running = 0;
-        #ifdef YAWIIBB_EXTENDED
-        if (buffer[1]== 0x21) process_calibration_data(&bytes_read, buffer, board);
-        #endif // YAWIIBB_EXTENDED
+void process_received_data(const ReportView* report, WiiBalanceBoard* board, TextWriter* text) {
+    if (report->length > 1) {
+        if (output_format == OUTPUT_BINARY) write_binary_sample(report, board);
+        // Im Shared-Memory-Modus ist stdout frei, dort erscheinen die übrigen Reports als Text
+        else if (output_format != OUTPUT_SHM || !publish_shm_sample(report, board)) print_report_text(report, board, text);
+        // Power-Taste: nur das Bit der Taste in Byte 3 gesetzt
+        if (report->kind == REPORT_DATA && (report->buttons & 0x00ff) == REPORT_BUTTON_A) board->is_running = 0;
+        if (report->kind == REPORT_READ) process_calibration_data(report, board);
     } else {
         perror("Fehler beim Empfangen der Daten");
         board->is_running = 0;
     }
 }
 
+uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
 
-void* threadFunction(void* arg) {
-    WiiBalanceBoard* board = (WiiBalanceBoard*)arg;  // Typumwandlung
-    char ch;
+uint64_t realtime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Abstand zum vorigen 0x32-Report, Lücken und Duplikate
+static void record_interval(WiiBalanceBoard* board, const unsigned char* data, uint64_t received_ns) {
+    ReportStats* stats = &board->stats;
+    if (stats->last_sample_ns != 0 && received_ns >= stats->last_sample_ns) {
+        uint64_t interval = received_ns - stats->last_sample_ns;
+        histogram_record(&stats->interval, interval);
+        if (stats->period_ns != 0 && interval > GAP_FACTOR * stats->period_ns) {
+            stats->gaps++;
+        } else if (stats->period_ns != 0 && interval < stats->period_ns / 2 &&
+                   memcmp(stats->last_data, data + 2, sizeof(stats->last_data)) == 0) {
+            stats->duplicates++;
+        } else if (stats->period_ns == 0) {
+            stats->period_ns = interval;
+        } else {
+            // Gleitender Mittelwert, ein neuer Abstand zählt 2^-PERIOD_SMOOTHING
+            stats->period_ns = stats->period_ns - (stats->period_ns >> PERIOD_SMOOTHING) + (interval >> PERIOD_SMOOTHING);
+        }
+    }
+    stats->last_sample_ns = received_ns;
+    memcpy(stats->last_data, data + 2, sizeof(stats->last_data));
+}
+
+int setup_event_loop(BoardDaemon* daemon) {
+    daemon->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (daemon->epoll_fd < 0) {
+        perror("Fehler beim Erstellen der epoll-Instanz");
+        return -1;
+    }
+
+    // Periodischer Timer für zeitgesteuerte Arbeit (z.B. is_running prüfen)
+    daemon->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (daemon->timer_fd < 0) {
+        perror("Fehler beim Erstellen des Timers");
+        close(daemon->epoll_fd);
+        return -1;
+    }
+    // Der Watchdog braucht einen feineren Takt, damit ein Stillstand rechtzeitig auffällt
+    long tick_ms = TIMER_INTERVAL_MS;
+    if (daemon->watchdog_ms > 0 && daemon->watchdog_ms / 4 < tick_ms) tick_ms = daemon->watchdog_ms / 4 > 0 ? daemon->watchdog_ms / 4 : 1;
+    struct itimerspec interval = {
+        .it_interval = { .tv_sec = 0, .tv_nsec = tick_ms * 1000000L },
+        .it_value = { .tv_sec = 0, .tv_nsec = tick_ms * 1000000L }
+    };
+    timerfd_settime(daemon->timer_fd, 0, &interval, NULL);
+
+    struct epoll_event ev = { .events = EPOLLIN };
+    ev.data.ptr = NULL; // NULL kennzeichnet den Timer
+    if (epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, daemon->timer_fd, &ev) < 0) {
+        perror("Fehler beim Registrieren des Timers");
+        return -1;
+    }
+
+    l2cap_transport_init();
+
+    for (int i = 0; i < daemon->count; i++) {
+        WiiBalanceBoard* board = &daemon->boards[i];
+        // Empfangssocket nicht blockierend, damit drain_receive_sock() bis EAGAIN lesen kann
+        int flags = fcntl(board->receive_sock, F_GETFL, 0);
+        if (flags < 0 || fcntl(board->receive_sock, F_SETFL, flags | O_NONBLOCK) < 0) {
+            perror("Fehler beim Umschalten des Sockets auf nicht blockierend");
+            return -1;
+        }
+        if (board->transport->prepare != NULL) board->transport->prepare(board);
+        ev.data.ptr = board;
+        if (epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, board->receive_sock, &ev) < 0) {
+            perror("Fehler beim Registrieren des Sockets");
+            return -1;
+        }
+        board->state = BOARD_CONNECTED;
+        board->last_report_ns = monotonic_ns();
+        board->reconnect_delay_ms = RECONNECT_MIN_MS;
+        start_init(board, board->last_report_ns);
+    }
+    return 0;
+}
+
+void close_board(BoardDaemon* daemon, WiiBalanceBoard* board) {
+    if (board->receive_sock >= 0) {
+        epoll_ctl(daemon->epoll_fd, EPOLL_CTL_DEL, board->receive_sock, NULL);
+        close(board->receive_sock);
+        board->receive_sock = -1;
+    }
+    if (board->control_sock >= 0) {
+        // Während eines Reconnects kann auch der Kontrollkanal registriert sein
+        epoll_ctl(daemon->epoll_fd, EPOLL_CTL_DEL, board->control_sock, NULL);
+        close(board->control_sock);
+        board->control_sock = -1;
+    }
+    board->is_running = false;
+
+    // Daemon beenden, sobald kein Board mehr läuft
+    for (int i = 0; i < daemon->count; i++)
+        if (daemon->boards[i].is_running) return;
+    daemon->is_running = false;
+}
+
+void drain_receive_sock(BoardDaemon* daemon, WiiBalanceBoard* board) {
+    int count = 0;
+    // Abstand von CLOCK_REALTIME zu CLOCK_MONOTONIC einmal pro Durchlauf
+    int64_t realtime_offset = (int64_t)(realtime_ns() - monotonic_ns());
+    bool drained = false;
+
+    while (board->is_running && count < MAX_DRAIN_REPORTS && !drained) {
+        // Direkt in die nächsten freien Slots empfangen, der Transport füllt sie der Reihe nach
+        uint32_t wanted = MAX_DRAIN_REPORTS - count < RECEIVE_BATCH ? MAX_DRAIN_REPORTS - count : RECEIVE_BATCH;
+        uint32_t reserved = ring_reserve_many(&daemon->ring, receive_slots, wanted);
+        int received = board->transport->receive(board, receive_slots, reserved, realtime_offset, &drained);
+
+        for (int i = 0; i < received; i++) {
+            ReportSlot* slot = receive_slots[i];
+            slot->board = board;
+            // Einmal parsen, der Ausgabethread übernimmt die Felder mit dem Slot
+            ReportView* report = &slot->view;
+            parse_report(slot->data, slot->length, report);
+            if (report->kind == REPORT_DATA) record_interval(board, slot->data, slot->received_ns);
+            if (daemon->capture != NULL) capture_report(daemon->capture, board, slot->received_ns, slot->data, slot->length);
+            // Bis die Init-Sequenz beantwortet ist, auf Antworten und den ersten Report achten
+            if (board->init.waiting || !board->init.reported) track_init_reply(board, report, slot->received_ns);
+            ring_commit(&daemon->ring, slot);
+            board->last_report_ns = slot->received_ns;
+            count++;
+        }
+        if (received < 0) {
+            board_lost(daemon, board, errno != 0 ? strerror(errno) : "Verbindung getrennt");
+            break;
+        }
+    }
+
+    if (count > 0) {
+        uint64_t one = 1;
+        if (write(daemon->wake_fd, &one, sizeof(one)) < 0) perror("Fehler beim Wecken des Ausgabethreads");
+    }
+}
+
+// Öffnet einen Kanal nicht blockierend, das Ergebnis des connect() meldet epoll (EPOLLOUT)
+static int open_channel(const BoardDaemon* daemon, const WiiBalanceBoard* board, uint16_t psm) {
+    int sock;
+    int result;
+    if (daemon->simulator_dir != NULL) {
+        struct sockaddr_un addr = { .sun_family = AF_UNIX };
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/%s.%02x", daemon->simulator_dir, board->mac, psm);
+        sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (sock < 0) return -1;
+        result = connect(sock, (struct sockaddr*)&addr, sizeof(addr));
+    } else {
+        struct sockaddr_l2 addr = { 0 };
+        addr.l2_family = AF_BLUETOOTH;
+        addr.l2_psm = htobs(psm);
+        str2ba(board->mac, &addr.l2_bdaddr);
+        sock = socket(AF_BLUETOOTH, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, BTPROTO_L2CAP);
+        if (sock < 0) return -1;
+        result = connect(sock, (struct sockaddr*)&addr, sizeof(addr));
+    }
+    if (result < 0 && errno != EINPROGRESS && errno != EAGAIN) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Schließt beide Kanäle, ohne das Board zu stoppen
+static void close_channels(BoardDaemon* daemon, WiiBalanceBoard* board) {
+    int* socks[2] = { &board->control_sock, &board->receive_sock };
+    for (int i = 0; i < 2; i++) {
+        if (*socks[i] < 0) continue;
+        epoll_ctl(daemon->epoll_fd, EPOLL_CTL_DEL, *socks[i], NULL);
+        close(*socks[i]);
+        *socks[i] = -1;
+    }
+}
+
+// Nächster Versuch nach dem aktuellen Backoff, danach Backoff verdoppeln
+static void schedule_reconnect(BoardDaemon* daemon, WiiBalanceBoard* board) {
+    close_channels(daemon, board);
+    board->state = BOARD_WAITING;
+    board->reconnect_at_ns = monotonic_ns() + (uint64_t)board->reconnect_delay_ms * 1000000ull;
+    board->reconnect_delay_ms *= 2;
+    if (board->reconnect_delay_ms > RECONNECT_MAX_MS) board->reconnect_delay_ms = RECONNECT_MAX_MS;
+}
+
+// Registriert einen verbindenden Socket für EPOLLOUT
+static int watch_connect(BoardDaemon* daemon, WiiBalanceBoard* board, int sock) {
+    struct epoll_event ev = { .events = EPOLLOUT, .data.ptr = board };
+    return epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, sock, &ev);
+}
+
+void board_lost(BoardDaemon* daemon, WiiBalanceBoard* board, const char* reason) {
+    if (!daemon->reconnect) {
+        fprintf(stderr, "Verbindung zu %s verloren (%s)\n", board->mac, reason);
+        board->is_running = false;
+        return;
+    }
+    fprintf(stderr, "Verbindung zu %s verloren (%s), neuer Versuch in %u ms\n", board->mac, reason, board->reconnect_delay_ms);
+    schedule_reconnect(daemon, board);
+}
+
+// Verbindung steht wieder: Zähler zurücksetzen und die Init-Sequenz neu starten
+static void resume_board(WiiBalanceBoard* board) {
+    board->stats.last_sample_ns = 0; // Die Pause des Reconnects ist keine Funklücke
+    board->sway.previous = false;    // und kein Teil des Schwankungswegs
+    board->state = BOARD_CONNECTED;
+    board->last_report_ns = monotonic_ns();
+    board->reconnect_delay_ms = RECONNECT_MIN_MS;
+    board->reconnects++;
+    start_init(board, board->last_report_ns);
+    // Kalibrierung bleibt erhalten, nur der Dump muss neu gestartet werden
+    board->needStatus = true;
+    board->needDumpStart = true;
+    if (board->transport->prepare != NULL) board->transport->prepare(board);
+    fprintf(stderr, "Verbindung zu %s wiederhergestellt (%u. Mal)\n", board->mac, board->reconnects);
+}
+
+void continue_reconnect(BoardDaemon* daemon, WiiBalanceBoard* board) {
+    int sock = board->state == BOARD_CONNECTING_CONTROL ? board->control_sock : board->receive_sock;
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &length) < 0) error = errno;
+    if (error != 0) {
+        fprintf(stderr, "Verbindung zu %s fehlgeschlagen (%s), neuer Versuch in %u ms\n", board->mac, strerror(error), board->reconnect_delay_ms);
+        schedule_reconnect(daemon, board);
+        return;
+    }
+
+    if (board->state == BOARD_CONNECTING_CONTROL) {
+        // Kontrollkanal steht: blockierend für send_command(), weiter mit dem Datenkanal
+        epoll_ctl(daemon->epoll_fd, EPOLL_CTL_DEL, board->control_sock, NULL);
+        fcntl(board->control_sock, F_SETFL, fcntl(board->control_sock, F_GETFL, 0) & ~O_NONBLOCK);
+        board->receive_sock = open_channel(daemon, board, 0x13);
+        if (board->receive_sock < 0 || watch_connect(daemon, board, board->receive_sock) < 0) {
+            fprintf(stderr, "Verbindung zu %s fehlgeschlagen (%s), neuer Versuch in %u ms\n", board->mac, strerror(errno), board->reconnect_delay_ms);
+            schedule_reconnect(daemon, board);
+            return;
+        }
+        board->state = BOARD_CONNECTING_DATA;
+        return;
+    }
+
+    // Datenkanal steht: wieder auf eingehende Reports warten
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = board };
+    epoll_ctl(daemon->epoll_fd, EPOLL_CTL_MOD, board->receive_sock, &ev);
+    resume_board(board);
+}
+
+void check_connections(BoardDaemon* daemon) {
+    uint64_t now = monotonic_ns();
+    for (int i = 0; i < daemon->count; i++) {
+        WiiBalanceBoard* board = &daemon->boards[i];
+        if (!board->is_running) continue;
+
+        if (board->state == BOARD_CONNECTED && board->init.waiting) check_init_replies(board, now);
+        if (board->state == BOARD_CONNECTED && daemon->watchdog_ms > 0 &&
+            now - board->last_report_ns > (uint64_t)daemon->watchdog_ms * 1000000ull) {
+            char reason[64];
+            snprintf(reason, sizeof(reason), "seit %llu ms keine Daten", (unsigned long long)((now - board->last_report_ns) / 1000000ull));
+            board_lost(daemon, board, reason);
+        } else if (board->state == BOARD_WAITING && now >= board->reconnect_at_ns && board->transport->reopen != NULL) {
+            // Der Kernel hält die Verbindung, das Gerät ist sofort da oder noch nicht
+            struct epoll_event ev = { .events = EPOLLIN, .data.ptr = board };
+            if (board->transport->reopen(board) < 0 || epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, board->receive_sock, &ev) < 0) {
+                fprintf(stderr, "Verbindung zu %s fehlgeschlagen (%s), neuer Versuch in %u ms\n", board->mac, strerror(errno), board->reconnect_delay_ms);
+                schedule_reconnect(daemon, board);
+                continue;
+            }
+            resume_board(board);
+        } else if (board->state == BOARD_WAITING && now >= board->reconnect_at_ns) {
+            board->control_sock = open_channel(daemon, board, 0x11);
+            if (board->control_sock < 0 || watch_connect(daemon, board, board->control_sock) < 0) {
+                fprintf(stderr, "Verbindung zu %s fehlgeschlagen (%s), neuer Versuch in %u ms\n", board->mac, strerror(errno), board->reconnect_delay_ms);
+                schedule_reconnect(daemon, board);
+                continue;
+            }
+            board->state = BOARD_CONNECTING_CONTROL;
+        }
+    }
+}
+
+// Mit Text auf stdout bekommen die Text-Abonnenten dieselben Bytes, einmal formatiert
+static inline bool shares_text(const FanoutServer* server) {
+    return server->text_subscribers > 0 && output_format == OUTPUT_TEXT;
+}
+
+// Hängt den gesammelten Text des Servers an stdout an
+static void append_text(TextWriter* out, const TextWriter* text) {
+    char* p = writer_reserve(out, text->length);
+    memcpy(p, text->buffer, text->length);
+    writer_commit(out, p + text->length);
+}
+
+// Abgelaufene Fenster ohne neuen Wert (ruhendes oder verlorenes Board, Ende), an stdout und dieselben Bytes an die Text-Abonnenten
+static void flush_windows(BoardDaemon* daemon, uint64_t now) {
+    FanoutServer* server = daemon->server;
+    for (int i = 0; i < daemon->count; i++) {
+        bool shared = server != NULL && shares_text(server);
+        if (!shared) {
+            print_due_windows(&daemon->boards[i], now, &text_writer);
+            continue;
+        }
+        server->text.length = 0;
+        print_due_windows(&daemon->boards[i], now, &server->text);
+        append_text(&text_writer, &server->text);
+        server_publish_text(server);
+    }
+}
+
+/**
+ * @brief Report written to stdout but not yet flushed (or published but not yet signalled).
+ */
+typedef struct {
+    WiiBalanceBoard* board;         /**< Board of the report */
+    uint64_t received_ns;           /**< Reception of the report */
+} PendingReport;
+
+/**
+ * @brief Flushes stdout (or wakes the shared-memory consumers) and records the delay of 
+ *        all reports written since the last flush.
+ */
+static void commit_delays(BoardDaemon* daemon, PendingReport* pending, uint32_t* count) {
+    // Fenster ohne neuen Wert schließt die Uhr, auch wenn andere Boards den Ring nie leer werden lassen
+    if (aggregate_config.count != 0) flush_windows(daemon, monotonic_ns() - AGGREGATE_IDLE_DELAY_MS * 1000000ull);
+    if (output_format == OUTPUT_SHM) shm_ring_notify(&shm_output);
+    writer_flush(&text_writer);
+    fflush(stdout);
+    if (daemon->server != NULL) server_flush(daemon->server);
+    uint64_t flushed = monotonic_ns();
+    for (uint32_t i = 0; i < *count; i++)
+        histogram_record(&pending[i].board->stats.delay, flushed - pending[i].received_ns);
+    *count = 0;
+}
+
+// Massen eines Laufs aufeinanderfolgender Datenreports desselben Boards ab start, gibt das Ende des Laufs zurück.
+// Innerhalb des Laufs kommt keine Kalibrierantwort, die Koeffizienten bleiben also gleich.
+static uint32_t calibrate_run(ReportSlot* slots, uint32_t start, uint32_t count, SampleBlock* block) {
+    const WiiBalanceBoard* board = slots[start].board;
+    uint32_t end = start;
+    bool packed = true; // Sensoren ab Byte 4 (0x32, 0x34), nur dann passt der Batch-Kernel
+    while (end < count && slots[end].board == board && slots[end].view.kind == REPORT_DATA) {
+        packed = packed && slots[end].view.data.sensors == slots[end].data + 4;
+        end++;
+    }
+    uint32_t n = end - start;
+    if (packed && n >= OUTPUT_BATCH_MIN) {
+        decode_reports_batch(slots[start].data, sizeof(ReportSlot), n, block);
+        calibrate_block(board, block);
+        for (uint32_t i = 0; i < n; i++)
+            for (int s = 0; s < 4; s++) slots[start + i].view.data.mass[s] = block->mass[s][i];
+    } else {
+        for (uint32_t i = start; i < end; i++)
+            for (int s = 0; s < 4; s++) slots[i].view.data.mass[s] = calc_mass(board, report_sensor(&slots[i].view, s), s);
+    }
+    return end;
+}
+
+// Ein Report an alle Ausgaben
+static inline void deliver_report(BoardDaemon* daemon, const ReportView* report, WiiBalanceBoard* board) {
+    FanoutServer* server = daemon->server;
+    if (server == NULL) {
+        process_received_data(report, board, &text_writer);
+        return;
+    }
+    bool shared = shares_text(server);
+    if (shared) server->text.length = 0;
+    process_received_data(report, board, shared ? &server->text : &text_writer);
+    if (shared) append_text(&text_writer, &server->text);
+    server_publish(server, report, board, shared);
+}
+
+// Filterstufe: statt des Reports die fälligen Rasterwerte, jeder als Datenreport mit gefilterten Massen
+static void deliver_filtered(BoardDaemon* daemon, const ReportView* report, WiiBalanceBoard* board) {
+    uint64_t received_ns = board->received_ns;
+    ReportView sample = *report;
+    filter_push(&filter_config, &board->filter, report->data.mass, received_ns);
+    while (filter_next(&filter_config, &board->filter, sample.data.mass, &board->received_ns))
+        deliver_report(daemon, &sample, board);
+    board->received_ns = received_ns;
+    // Die Power-Taste gilt auch, wenn dieser Report keinen Rasterwert ergab
+    if ((report->buttons & 0x00ff) == REPORT_BUTTON_A) board->is_running = 0;
+}
+
+// Wartezeit bis AGGREGATE_IDLE_DELAY_MS nach dem Ende des nächsten offenen Fensters, -1 = ohne Frist
+static int window_wait_ms(const BoardDaemon* daemon) {
+    if (aggregate_config.count == 0) return -1;
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < daemon->count; i++) {
+        uint64_t end = aggregate_next_end(&aggregate_config, &daemon->boards[i].aggregate);
+        if (end < next) next = end;
+    }
+    if (next == UINT64_MAX) return -1;
+    uint64_t due = next + AGGREGATE_IDLE_DELAY_MS * 1000000ull, now = monotonic_ns();
+    return due <= now ? 0 : (int)((due - now + 999999) / 1000000);
+}
+
+void* output_thread(void* arg) {
+    BoardDaemon* daemon = (BoardDaemon*)arg;
+    static ReportSlot batch[OUTPUT_BATCH];
+    SampleBlock block;
+    // Höchstens so viele offene Reports wie der Ring Slots hat, dann wird vorzeitig geschrieben
+    uint32_t capacity = daemon->ring.mask + 1;
+    uint32_t count = 0;
+    PendingReport* pending = malloc(capacity * sizeof(PendingReport));
+    if (pending == NULL || sample_block_init(&block, OUTPUT_BATCH) != 0) {
+        perror("Fehler beim Anlegen der Latenzliste");
+        exit(1);
+    }
 
-    // Warten auf die Benutzereingabe
     while (true) {
-        ch = getchar();
-        if (ch == '\n') {  // Wenn nur Enter gedrückt wird
-            board->is_running = false;  // Setze die boolesche Variable auf false
-            break; 
+        // Umschalten nur zwischen zwei Reports, danach druckt jedes Board wieder ohne Fallunterscheidung
+        if (level_requested >= 0) {
+            LogLevel level = (LogLevel)level_requested;
+            level_requested = -1;
+            for (int i = 0; i < daemon->count; i++) set_log_level(&daemon->boards[i], level);
+            fprintf(stderr, "Log-Level: %s\n", level_names[level]);
+        }
+        while (true) {
+            uint32_t popped = 0;
+            while (popped < OUTPUT_BATCH && ring_pop(&daemon->ring, &batch[popped])) {
+                // Beim Empfang geparst, die Zeiger zeigen noch in den Ring-Slot
+                report_rebase(&batch[popped].view, batch[popped].data);
+                popped++;
+            }
+            if (popped == 0) break;
+
+            uint32_t calibrated = 0;
+            for (uint32_t i = 0; i < popped; i++) {
+                ReportSlot* report = &batch[i];
+                WiiBalanceBoard* board = report->board;
+                board->received_ns = report->received_ns;
+                if (i >= calibrated && report->view.kind == REPORT_DATA) calibrated = calibrate_run(batch, i, popped, &block);
+                if (filter_config.rate != 0 && report->view.kind == REPORT_DATA && board->calibrated)
+                    deliver_filtered(daemon, &report->view, board);
+                else
+                    deliver_report(daemon, &report->view, board);
+
+                pending[count].board = board;
+                pending[count].received_ns = report->received_ns;
+                // Bei Dauerlast läuft der Ring nie leer, dann spätestens nach OUTPUT_FLUSH_MS schreiben
+                if (++count == capacity ||
+                    (count % OUTPUT_FLUSH_CHECK == 0 &&
+                     monotonic_ns() - pending[0].received_ns > OUTPUT_FLUSH_MS * 1000000ull))
+                    commit_delays(daemon, pending, &count);
+            }
+        }
+        // Ring leer: einmal schreiben und Latenz erfassen
+        commit_delays(daemon, pending, &count);
+
+        if (atomic_load(&daemon->ring.closed) &&
+            atomic_load(&daemon->ring.tail) == atomic_load(&daemon->ring.head)) break;
+
+        // Mit Server wird während des Wartens auch der Socket bedient
+        int timeout_ms = window_wait_ms(daemon);
+        if (daemon->server != NULL) {
+            if (server_wait(daemon->server, daemon->wake_fd, timeout_ms) < 0) break;
+            continue;
+        }
+        struct pollfd wake = { .fd = daemon->wake_fd, .events = POLLIN };
+        int ready = poll(&wake, 1, timeout_ms);
+        uint64_t wakeups;
+        if ((ready < 0 && errno != EINTR) ||
+            (ready > 0 && read(daemon->wake_fd, &wakeups, sizeof(wakeups)) < 0 && errno != EINTR)) {
+            perror("Fehler beim Warten auf Reports");
+            break;
+        }
+    }
+    // Angefangene Fenster beim Beenden noch ausgeben
+    if (aggregate_config.count != 0) flush_windows(daemon, UINT64_MAX);
+    writer_flush(&text_writer);
+    sample_block_free(&block);
+    free(pending);
+    return NULL;
+}
+
+void createOutputThread(BoardDaemon* daemon, uint32_t slots, DropPolicy policy, pthread_t* threadId) {
+    daemon->wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (daemon->wake_fd < 0 || ring_init(&daemon->ring, slots, policy) != 0) {
+        perror("Fehler beim Anlegen des Report-Rings");
+        exit(1);
+    }
+    if (writer_init(&text_writer, WRITER_BUFFER_SIZE, stdout) != 0) {
+        perror("Fehler beim Anlegen des Ausgabepuffers");
+        exit(1);
+    }
+    if (pthread_create(threadId, NULL, output_thread, (void*)daemon) != 0) {
+        perror("Fehler beim Erstellen des Ausgabethreads");
+        exit(1);
+    }
+}
+
+void stopOutputThread(BoardDaemon* daemon, pthread_t threadId) {
+    uint64_t one = 1;
+    atomic_store(&daemon->ring.closed, true);
+    if (write(daemon->wake_fd, &one, sizeof(one)) < 0) perror("Fehler beim Wecken des Ausgabethreads");
+    pthread_join(threadId, NULL);
+
+    fprintf(stderr, "Report-Ring: %u Slots, max. Füllstand %llu, %llu Überläufe (%s verworfen)\n",
+            daemon->ring.mask + 1, (unsigned long long)daemon->ring.high_water,
+            (unsigned long long)atomic_load(&daemon->ring.overflows),
+            daemon->ring.policy == DROP_OLDEST ? "älteste" : "neueste");
+    ring_free(&daemon->ring);
+    writer_free(&text_writer);
+    close(daemon->wake_fd);
+}
+
+void print_report_stats(const WiiBalanceBoard* board) {
+    const ReportStats* stats = &board->stats;
+    if (stats->kernel_stamps + stats->fallback_stamps == 0) return;
+    char prefix[16] = "";
+    if (board->id >= 0) snprintf(prefix, sizeof(prefix), "[%d] ", board->id);
+    char label[64];
+
+    fprintf(stderr, "%sZeitstempel: %llu vom Kernel, %llu nach dem Empfang\n", prefix,
+            (unsigned long long)stats->kernel_stamps, (unsigned long long)stats->fallback_stamps);
+    fprintf(stderr, "%sEmpfang über %s: %llu Aufrufe, %.2f Reports pro Aufruf\n", prefix,
+            board->transport->name, (unsigned long long)stats->receive_calls,
+            (double)(stats->kernel_stamps + stats->fallback_stamps) / (stats->receive_calls ? stats->receive_calls : 1));
+    snprintf(label, sizeof(label), "%sAbstand der Reports", prefix);
+    histogram_print(&stats->interval, label, 1e6, "ms", stderr);
+    fprintf(stderr, "%sLücken (> %d Perioden von %.3f ms): %llu, Duplikate: %llu\n", prefix, GAP_FACTOR,
+            stats->period_ns / 1e6, (unsigned long long)stats->gaps, (unsigned long long)stats->duplicates);
+    snprintf(label, sizeof(label), "%sLatenz Empfang->Ausgabe", prefix);
+    histogram_print(&stats->delay, label, 1e3, "us", stderr);
+    if (sway_output != SWAY_OFF) sway_print(&board->sway, prefix, stderr);
+    if (filter_config.rate != 0) filter_print(&board->filter, prefix, stderr);
+    if (aggregate_config.count != 0) aggregate_print(&board->aggregate, prefix, stderr);
+}
+
+void print_receive_stats(const BoardDaemon* daemon) {
+    uint64_t reports = 0, calls = 0;
+    for (int i = 0; i < daemon->count; i++) {
+        reports += daemon->boards[i].stats.kernel_stamps + daemon->boards[i].stats.fallback_stamps;
+        calls += daemon->boards[i].stats.receive_calls;
+    }
+    if (reports == 0) return;
+    uint64_t cpu = thread_cpu_ns() - daemon->loop_cpu_ns;
+    fprintf(stderr, "Empfangsthread: %llu Reports, %.3f Empfangsaufrufe und %.0f ns CPU pro Report\n",
+            (unsigned long long)reports, (double)calls / reports, (double)cpu / reports);
+}
+
+void write_binary_header(int board_count) {
+    unsigned char header[YAWIIBB_BINARY_HEADER_SIZE];
+    binary_encode_header(header, (uint32_t)board_count);
+    fwrite(header, sizeof(header), 1, stdout);
+    fflush(stdout);
+}
+
+bool build_binary_sample(const ReportView* report, const WiiBalanceBoard* board, BinarySample* sample) {
+    if (report->kind != REPORT_DATA) return false;
+
+    *sample = (BinarySample){
+        .timestamp_ns = board->received_ns,
+        .board_id = board->id < 0 ? 0 : (uint16_t)board->id,
+        .report_type = report->id,
+        .flags = (report->buttons & REPORT_BUTTON_A) ? BINARY_FLAG_BUTTON : 0
+    };
+    // TR, BR, TL, BL jeweils Big Endian
+    for (int i = 0; i < 4; i++) sample->raw[i] = report_sensor(report, i);
+    if (board->calibrated) {
+        for (int i = 0; i < 4; i++) sample->mass[i] = report->data.mass[i];
+        sample->flags |= BINARY_FLAG_MASS_VALID;
+        // Kalibrierte Datenreports erreichen die Ausgabe mit Filterstufe nur als gefilterte Werte
+        if (filter_config.rate != 0) sample->flags |= BINARY_FLAG_FILTERED;
+    }
+    return true;
+}
+
+void write_binary_sample(const ReportView* report, const WiiBalanceBoard* board) {
+    BinarySample sample;
+    if (!build_binary_sample(report, board, &sample)) return;
+
+    unsigned char record[YAWIIBB_BINARY_RECORD_SIZE];
+    binary_encode_sample(record, &sample);
+    fwrite(record, sizeof(record), 1, stdout);
+}
+
+bool publish_shm_sample(const ReportView* report, const WiiBalanceBoard* board) {
+    BinarySample sample;
+    if (!build_binary_sample(report, board, &sample)) return false;
+    shm_ring_publish(&shm_output, &sample);
+    shm_latest_update(&shm_output, &sample);
+    return true;
+}
+
+char* print_board_tag(const WiiBalanceBoard* board, char* out) {
+    if (board != NULL && board->id >= 0) {
+        *out++ = '[';
+        out = format_u32(out, (uint32_t)board->id);
+        out = format_text(out, "] ");
+    }
+    if (board != NULL && text_timestamps) {
+        out = format_u64(out, board->received_ns / 1000000000ull);
+        *out++ = '.';
+        out = format_u64_padded(out, board->received_ns % 1000000000ull / 1000, 6);
+        *out++ = ' ';
+    }
+    return out;
+}
+
+void* threadFunction(void* arg) {
+    BoardDaemon* daemon = (BoardDaemon*)arg;  // Typumwandlung
+    char line[64];
+
+    // Warten auf die Benutzereingabe, bei EOF (z.B. stdin umgeleitet) gibt es keine mehr
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        if (strcmp(line, "s\n") == 0) {  // s + Enter: Statistik ausgeben
+            stats_requested = 1;
+            continue;
+        }
+        if (strncmp(line, "l ", 2) == 0) {  // l <Level> + Enter: Textausgabe umstellen
+            int level = parse_log_level(line + 2);
+            if (level < 0) fprintf(stderr, "Unbekanntes Log-Level: %s", line + 2);
+            else {
+                level_requested = level;
+                // Ausgabethread wecken, damit die Umstellung auch ohne Reports bestätigt wird
+                uint64_t one = 1;
+                if (write(daemon->wake_fd, &one, sizeof(one)) < 0) perror("Fehler beim Wecken des Ausgabethreads");
+            }
+            continue;
         }
+        daemon->is_running = false;  // Setze die boolesche Variable auf false
+        break;
     }
 
     return NULL;  // Thread beendet sich
 }
 
-void createThread(WiiBalanceBoard* board, pthread_t* threadId) {
+void createThread(BoardDaemon* daemon, pthread_t* threadId) {
     // Thread erstellen
-    if (pthread_create(threadId, NULL, threadFunction, (void*)board) != 0) {
+    if (pthread_create(threadId, NULL, threadFunction, (void*)daemon) != 0) {
         perror("Fehler beim Erstellen des Threads");
-        board->is_running = false;  // Setze die boolesche Variable auf false
+        daemon->is_running = false;  // Setze die boolesche Variable auf false
         exit(1);
     }
 }
@@ -231,8 +1290,10 @@ int is_valid_mac(int argc, char *argv[]) {
         return 0;
     }
 
-    const char *mac = argv[1];
+    return is_valid_mac_string(argv[1]);
+}
 
+int is_valid_mac_string(const char *mac) {
     // MAC-Adresse sollte 17 Zeichen lang sein
     if (strlen(mac) != 17) {
         perror("Fehler: MAC-Adresse muss genau 17 Zeichen lang sein.\n");
@@ -258,29 +1319,12 @@ int is_valid_mac(int argc, char *argv[]) {
     return 1;
 }
 
-#ifdef YAWIIBB_EXTENDED
-
-
-uint16_t bytes_to_int_big_endian(const unsigned char *buffer, size_t position, int* max){
-
-    // Überprüfen, ob die Position gültig ist
-    if (buffer == NULL || position < 0 || position + 1 >= *max) {
-        return 0; // Fehlerbehandlung: ungültige Position
-    }
-    // Kombinieren des Bytes an der angegebenen Position (high_byte)
-    // und dem nächsten Byte (low_byte)
-    uint8_t high_byte = buffer[position];       // Hochbyte
-    uint8_t low_byte = buffer[position + 1];    // Niedriges Byte
-
-    //printf("High: %i Low: %i \n", high_byte, low_byte);
-
-
-    return (high_byte << 8) | low_byte; // Rückgabe der kombinierten Zahl
-}
-
-void process_calibration_data(int* bytes_read, unsigned char* buffer, WiiBalanceBoard* board) {
-    // Prüfen, ob das zweite Kalibrierungspaket empfangen wurde
-    bool second_packet =  (buffer[15] == 0x00);
+void process_calibration_data(const ReportView* report, WiiBalanceBoard* board) {
+    const unsigned char* data = report->read.data; // Byte 7 des Reports
+    // Die Länge wird einmal geprüft: das erste Paket braucht 16, das zweite 8 Datenbytes
+    if (report->read.length < 8) return;
+    // Prüfen, ob das zweite Kalibrierungspaket empfangen wurde (Byte 15 == 0x00 oder nur 8 Bytes)
+    bool second_packet = report->read.length < 16 || data[8] == 0x00;
     // Kalibrierungsdaten aus dem Buffer extrahieren
     //Bytes 7-14 werden für die Kalibrierung 0 verwendet (4 Paare).
     //Bytes 15-22 werden für die Kalibrierung 1 verwendet (4 Paare).
@@ -289,45 +1333,53 @@ void process_calibration_data(int* bytes_read, unsigned char* buffer, WiiBalance
     if(!second_packet) 
         for (uint8_t i = 0; i < 4; i++) {
             // Erster Kalibrierungssatz bytes 
-            board->calibration[0][i] = bytes_to_int_big_endian(buffer, 7 + (2 * i), bytes_read);
-            board->calibration[1][i] = bytes_to_int_big_endian(buffer, 15 + (2 * i), bytes_read);
+            board->calibration[0][i] = report_be16(data + 2 * i);
+            board->calibration[1][i] = report_be16(data + 8 + 2 * i);
     }
     // Wenn der zweite Paket nicht vorhanden ist, die Werte in calibration[2] speichern
-    else 
+    else {
         for (uint8_t i = 0; i < 4; i++) 
-            board->calibration[2][i] = bytes_to_int_big_endian(buffer, 7 + (2 * i), bytes_read);
+            board->calibration[2][i] = report_be16(data + 2 * i);
+        precompute_mass_coefficients(board);
+        board->calibrated = true;
+        // Auffrischung im Hintergrund: geänderte Werte im Cache ersetzen
+        if (board->persist_calibration) store_calibration(board);
+    }
  
 }
 
-uint16_t calc_mass(const WiiBalanceBoard* board, uint16_t raw, int pos) {
-    // Berechnung des Gewichts in Gramm basierend auf rohen Daten
-    uint16_t mass;
-
-    // Fall 1: Rohdaten sind kleiner als die Kalibrierung für 0 kg
-    if (raw < board->calibration[0][pos]) {
-        return 0; // 0 Gramm
-    } 
-    // Fall 2: Rohdaten liegen zwischen der Kalibrierung für 0 kg und 17 kg
-    else if (raw < board->calibration[1][pos]) {
-        mass = (uint16_t)(34000 * ((float)(raw - board->calibration[0][pos]) /
-                                    (board->calibration[1][pos] - board->calibration[0][pos])));
-        return mass; // Gewicht in Gramm zurückgeben
-    } 
-    // Fall 3: Rohdaten liegen zwischen der Kalibrierung für 17 kg und 34 kg
-    else if (raw < board->calibration[2][pos]) {
-        mass = 17000 + (uint16_t)(17000 * ((float)(raw - board->calibration[1][pos]) /
-                                             (board->calibration[2][pos] - board->calibration[1][pos])));
-        return mass; // Gewicht in Gramm zurückgeben
-    } 
-    // Fall 4: Rohdaten sind größer oder gleich der Kalibrierung für 34 kg
-    else {
-        // Lineare Extrapolation: Gewicht über 34 kg
-        mass = 34000 + (uint16_t)(17000 * ((float)(raw - board->calibration[2][pos]) / 
-                                             (board->calibration[2][pos] - board->calibration[1][pos])));
-        return mass; // Gewicht in Gramm zurückgeben
+void precompute_mass_coefficients(WiiBalanceBoard* board) {
+    MassCoefficients* c = &board->coefficients;
+
+    for (int pos = 0; pos < 4; pos++) {
+        const uint16_t kg0 = board->calibration[0][pos];
+        const uint16_t kg17 = board->calibration[1][pos];
+        const uint16_t kg34 = board->calibration[2][pos];
+        // Segment 0: 0-17 kg, Segment 1: 17-34 kg, Segment 2: Extrapolation mit der Steigung von Segment 1
+        const int32_t lower[3] = { kg0, kg17, kg34 };
+        const int32_t span[3] = { kg17 - kg0, kg34 - kg17, kg34 - kg17 };
+
+        for (int seg = 0; seg < 3; seg++) {
+            c->base[pos][seg] = lower[seg];
+            c->offset[pos][seg] = 17000u * seg;
+            // Aufgerundeter Kehrwert, dadurch ist (delta * slope) >> 32 exakt floor(17000 * delta / span)
+            c->slope[pos][seg] = span[seg] > 0 ? ((17000ull << 32) + span[seg] - 1) / span[seg] : 0;
+        }
+        c->upper[pos][0] = kg17;
+        c->upper[pos][1] = kg34;
     }
 }
 
+uint32_t calc_mass(const WiiBalanceBoard* board, uint16_t raw, int pos) {
+    const MassCoefficients* c = &board->coefficients;
+    // Segment ohne Verzweigung: 0 unter 17 kg, 1 bis 34 kg, 2 darüber
+    int seg = (raw >= c->upper[pos][0]) + (raw >= c->upper[pos][1]);
+    int32_t delta = (int32_t)raw - c->base[pos][seg];
+    // Unterhalb der 0 kg Kalibrierung: delta auf 0 klemmen (nur in Segment 0 möglich)
+    delta &= ~(delta >> 31);
+    return c->offset[pos][seg] + (uint32_t)(((uint64_t)delta * c->slope[pos][seg]) >> 32);
+}
+
 void print_calibration_data(const WiiBalanceBoard* board) {
     if (board == NULL) {
         printf("Board ist nicht initialisiert.\n");
@@ -345,5 +1397,3 @@ void print_calibration_data(const WiiBalanceBoard* board) {
         printf("\n"); // Neue Zeile nach jeder Kalibrierungsebene
     }
 }
-
-#endif
\ No newline at end of file
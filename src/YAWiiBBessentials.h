@@ -1,6 +1,5 @@
 #ifndef YAWIIBBESSENTIALS_H
 #define YAWIIBBESSENTIALS_H
-//#define YAWIIBB_EXTENDED
 
 
 /**
@@ -71,35 +70,120 @@
 #include <bluetooth/hci_lib.h>
 #include <pthread.h>
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "YAWiiBBbinary.h"
+#include "YAWiiBBring.h"
+#include "YAWiiBBhistogram.h"
+#include "YAWiiBBshm.h"
+#include "YAWiiBBwriter.h"
+#include "YAWiiBBreport.h"
+#include "YAWiiBBsway.h"
+#include "YAWiiBBfilter.h"
+#include "YAWiiBBaggregate.h"
+#include <sys/eventfd.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <signal.h>
 
 #define WII_BALANCE_BOARD_ADDR "00:23:CC:43:DC:C2"  /**< Default MAC address for the Wii Balance Board */
 #define BUFFER_SIZE 24  /**< Buffer size for data reception  - for the Wii Balance Board 24 byte is enough*/
+#define TIMER_INTERVAL_MS 100  /**< Tick of the timerfd in the event loop, bounds the reaction time to `is_running` changes */
+#define MAX_EVENTS 64  /**< Maximum number of epoll events handled per wakeup */
+#define MAX_DRAIN_REPORTS 64  /**< Upper bound of reports read per wakeup before stdout is flushed */
+#define RECEIVE_BATCH 64  /**< Reports received with one `recvmmsg()` call, at most `MAX_DRAIN_REPORTS` */
+#define WATCHDOG_DEFAULT_MS 1000  /**< Default time without any report after which the data channel counts as stalled (`-w`) */
+#define RECONNECT_MIN_MS 100  /**< First delay before a reconnect attempt */
+#define RECONNECT_MAX_MS 5000  /**< Upper bound of the exponential reconnect backoff */
+#define CACHE_CONNECT_TIMEOUT_MS 3000  /**< Timeout of the direct connect to a cached board */
+#define CACHE_MAX_PROBES 3  /**< Number of cached boards tried before an inquiry is started */
+#define INQUIRY_LENGTH 8  /**< Maximum inquiry duration in units of 1.28 s */
+#define NAME_TIMEOUT_MS 2500  /**< Timeout of a single remote name request */
+#define MAX_NAME_REQUESTS 16  /**< Maximum number of concurrently resolved candidates */
+#define INIT_REPLY_TIMEOUT_MS 200  /**< Time an init command may stay unanswered before it is sent again */
+#define INIT_MAX_RETRIES 2  /**< Repetitions of an unanswered init command before it is given up */
+#define GAP_FACTOR 2  /**< An interval longer than this many regular periods counts as gap */
+#define PERIOD_SMOOTHING 4  /**< Weight of a new interval in the period estimate is 2^-PERIOD_SMOOTHING */
+#define OUTPUT_FLUSH_MS 10  /**< Oldest buffered text report that forces a flush while the ring never runs empty */
+#define OUTPUT_FLUSH_CHECK 64  /**< The age of the oldest buffered report is checked every this many reports */
+#define OUTPUT_BATCH 64  /**< Reports the output thread takes out of the ring at once */
+#define OUTPUT_BATCH_MIN 8  /**< Shortest run of data reports of one board that goes through the batch kernel */
 
 /** 
  * @enum LogLevel
  * @brief Specifies the level of detail for logging output.
  *
  * This enumeration allows the user to choose between different verbosity
- * levels when displaying information.
+ * levels when displaying information. All levels are compiled in; the level is 
+ * chosen with `-l` and can be changed at runtime with `l <level>` on stdin.
  */
 typedef enum { 
     RAW,     /**< Outputs raw data as received without interpretation */
-    #ifdef YAWIIBB_EXTENDED
     DECODE,  /**< Outputs big endian converted value of two bytes, readings in gramm */
     DEBUG,   /**< Provides debugging information and readings in Kilo */
-    VERBOSE  /**< currently unused */
-    #endif //YAWIIBB_EXTENDED
+    VERBOSE, /**< Every report with all parsed fields: raw values, grams and total, status, memory reads and acknowledgements */
+    LOG_LEVELS /**< Number of levels */
 } LogLevel;
 
-extern const LogLevel debug_level;
+/**
+ * @brief Level the boards start with, selected with the `-l` option (default `RAW`).
+ */
+extern LogLevel debug_level;
+
+/**
+ * @brief Level requested with `l <level>` on stdin, -1 if none is pending.
+ *
+ * The output thread picks it up between two reports and rebinds the printer of 
+ * every board with `set_log_level()`.
+ */
+extern volatile sig_atomic_t level_requested;
+
+/**
+ * @enum OutputFormat
+ * @brief Selects how received reports are written to stdout.
+ *
+ * The text format is controlled by `LogLevel`. The binary format writes one 
+ * fixed-size record per data report as described in `YAWiiBBbinary.h`. The 
+ * shared-memory format publishes the same records into `shm_output` instead of 
+ * stdout.
+ */
+typedef enum {
+    OUTPUT_TEXT,    /**< Text output as selected by `debug_level` */
+    OUTPUT_BINARY,  /**< Little-endian records, see `YAWiiBBbinary.h` */
+    OUTPUT_SHM      /**< Records in a shared-memory ring, see `YAWiiBBshm.h` */
+} OutputFormat;
+
+extern OutputFormat output_format;
+
+/**
+ * @brief Shared-memory ring written by the output thread when `output_format` is `OUTPUT_SHM`.
+ */
+extern ShmRing shm_output;
 
 /**
- * @brief Buffer for storing responses from the Wii Balance Board.
+ * @brief Buffered text output of the output thread to stdout, see `YAWiiBBwriter.h`.
  *
- * This buffer holds incoming data from the Balance Board, with a fixed maximum 
- * length of bytes, as defined in BUFFER_SIZE
+ * Created by `createOutputThread()` and only used by the output thread, which flushes
+ * it together with stdout.
  */
-extern unsigned char buffer[BUFFER_SIZE];
+extern TextWriter text_writer;
+
+/**
+ * @brief Prefix every text line with the reception time of its report (`-t`).
+ *
+ * The time is `CLOCK_MONOTONIC` in seconds with microseconds, the same clock as 
+ * `timestamp_ns` of the binary records.
+ */
+extern bool text_timestamps;
+
+/**
+ * @brief Set by `SIGUSR1` or by `s` + Enter on stdin, the event loop then prints `print_report_stats()`.
+ */
+extern volatile sig_atomic_t stats_requested;
 
 /**
  * @defgroup CommandDefinitions Command Definitions
@@ -119,14 +203,14 @@ extern unsigned char buffer[BUFFER_SIZE];
  * ## Command Arrays
  * - **Status Request** (`status_command`): Retrieves the current status of the Balance Board, such 
  *   as connection state and battery level.
- *   - `const unsigned char status_command[] = { 0x52, 0x12, 0x00, 0x32 };`
- *   - Structure: `0x52` (address) | `0x12` (status command) | `0x00` (reserved) | `0x32` (end byte).
+ *   - `const unsigned char status_command[] = { 0x52, 0x12, 0x02, 0x32 };`
+ *   - Structure: `0x52` (address) | `0x12` (status command) | `0x02` (acknowledge request) | `0x32` (end byte).
  *   - **Note**: The `0x32` byte at the end may act as a terminator, checksum byte, or something else I do not fully understand.
 
  * - **Activation Command** (`activate_command`): Activates the Balance Board sensors, preparing the 
  *   board to send data.
- *   - `const unsigned char activate_command[] = { 0x52, 0x13, 0x04 };`
- *   - Structure: `0x52` (address) | `0x13` (activate command) | `0x04` (activation flag).
+ *   - `const unsigned char activate_command[] = { 0x52, 0x13, 0x06 };`
+ *   - Structure: `0x52` (address) | `0x13` (activate command) | `0x04` (activation flag) + `0x02` (acknowledge request).
  *   - **Note**: The role of `0x04` as an activation flag is unclear. I included it because some protocols suggest this might act as a "start data" signal. More testing is needed to determine its necessity, but I do not fully understand its purpose.
 
  * - **Calibration Command** (`calibration_command`): Initiates calibration to capture sensor baselines.
@@ -136,8 +220,8 @@ extern unsigned char buffer[BUFFER_SIZE];
 
  * - **LED Control Command** (`led_on_command`): Controls the LED on the Balance Board. This command 
  *   can toggle the LED based on the specified mask.
- *   - `const unsigned char led_on_command[] = { 0x52, 0x11, 0x10 };`
- *   - Structure: `0x52` (address) | `0x11` (LED command) | `0x10` (LED mask for on state).
+ *   - `const unsigned char led_on_command[] = { 0x52, 0x11, 0x12 };`
+ *   - Structure: `0x52` (address) | `0x11` (LED command) | `0x10` (LED mask for on state) + `0x02` (acknowledge request).
  *   - **Note**: The mask `0x10` represents the bit to turn on the single LED on the Balance Board. This part is clear from Wiibrew’s Wiimote documentation.
 
  * - **Data Dump Command** (`data_dump_command`): Starts continuous data reporting from the Balance Board, 
@@ -146,6 +230,14 @@ extern unsigned char buffer[BUFFER_SIZE];
  *   - Structure: `0x52` (address) | `0x15` (data dump command) | `0x00` (reserved) | `0x32` (end byte).
  *   - **Note**: The `0x32` byte here might act as an end marker or handshake byte to confirm readiness for data streaming, or something completely different—I am unsure.
  * 
+ * ## Replies
+ * The board answers on the data channel. Commands with the acknowledge bit `0x02` in 
+ * their first parameter byte are confirmed by a `0x22` report (`a1 22 BB BB RR EE`, 
+ * `RR` = confirmed command, `EE` = error code), the status request `0x15` is answered 
+ * by a `0x20` status report and the memory read `0x17` by two `0x21` packets. The init 
+ * sequence (`init_commands` in `YAWiiBBessentials.c`) uses these replies to notice lost 
+ * commands, see `track_init_reply()`.
+ *
  * ## Future Extensions
  * Additional commands may be added as necessary to extend functionality. In the future, 
  * command arrays could be dynamically filled based on inputs from `stdin` within a monitoring 
@@ -162,6 +254,131 @@ extern const unsigned char data_dump_command[];
 /** @} */
 
 
+/**
+ * @struct ReportStats
+ * @brief Timing statistics of the reports of one board.
+ *
+ * `interval` holds the time between consecutive 0x32 reports, taken from the receive 
+ * timestamps, so it shows the jitter of the radio link independent of the load of the 
+ * process. `delay` holds the time from the reception of every report to the completed 
+ * `fflush(stdout)` (with `-o shm` to the wakeup of the consumers). Both are HDR-style histograms, see `YAWiiBBhistogram.h`.
+ *
+ * The reports carry no sequence number, so gaps and duplicates are estimated from the 
+ * timing: `period_ns` follows the regular interval (moving average of the intervals 
+ * that are neither gap nor duplicate). An interval above `GAP_FACTOR` periods counts 
+ * as gap, a report identical to its predecessor that arrives within half a period as 
+ * duplicate. A gap followed by a burst is jitter rather than loss, so the counters 
+ * do not estimate missing reports; the interval histogram shows how long the gaps were.
+ *
+ * `receive_calls` counts the system calls of the receive path; together with the 
+ * stamped reports it gives the reports per `recvmmsg()`. 
+ *
+ * The receive side is updated by the event loop, `delay` by the output thread. 
+ * `print_report_stats()` prints everything on exit and on request (`SIGUSR1` or 
+ * `s` + Enter); values printed on request may be off by the reports in flight.
+ */
+typedef struct {
+    Histogram interval;             /**< Time between consecutive 0x32 reports */
+    Histogram delay;                /**< Time from reception to the flushed output */
+    uint64_t last_sample_ns;        /**< Reception of the previous 0x32 report, 0 before the first one */
+    uint64_t period_ns;             /**< Estimated regular interval, 0 until the first interval */
+    uint64_t gaps;                  /**< Intervals longer than `GAP_FACTOR` periods */
+    uint64_t duplicates;            /**< Reports identical to their predecessor and received within half a period */
+    uint64_t kernel_stamps;         /**< Reports stamped by the kernel (`SO_TIMESTAMPNS`) */
+    uint64_t fallback_stamps;       /**< Reports stamped with `CLOCK_MONOTONIC` after `recvmsg()` */
+    uint64_t receive_calls;         /**< `recvmmsg()` calls on `receive_sock`, including the one that found it empty */
+    unsigned char last_data[10];    /**< Bytes 2-11 (buttons and raw values) of the previous 0x32 report */
+} ReportStats;
+
+/**
+ * @struct MassCoefficients
+ * @brief Integer interpolation coefficients derived once from the calibration table.
+ *
+ * For every sensor and every segment (0-17 kg, 17-34 kg, above 34 kg) the raw value 
+ * at the start of the segment, the mass at the start of the segment and the slope 
+ * are stored. The slope is `ceil(17000 * 2^32 / (upper - lower))`; with raw values 
+ * below 2^16 the product `(raw - base) * slope >> 32` equals 
+ * `floor(17000 * (raw - base) / (upper - lower))` exactly, so `calc_mass()` needs 
+ * neither a division nor floating point.
+ */
+typedef struct {
+    int32_t base[4][3];             /**< Raw value where the segment starts */
+    uint32_t offset[4][3];          /**< Mass in gram at the start of the segment */
+    uint64_t slope[4][3];           /**< Gram per raw unit, fixed point with 32 fractional bits */
+    uint16_t upper[4][2];           /**< Raw values of the 17 kg and 34 kg calibration, select the segment */
+} MassCoefficients;
+
+/**
+ * @enum ConnectionState
+ * @brief State of the connection supervision of a board.
+ *
+ * A lost or stalled connection does not stop the board: it is closed, and after a 
+ * backoff both channels are connected again without blocking the event loop. 
+ * Calibration, output streams and counters of the board are kept.
+ */
+typedef enum {
+    BOARD_CONNECTED,                /**< Both channels are up, reports are received */
+    BOARD_WAITING,                  /**< Connection lost, waiting for `reconnect_at_ns` */
+    BOARD_CONNECTING_CONTROL,       /**< Non-blocking connect of the control channel (0x11) in progress */
+    BOARD_CONNECTING_DATA           /**< Non-blocking connect of the data channel (0x13) in progress */
+} ConnectionState;
+
+/**
+ * @enum InitStep
+ * @brief Commands of the init sequence, index into the table `init_commands`.
+ *
+ * The order is the order in which pending commands are sent.
+ */
+typedef enum {
+    INIT_STATUS,                    /**< `status_command` (0x12), confirmed by 0x22 */
+    INIT_CALIBRATION,               /**< `calibration_command` (0x17), answered by two 0x21 packets */
+    INIT_LED,                       /**< `led_on_command` (0x11), confirmed by 0x22 */
+    INIT_ACTIVATION,                /**< `activate_command` (0x13), confirmed by 0x22 */
+    INIT_DUMP,                      /**< `data_dump_command` (0x15), answered by 0x20 */
+    INIT_STEPS                      /**< Number of steps */
+} InitStep;
+
+/**
+ * @struct InitTracker
+ * @brief Replies outstanding for the init commands of a board and the timing of the init.
+ *
+ * All pending commands are sent back-to-back; the replies are matched in the event 
+ * loop as they arrive on the data channel. A command without reply after 
+ * `INIT_REPLY_TIMEOUT_MS` is sent again, at most `INIT_MAX_RETRIES` times.
+ */
+typedef struct {
+    uint8_t waiting;                /**< Bit mask (`1 << InitStep`) of the commands sent and not yet answered */
+    uint8_t sent;                   /**< Bit mask of the commands sent since `started_ns` */
+    uint8_t packets[INIT_STEPS];    /**< Reply packets still expected per command */
+    uint8_t retries[INIT_STEPS];    /**< Repetitions per command */
+    uint64_t sent_ns[INIT_STEPS];   /**< Time of the last transmission per command */
+    uint64_t started_ns;            /**< Both channels connected */
+    uint64_t first_sample_ns;       /**< First 0x32 report after `started_ns`, 0 before */
+    uint64_t done_ns;               /**< Last reply arrived or last command given up */
+    bool reported;                  /**< Timing of this init has been printed */
+} InitTracker;
+
+/**
+ * @struct EvdevFrame
+ * @brief Axis state of the evdev transport, emitted as one report per `SYN_REPORT`.
+ */
+typedef struct {
+    uint16_t axis[4];               /**< Current values TR, BR, TL, BL in units of 10 g (calibrated by the kernel) */
+    bool dropped;                   /**< `SYN_DROPPED` seen, events are ignored until the next `SYN_REPORT` */
+} EvdevFrame;
+
+struct WiiBalanceBoard;
+struct Transport;
+
+/**
+ * @brief Formats one report of a board as text, one function per `LogLevel`.
+ *
+ * @param board  Board that received the report.
+ * @param report Parsed report, at least 2 bytes long.
+ * @param out    Writer the text is formatted into.
+ */
+typedef void (*TextPrinter)(const struct WiiBalanceBoard* board, const ReportView* report, TextWriter* out);
+
 /**
  * @struct WiiBalanceBoard
  * @brief Represents the Wii Balance Board connection and status.
@@ -171,21 +388,72 @@ extern const unsigned char data_dump_command[];
  * a flag indicating the board's active state.
  */
 
-typedef struct {
+typedef struct WiiBalanceBoard {
     char mac[19];                   /**< Bluetooth MAC address of the Wii Balance Board */
     int control_sock;               /**< Socket descriptor for control channel */
-    int receive_sock;               /**< Socket descriptor for interrupt (data) channel */
+    int receive_sock;               /**< Socket descriptor for interrupt (data) channel, or the hidraw device */
+    const struct Transport* transport; /**< How commands are sent and reports received (`YAWiiBBtransport.h`) */
+    EvdevFrame evdev;               /**< Frame being assembled by the evdev transport */
     bool needStatus;                /**< Status request flag */
     bool needActivation;            /**< Calibration request flag */
     bool needCalibration;           /**< Calibration request flag */
-    bool led;                       /**< LED Status */
+    bool needLed;                   /**< LED on request flag */
+    bool led;                       /**< LED Status, set when the LED command was confirmed */
     bool needDumpStart;             /**< Start continuous dump request flag */
     bool is_running;                /**< Flag to indicate if the board is actively running */
-    #ifdef YAWIIBB_EXTENDED
+    int id;                         /**< Index of the board in daemon mode, -1 for a single board (output is not tagged) */
+    uint64_t received_ns;           /**< Reception of the report being processed (`CLOCK_MONOTONIC`, kernel timestamp if available) */
+    ReportStats stats;              /**< Interval and delay histograms, gap and duplicate counters */
+    ConnectionState state;          /**< State of the connection supervision */
+    uint64_t last_report_ns;        /**< Reception of the last report (watchdog) */
+    uint64_t reconnect_at_ns;       /**< Time of the next reconnect attempt in `BOARD_WAITING` */
+    uint32_t reconnect_delay_ms;    /**< Current backoff, doubled after every failed attempt */
+    uint32_t reconnects;            /**< Number of successful reconnects */
+    InitTracker init;               /**< Replies outstanding for the init commands */
+    LogLevel level;                 /**< Text level of this board */
+    TextPrinter print_text;         /**< Printer of `level`, bound by `set_log_level()` */
     uint16_t calibration[3][4];     /**< Calibration data array */
-    #endif //YAWIIBB_EXTENDED
+    bool calibrated;                /**< Both calibration packets have been received or the table was loaded from the cache */
+    bool persist_calibration;       /**< Store received calibration in the cache (not for replays) */
+    MassCoefficients coefficients;  /**< Derived from `calibration` by `precompute_mass_coefficients()` */
+    SwayStats sway;                 /**< Centre of pressure and sway metrics (`-a`), updated by the output thread */
+    FilterState filter;             /**< Resampling and biquad state (`-F`, `-R`), updated by the output thread */
+    AggregateState aggregate;       /**< Open windows of the aggregation (`-W`), updated by the output thread */
 } WiiBalanceBoard;
 
+/**
+ * @struct BoardDaemon
+ * @brief Drives one or more Wii Balance Boards from a single event loop.
+ *
+ * Every board keeps its own buffer, calibration and command flags, so the 
+ * boards are completely independent of each other. The daemon only owns the 
+ * shared epoll instance and the timerfd. In the epoll events `data.ptr` points 
+ * to the board whose `receive_sock` became readable, or is `NULL` for the timer.
+ *
+ * The event loop only receives: every report goes into `ring`, and the output 
+ * thread (`output_thread()`) decodes and writes it. `wake_fd` is an eventfd the 
+ * receive thread signals after each batch so the output thread can block while 
+ * the ring is empty. With `-u` the output thread also serves the fan-out server 
+ * (`YAWiiBBserver.h`) while it waits.
+ *
+ * A single board is simply a daemon with `count == 1` and an untagged board (`id == -1`).
+ */
+typedef struct {
+    WiiBalanceBoard* boards;        /**< Array of `count` boards */
+    int count;                      /**< Number of boards in `boards` */
+    int epoll_fd;                   /**< epoll instance waiting for all `receive_sock` and `timer_fd` */
+    int timer_fd;                   /**< timerfd for timed work in the event loop */
+    bool is_running;                /**< Cleared by the input thread or when the last board stopped */
+    ReportRing ring;                /**< Reports handed from the receive thread to the output thread */
+    int wake_fd;                    /**< eventfd waking the output thread */
+    FILE* capture;                  /**< Capture file of all received reports (`-c`) or `NULL` */
+    bool reconnect;                 /**< Reconnect lost boards instead of stopping them (not for replays) */
+    uint32_t watchdog_ms;           /**< Reconnect a board after this time without reports, 0 = off (`-w`) */
+    const char* simulator_dir;      /**< Socket directory of the board simulator (`-s`) or `NULL` for L2CAP */
+    struct FanoutServer* server;    /**< Fan-out server of the output thread (`-u`) or `NULL` */
+    uint64_t loop_cpu_ns;           /**< CPU time of the receive thread when the event loop started, see `print_receive_stats()` */
+} BoardDaemon;
+
 /**
  * @defgroup EssentialFunctions Essential Functions
  * @brief Core functions necessary for basic interaction with the Wii Balance Board.
@@ -197,56 +465,83 @@ typedef struct {
  */
 
 /**
- * @brief Logs messages with different verbosity levels, providing diagnostics and raw data output.
+ * @brief Logs a received report as text in the level of its board.
  *
- * This function outputs messages to the console with optional raw data from the Wii Balance Board.
- * It supports multiple verbosity levels (RAW, DEBUG, and VERBOSE), controlled by the `LogLevel` enum. 
+ * This function outputs the raw data from the Wii Balance Board or the values 
+ * derived from it, depending on the `LogLevel` of the board (RAW, DECODE, DEBUG, VERBOSE).
  * The function is essential for debugging and tracking the board's status and output during development.
  *
- * This function's implementation interacts closely with the Wiimote protocol, pushing the limits 
- * of my current understanding of the protocol. Despite attempts to isolate functionality in `essentials`,
- * it remains a complex function with room for refinement.
- * 
- * Potential areas for improvement include:
- * - **Consistent use of pointers**: Aiming to rely on pointers wherever possible to reduce stack usage 
- *   and optimize memory management.
- * - **Modularizing verbosity level handling**: Simplifying logic for handling different verbosity levels, 
- *   potentially through helper functions to make the code more manageable.
- *
- * @param level Pointer to a `LogLevel` enum indicating the verbosity level (RAW, DEBUG, VERBOSE).
- * @param message Constant character string representing the message to be logged.
- * @param buffer Optional byte array containing raw data to display if needed. This parameter 
- *               is processed only when provided (not NULL).
- * @param length Length of the byte array (ignored if buffer is NULL).
+ * The level is not evaluated per report: every level has its own printer, and 
+ * `set_log_level()` binds the one of the board to `board->print_text` once. This 
+ * function only calls it, so switching the level needs neither a rebuild nor a reconnect.
+ *
+ * @param report Report parsed by `parse_report()`, reports shorter than 2 bytes are ignored.
  * @param board Pointer to the `WiiBalanceBoard` structure for accessing board-specific data.
+ * @param out Writer the text is formatted into (`text_writer` of the output thread, or the
+ *            collecting writer of the fan-out server), see `YAWiiBBwriter.h`.
  */
-void print_info(const LogLevel* is_debug_level, const char* message, const unsigned char* buffer, int length, const WiiBalanceBoard* board);
+void print_info(const ReportView* report, const WiiBalanceBoard* board, TextWriter* out);
+
+/**
+ * @brief Selects the text level of a board and binds its printer.
+ *
+ * Must only be called by the thread that prints the board (before the output thread 
+ * starts, or by the output thread itself).
+ *
+ * @param board Board to configure.
+ * @param level New level.
+ */
+void set_log_level(WiiBalanceBoard* board, LogLevel level);
+
+/**
+ * @brief Parses a level name (`raw`, `decode`, `debug`, `verbose`).
+ *
+ * @param name Name of the level, may end with a newline.
+ * @return The level, or -1 for an unknown name.
+ */
+int parse_log_level(const char* name);
 
 /**
  * @brief Finds the Wii Balance Board by scanning nearby Bluetooth devices.
  * 
  * Requires the device to be in pairing mode and not jet paired
  *
- * This function scans for Bluetooth devices in the area and identifies the Wii
- * Balance Board based on its specific name. If found, the board’s MAC address
- * is stored directly in the @p board structure.
+ * The boards of the discovery cache (`YAWiiBBcache.h`) seen on the current adapter 
+ * are tried first with a direct connect of the control channel (at most 
+ * `CACHE_MAX_PROBES`, each with `CACHE_CONNECT_TIMEOUT_MS`). The connected socket is 
+ * kept in `control_sock`, so no second connect is needed.
+ *
+ * Only if none of them answers, an inquiry is started. Its results are evaluated 
+ * while it is running: the names of all candidates (class of device "peripheral", 
+ * like the Wii Remote and the Balance Board) are resolved concurrently, and the 
+ * inquiry is cancelled as soon as a "Nintendo RVL-WBC-01" answers. If found, the 
+ * board’s MAC address is stored directly in the @p board structure and in the cache.
  *
  * @param board Pointer to WiiBalanceBoard structure where the MAC address is stored.
  * @return 0 on success (board found), -1 if not found.
  */
 int find_wii_balance_board(WiiBalanceBoard* board);
 
+/**
+ * @brief Writes the MAC address of the default Bluetooth adapter into @p address.
+ *
+ * @param address Buffer of at least 19 characters, empty string if there is no adapter.
+ */
+void default_adapter_address(char* address);
+
 /**
  * @brief Sends a command to the Wii Balance Board over the control socket.
  *
  * This function transmits a command to the board using the specified socket.
- * If an error occurs, the program will exit with a failure status.
+ * If an error occurs, a message is printed; the lost connection itself is 
+ * detected on the data channel and handled by `board_lost()`.
  *
  * @param sock Integer control socket descriptor.
  * @param command Byte array of command data to be sent.
  * @param length Integer representing the length of the command array.
+ * @return 0 on success, -1 on failure.
  */
-void send_command(int sock, const unsigned char* command, int length);
+int send_command(int sock, const unsigned char* command, int length);
 
 /**
  * @brief Establishes a L2CAP connection with the Wii Balance Board.
@@ -261,6 +556,34 @@ void send_command(int sock, const unsigned char* command, int length);
  */
 int connect_l2cap(const char* bdaddr_str, uint16_t psm);
 
+/**
+ * @brief Tries to establish a L2CAP connection within a timeout.
+ *
+ * Unlike `connect_l2cap()` this function does not exit on failure; it is used to 
+ * probe boards that may be out of range.
+ *
+ * @param bdaddr_str Constant character string representing the Bluetooth MAC address.
+ * @param psm Integer specifying the Protocol/Service Multiplexer (PSM) channel.
+ * @param timeout_ms Maximum time for the connect in milliseconds, -1 waits without limit.
+ * @return Socket descriptor on success, -1 on failure (errno is set).
+ */
+int try_connect_l2cap(const char* bdaddr_str, uint16_t psm, int timeout_ms);
+
+/**
+ * @brief Connects to a simulated Wii Balance Board instead of using L2CAP.
+ *
+ * The board simulator (`testing/simBoard.c`) listens on one Unix SEQPACKET socket 
+ * per channel, named `<dir>/<MAC>.<PSM>` (e.g. `/tmp/wbsim/02:00:00:00:00:00.11`). 
+ * SEQPACKET keeps the packet boundaries exactly like L2CAP, so the rest of the 
+ * driver cannot tell the difference.
+ *
+ * @param dir Directory of the simulator sockets (option `-s`).
+ * @param bdaddr_str MAC address of the simulated board.
+ * @param psm Channel that is replaced (0x11 control, 0x13 data).
+ * @return Socket descriptor on success, exits program on failure.
+ */
+int connect_simulator(const char* dir, const char* bdaddr_str, uint16_t psm);
+
 
 /**
  * @brief Processes received data from the Wii Balance Board.
@@ -269,20 +592,265 @@ int connect_l2cap(const char* bdaddr_str, uint16_t psm);
  * a certain condition is met (e.g., the receive code indicates an error),
  * the `is_running` status is set to `false`.
  * 
- * @param bytes_read Number of bytes read in the `buffer`.
- * @param buffer     Buffer containing the received data.
- * @param board      Pointer to the WiiBalanceBoard structure that holds the current status.
+ * The receiving thread parses every report once with `parse_report()` and passes the 
+ * view along in its ring slot; the text, binary and shared-memory output and the 
+ * calibration read the fields of that view without checking the length again.
+ * 
+ * The text of a report (data line, sway line with `-a`) is formatted into @p text.
+ * That is `text_writer`, or the collecting writer of the fan-out server while it has
+ * text subscribers; the output thread then appends the same bytes to `text_writer`.
+ *
+ * @param report Parsed report.
+ * @param board  Pointer to the WiiBalanceBoard structure that holds the current status.
+ * @param text   Writer for the text output.
+ */
+void process_received_data(const ReportView* report, WiiBalanceBoard* board, TextWriter* text);
+
+/**
+ * @brief Returns the current value of `CLOCK_MONOTONIC` in nanoseconds.
+ *
+ * @return Monotonic time in nanoseconds.
+ */
+uint64_t monotonic_ns(void);
+
+/**
+ * @brief Returns the current value of `CLOCK_REALTIME` in nanoseconds.
+ *
+ * Only used to convert the kernel receive timestamps, which are `CLOCK_REALTIME`.
+ *
+ * @return Wall clock time in nanoseconds.
  */
-void process_received_data(int bytes_read, unsigned char* buffer, WiiBalanceBoard* board);
+uint64_t realtime_ns(void);
+
+/**
+ * @brief Returns the CPU time of the calling thread (`CLOCK_THREAD_CPUTIME_ID`) in nanoseconds.
+ *
+ * This is a real system call, unlike the two clocks above, so it is only read at the 
+ * start and the end of the event loop and not per report.
+ *
+ * @return CPU time of the thread in nanoseconds.
+ */
+uint64_t thread_cpu_ns(void);
+
+/**
+ * @brief Prepares the epoll based event loop for all boards of the daemon.
+ *
+ * Switches every `receive_sock` to non-blocking mode, creates a periodic timerfd 
+ * with an interval of `TIMER_INTERVAL_MS` (a quarter of `watchdog_ms` if that is 
+ * shorter, so a stall is noticed in time) and registers all descriptors 
+ * in a new epoll instance. The descriptors are stored in `daemon->epoll_fd` 
+ * and `daemon->timer_fd`.
+ *
+ * @param daemon Pointer to the BoardDaemon whose boards have open sockets.
+ * @return 0 on success, -1 on failure (an error message is printed).
+ */
+int setup_event_loop(BoardDaemon* daemon);
+
+/**
+ * @brief Removes a stopped board from the event loop and closes its sockets.
+ *
+ * Clears `daemon->is_running` once no board is left running.
+ *
+ * @param daemon Pointer to the BoardDaemon the board belongs to.
+ * @param board  Pointer to the board to be closed.
+ */
+void close_board(BoardDaemon* daemon, WiiBalanceBoard* board);
+
+/**
+ * @brief Reads all reports currently queued on `receive_sock` into the report ring.
+ *
+ * Lets the board's transport receive directly into consecutive slots of `daemon->ring` 
+ * (`ring_reserve_many()`). The L2CAP transport takes everything queued on the socket, 
+ * up to `RECEIVE_BATCH` reports, with one `recvmmsg()` call; a call that returns fewer 
+ * reports than slots offered has emptied the socket, so the drain usually ends without 
+ * the extra call that only returns `EAGAIN`. The hidraw transport reads one report per 
+ * `read()` until `EAGAIN`. The loop stops after `MAX_DRAIN_REPORTS` and wakes 
+ * the output thread once per batch; `board->stats.receive_calls` counts the calls. Every report is stamped with the kernel receive time 
+ * (`SO_TIMESTAMPNS`, converted to `CLOCK_MONOTONIC`) or, if the socket delivers none, 
+ * with `CLOCK_MONOTONIC` right after `recvmsg()`; the 0x32 reports update the interval 
+ * histogram and the gap and duplicate counters of `board->stats`. If the ring is full, the drop policy of the ring decides 
+ * which report is lost, the socket is drained in any case. A failed `recv()` or a 
+ * closed connection is passed to `board_lost()`. Until the init sequence is answered, 
+ * every report is also passed to `track_init_reply()`.
+ *
+ * @param daemon Pointer to the BoardDaemon owning the ring.
+ * @param board  Pointer to the WiiBalanceBoard whose socket is readable.
+ */
+void drain_receive_sock(BoardDaemon* daemon, WiiBalanceBoard* board);
+
+/**
+ * @brief Handles a lost or stalled connection of a board.
+ *
+ * With `daemon->reconnect` the sockets are closed and a reconnect is scheduled after 
+ * the current backoff (`BOARD_WAITING`); otherwise the board is stopped as before.
+ *
+ * @param daemon Pointer to the BoardDaemon the board belongs to.
+ * @param board  Pointer to the board whose connection is gone.
+ * @param reason Short description for the message on stderr.
+ */
+void board_lost(BoardDaemon* daemon, WiiBalanceBoard* board, const char* reason);
+
+/**
+ * @brief Continues a reconnect after an epoll event of a connecting socket.
+ *
+ * The channels are connected one after another with non-blocking sockets registered 
+ * for `EPOLLOUT`. When the data channel is up, it is registered for `EPOLLIN` again 
+ * and only the commands that restart the dump (`needStatus`, `needDumpStart`) are 
+ * scheduled; the calibration is kept. A failed connect doubles the backoff.
+ *
+ * @param daemon Pointer to the BoardDaemon the board belongs to.
+ * @param board  Pointer to the board in `BOARD_CONNECTING_CONTROL` or `BOARD_CONNECTING_DATA`.
+ */
+void continue_reconnect(BoardDaemon* daemon, WiiBalanceBoard* board);
+
+/**
+ * @brief Periodic supervision of all boards, called on every timer tick.
+ *
+ * Starts due reconnect attempts, repeats unanswered init commands 
+ * (`check_init_replies()`) and passes boards whose data channel has been 
+ * silent for longer than `watchdog_ms` to `board_lost()`.
+ *
+ * @param daemon Pointer to the BoardDaemon to supervise.
+ */
+void check_connections(BoardDaemon* daemon);
+
+/**
+ * @brief Thread function decoding and writing the reports of the ring.
+ *
+ * Takes up to `OUTPUT_BATCH` reports at a time out of `daemon->ring` and moves the view 
+ * parsed on reception to the popped copy (`report_rebase()`). The masses of every run 
+ * of data reports of one board are calculated at once, with the batch kernel of 
+ * `YAWiiBBbatch.h` for runs of at least `OUTPUT_BATCH_MIN` reports and `calc_mass()` 
+ * otherwise. Every report then goes to `process_received_data()`, which formats the text into `text_writer`
+ * (with text subscribers of the fan-out server first into its writer, and the same bytes are copied to stdout). 
+ * The writer and stdout are flushed whenever the ring runs empty (or after as many reports 
+ * as the ring has slots, or when the oldest unflushed report is older than `OUTPUT_FLUSH_MS`), 
+ * and once more before the thread returns; then the delay of 
+ * every report written since the last flush goes into `stats.delay` and the thread blocks on 
+ * `daemon->wake_fd` (or in `server_wait()` when the fan-out server runs, which also 
+ * sends every report to its subscribers). With `-W` the wait ends `AGGREGATE_IDLE_DELAY_MS` after the end of
+ * the next open window at the latest, and every flush first writes the windows that ended that long ago, so idle
+ * and lost boards get their records without a new sample. With `-o shm` the records are published as they are decoded and 
+ * the consumers are woken at the same points instead of the flush. It returns once the ring is closed and empty.
+ *
+ * @param arg A void pointer to the `BoardDaemon`.
+ * @return Always `NULL`.
+ */
+void* output_thread(void* arg);
+
+/**
+ * @brief Creates the ring, the eventfd and the output thread of the daemon.
+ *
+ * @param daemon   Pointer to the `BoardDaemon`.
+ * @param slots    Number of ring slots.
+ * @param policy   Drop policy of the ring.
+ * @param threadId Pointer to the `pthread_t` variable where the ID of the new thread will be stored.
+ */
+void createOutputThread(BoardDaemon* daemon, uint32_t slots, DropPolicy policy, pthread_t* threadId);
+
+/**
+ * @brief Closes the ring, wakes the output thread and waits until it has written everything.
+ *
+ * Prints the overflow counters of the ring to stderr.
+ *
+ * @param daemon   Pointer to the `BoardDaemon`.
+ * @param threadId ID of the output thread.
+ */
+void stopOutputThread(BoardDaemon* daemon, pthread_t threadId);
+
+/**
+ * @brief Prints the timing statistics of a board to stderr.
+ *
+ * Source of the timestamps, reports per `recvmmsg()`, interval histogram with gap and 
+ * duplicate counters and the receive-to-output delay histogram. Called on exit and on request.
+ *
+ * @param board Pointer to the WiiBalanceBoard structure holding the statistics.
+ */
+void print_report_stats(const WiiBalanceBoard* board);
+
+/**
+ * @brief Prints the cost of the receive path of all boards to stderr.
+ *
+ * `recvmmsg()` calls per report and CPU time of the receive thread per report since 
+ * `daemon->loop_cpu_ns`. The CPU time includes everything the event loop does 
+ * (epoll, timer, init tracking, capture). Must be called from the receive thread.
+ *
+ * @param daemon Pointer to the `BoardDaemon`.
+ */
+void print_receive_stats(const BoardDaemon* daemon);
+
+/**
+ * @brief Writes the header of the binary output format to stdout.
+ *
+ * Must be called once before the first record when `output_format` is `OUTPUT_BINARY`.
+ *
+ * @param board_count Number of boards served by the process.
+ */
+void write_binary_header(int board_count);
+
+/**
+ * @brief Builds the binary record of a report.
+ *
+ * Only data reports that carry the four sensors (`REPORT_DATA`, usually `0x32`) 
+ * have a record. The masses are filled in when the board is calibrated.
+ *
+ * @param report Parsed report.
+ * @param board  Pointer to the board that received the report.
+ * @param sample Receives the record.
+ * @return true for a data report, false for all other reports.
+ */
+bool build_binary_sample(const ReportView* report, const WiiBalanceBoard* board, BinarySample* sample);
+
+/**
+ * @brief Writes a report as a binary record to stdout.
+ *
+ * Only data reports are written, see `build_binary_sample()`.
+ * The record is buffered by stdio and flushed together with the other reports 
+ * of the same wakeup.
+ *
+ * @param report Parsed report.
+ * @param board  Pointer to the board that received the report.
+ */
+void write_binary_sample(const ReportView* report, const WiiBalanceBoard* board);
+
+/**
+ * @brief Publishes a report as a record into `shm_output`.
+ *
+ * Builds the same record as `write_binary_sample()` and rewrites the latest slot of 
+ * the board. Consumers see both immediately; sleeping consumers are woken once per 
+ * batch of the output thread.
+ *
+ * @param report Parsed report.
+ * @param board  Pointer to the board that received the report.
+ * @return true if the report was a data report and has been published.
+ */
+bool publish_shm_sample(const ReportView* report, const WiiBalanceBoard* board);
+
+/**
+ * @brief Formats the tag `[id] ` of a board in daemon mode.
+ *
+ * Every output line of a board is prefixed with this tag when more than one 
+ * board is served, so consumers can demultiplex the stream. Boards with 
+ * `id == -1` (single board operation) print nothing. With `text_timestamps` the 
+ * reception time of the current report follows (`12345.678901 `).
+ *
+ * @param board Pointer to the board, may be `NULL`.
+ * @param out   Position in a reserved writer line, see `writer_reserve()`.
+ * @return End of the formatted tag.
+ */
+char* print_board_tag(const WiiBalanceBoard* board, char* out);
 
 /**
  * @brief Thread function for monitoring user input to control the Wii Balance Board.
  *
- * Waits for user input via the console or the power button of the board. If the user presses the button or the enter key
- * without additional characters, the function sets the `is_running` flag of the `WiiBalanceBoard`
- * object to `false` and exits the thread.
+ * Waits for user input via the console. A line `s` requests the timing statistics 
+ * (`stats_requested`), a line `l <level>` switches the text level of all boards 
+ * (`level_requested`). Any other line, usually the enter key
+ * without additional characters, sets the `is_running` flag of the `BoardDaemon`
+ * object to `false` and exits the thread. (The power button of a board is handled in 
+ * `process_received_data()` and only stops that board.)
  *
- * @param arg A void pointer to the `WiiBalanceBoard` object passed to the function
+ * @param arg A void pointer to the `BoardDaemon` object passed to the function
  *            and called at runtime to change the status.
  * @return Always `NULL` – indicates that the thread has terminated.
  */
@@ -292,13 +860,13 @@ void* threadFunction(void* arg);
  * @brief Creates a new thread and starts the `threadFunction` to monitor user control.
  *
  * This function creates a new thread and instructs it to execute the `threadFunction`.
- * In case of errors, an error message is displayed, the `is_running` flag of the Wii Balance Board is
+ * In case of errors, an error message is displayed, the `is_running` flag of the daemon is
  * set to `false`, and the program exits with an error code.
  *
- * @param board Pointer to the `WiiBalanceBoard` object monitored by the threadFunction.
+ * @param daemon Pointer to the `BoardDaemon` object monitored by the threadFunction.
  * @param threadId Pointer to the `pthread_t` variable where the ID of the new thread will be stored.
  */
-void createThread(WiiBalanceBoard* board, pthread_t* threadId);
+void createThread(BoardDaemon* daemon, pthread_t* threadId);
 
 /**
  * @brief Validates a given MAC address for format and content.
@@ -316,78 +884,84 @@ void createThread(WiiBalanceBoard* board, pthread_t* threadId);
  * @return `1` if the MAC address is valid; otherwise, `0`.
  */
 int is_valid_mac(int argc, char *argv[]);
-/** @} */
 
 /**
- * @defgroup CommandHandlers Command Handlers
- * @brief Functions for handling specific commands to the Wii Balance Board.
- * 
- * These functions individually handle specific commands for the Wii Balance Board, such as 
- * status checks, calibration, LED control, and activation. Each function is called 
- * when its corresponding flag in the `WiiBalanceBoard` structure is set.
- * 
- * While these commands are currently implemented as separate functions, they could 
- * potentially be unified into a single, generic `handle_send_command` function in 
- * the future. This separation was initially implemented to manage any specific 
- * cases or exceptions as outlined in `Wiimote` on `Wiibrew`, which I must admit, I did not fully understand. 
- * 
- * If it continues to be straightforward, these functions can later be consolidated 
- * to streamline the code and remove redundancy.
- * @{
+ * @brief Validates a single MAC address string of the format `XX:XX:XX:XX:XX:XX`.
+ *
+ * Used by `is_valid_mac()` and for every address of the list given in daemon mode.
+ *
+ * @param mac The MAC address to check.
+ * @return `1` if the MAC address is valid; otherwise, `0`.
  */
+int is_valid_mac_string(const char *mac);
+/** @} */
 
 /**
- * @brief Processes sending a status command to the Wii Balance Board.
+ * @defgroup CommandHandlers Command Handlers
+ * @brief Functions sending the init sequence to the Wii Balance Board and tracking its replies.
  * 
- * This function is called when the `needStatus` flag is set, 
- * and sends the corresponding status command to the board. 
+ * The commands used to be sent by one function each (`handle_status()`, 
+ * `handle_calibration()`, ...), every one of them only setting its own flag. They are 
+ * now unified into the generic `handle_send_command()` driven by the table 
+ * `init_commands` in `YAWiiBBessentials.c`: every entry names the command, the request 
+ * flag in `WiiBalanceBoard` and the reply the board sends for it.
  * 
- * @param board Pointer to the WiiBalanceBoard structure that holds the current status.
+ * `send_init_commands()` sends all pending commands back-to-back in one pass of the 
+ * main loop. `track_init_reply()` matches the 0x22, 0x20 and 0x21 reports against the 
+ * outstanding commands, and `check_init_replies()` repeats commands whose reply got 
+ * lost. Once all replies have arrived and the first 0x32 report was received, the 
+ * time from connect to the first sample is printed to stderr.
+ * @{
  */
-void handle_status(WiiBalanceBoard* board);
 
 /**
- * @brief Processes sending a calibration command to the Wii Balance Board.
+ * @brief Sends one command of the init sequence and waits for its reply.
  * 
- * This function is called when the `needCalibration` flag is set, 
- * and sends the corresponding calibration command to the board.
+ * Clears the request flag of the command and marks it as outstanding in `board->init`. 
+ * A failed send is repeated like a lost reply.
  * 
  * @param board Pointer to the WiiBalanceBoard structure that holds the current status.
+ * @param step  Command to send.
  */
-void handle_calibration(WiiBalanceBoard* board);
+void handle_send_command(WiiBalanceBoard* board, InitStep step);
 
 /**
- * @brief Processes sending an LED on command to the Wii Balance Board.
+ * @brief Sends every command of the init sequence whose request flag is set.
  * 
- * This function is called when the LED flag `led` is not set,
- * and turns on the board's LED.
+ * Called from `main_loop()` for every connected board. The flags are `needStatus`, 
+ * `needCalibration`, `needLed`, `needActivation` and `needDumpStart`.
  * 
  * @param board Pointer to the WiiBalanceBoard structure that holds the current status.
  */
-void handle_led_on(WiiBalanceBoard* board);
+void send_init_commands(WiiBalanceBoard* board);
 
 /**
- * @brief Processes sending an activation command to the Wii Balance Board.
+ * @brief Matches a received report against the outstanding init commands.
  * 
- * This function is called when the `needActivation` flag is set, 
- * and sends the corresponding activation command to the board.
+ * Called by `drain_receive_sock()` for every report until the init is complete. 
+ * A 0x22 acknowledge completes the command it names, a 0x20 status report the status 
+ * request and the second 0x21 packet the calibration read. A reply with an error code 
+ * sends the command again. The first 0x32 report sets `init.first_sample_ns`.
  * 
- * @param board Pointer to the WiiBalanceBoard structure that holds the current status.
+ * @param board       Board that received the report.
+ * @param report      Report parsed by `parse_report()`; invalid reports are ignored.
+ * @param received_ns Reception time of the report.
  */
-void handle_activation(WiiBalanceBoard* board);
+void track_init_reply(WiiBalanceBoard* board, const ReportView* report, uint64_t received_ns);
 
 /**
- * @brief Processes sending a data dump command (continous report of readings) to the Wii Balance Board.
+ * @brief Repeats init commands whose reply did not arrive in time.
  * 
- * This function is called when the `needDumpStart` flag is set, 
- * and starts the continuous transmission of board data.
+ * Called from `check_connections()` on every timer tick. A command unanswered for 
+ * `INIT_REPLY_TIMEOUT_MS` is sent again; after `INIT_MAX_RETRIES` repetitions it is 
+ * given up with a message, so a board that does not confirm a command still streams.
  * 
- * @param board Pointer to the WiiBalanceBoard structure that holds the current status.
+ * @param board Board to check.
+ * @param now   Current `CLOCK_MONOTONIC` time.
  */
-void handle_data_dump(WiiBalanceBoard* board);
+void check_init_replies(WiiBalanceBoard* board, uint64_t now);
 /** @} */
 
-#ifdef YAWIIBB_EXTENDED
 /**
  * @defgroup ExtendedProcessing Extended Data Processing
  * @brief Functions for interpreting and displaying Wii Balance Board data.
@@ -403,10 +977,9 @@ void handle_data_dump(WiiBalanceBoard* board);
  * in a separate file, but due to challenges in managing memory access and avoiding 
  * segmentation faults, they remain integrated within this file for now.
  * 
- * @note To activate these extended features, compile with the `YAWIIBB_EXTENDED` flag.
- *   @code
- *   gcc -DYAWIIBB_EXTENDED -Wall -o YAWiiBBD YAWiiBBD.c YAWiiBBessentials.c -lbluetooth
- *   @endcode
+ * @note These functions used to require the `YAWIIBB_EXTENDED` flag. They are always 
+ *       compiled in now, so the calibration is kept in every build and the DECODE and 
+ *       DEBUG output can be selected at runtime (`-l`).
  * @{
  */
 
@@ -419,8 +992,7 @@ void handle_data_dump(WiiBalanceBoard* board);
  * stored in a big-endian format and consist of 4 pairs 
  * for each of the four corners (topright, topleft, bottomright, bottomleft).
  *
- * @param bytes_read Number of bytes actually read in the buffer.
- * @param buffer Pointer to a buffer containing the received bytes. 
+ * @param report Parsed 0x21 report; `report->read.data` points to byte 7.
  *               The expected structure is:
  *               - Bytes 7-14: Calibration set 0 (4 pairs, 8 bytes)
  *               - Bytes 15-22: Calibration set 1 (4 pairs, 8 bytes)
@@ -429,8 +1001,8 @@ void handle_data_dump(WiiBalanceBoard* board);
  *                 - Bytes 15-22: Calibration set 2
  * @param board Pointer to the `WiiBalanceBoard` instance where calibration data will be stored.
  *
- * @note This function assumes that the `buffer` contains at least 
- *       23 bytes in order to process the expected calibration data.
+ * @note The length is checked once against `report->read.length`: the first packet 
+ *       needs 16 data bytes, the second 8. Shorter packets are ignored.
  *
  * @details 
  * The operation of the function is as follows:
@@ -449,29 +1021,27 @@ void handle_data_dump(WiiBalanceBoard* board);
  *   - buffer[15] = 0x00 (indicates that this is packet 2)
  * In this case, the function would only read bytes 7-8,[..],13-14 and store them in `board->calibration[2][i]`
  */
-void process_calibration_data(int* bytes_read, unsigned char* buffer, WiiBalanceBoard* board);
-
+void process_calibration_data(const ReportView* report, WiiBalanceBoard* board);
 
 /**
- * @brief Converts two consecutive bytes in the buffer from Big-Endian representation to a decimal integer.
- * 
- * Interprets two bytes in the given `buffer` starting from the provided `position` as a
- * 16-bit integer in Big-Endian format (most significant byte first). The function returns this
- * integer so that it can be output in decimal form.
- * 
- * @param buffer     Pointer to the buffer that contains the bytes.
- * @param position   The starting position of the most significant byte in the buffer.
- * @return uint16_t  The Big-Endian number interpreted as a decimal integer.
+ * @brief Derives the integer interpolation coefficients from `board->calibration`.
+ *
+ * Called by `process_calibration_data()` as soon as the second calibration packet 
+ * has arrived, so the division happens once per calibration instead of once per sample.
+ *
+ * @param board Pointer to the board whose calibration table is complete.
  */
-uint16_t bytes_to_int_big_endian(const unsigned char *buffer, size_t position, int* max);
+void precompute_mass_coefficients(WiiBalanceBoard* board);
 
 /**
  * @brief Calculates the weight in grams from the raw data of the Wii Balance Board.
  *
- * This function uses calibration data from the Wii Balance Board to calculate 
- * a weight in grams based on the given raw data. The weight 
- * is interpolated within four calibration ranges or, if the value 
+ * This function uses the coefficients precomputed from the calibration data 
+ * (see `MassCoefficients`) to calculate a weight in grams based on the given raw data. 
+ * The weight is interpolated within the calibration ranges or, if the value 
  * exceeds the highest calibration range, is linearly extrapolated.
+ * The segment is selected by comparison results instead of a branch chain 
+ * and no division is needed per sample.
  *
  * @param board A constant pointer to the Wii Balance Board structure that contains
  *              the calibration data.
@@ -480,7 +1050,8 @@ uint16_t bytes_to_int_big_endian(const unsigned char *buffer, size_t position, i
  * @param pos   The position of the sensor (0 to 3) for the calibration data of the raw value.
  *              Must be within the range [0, 3].
  *
- * @return The calculated weight in grams as `uint16_t`.
+ * @return The calculated weight in grams as `uint32_t` (no wrap above 65.5 kg), 
+ *         0 as long as no calibration has been received.
  * 
  * @note The function can interpolate weights up to 34 kg with the given 
  *       calibration values. For values above this range, 
@@ -495,7 +1066,7 @@ uint16_t bytes_to_int_big_endian(const unsigned char *buffer, size_t position, i
  *   - If the raw value is greater than or equal to the calibration for 34 kg, 
  *     linear extrapolation is performed based on the last range.
  */
-uint16_t calc_mass(const WiiBalanceBoard* board, uint16_t raw, int pos);
+uint32_t calc_mass(const WiiBalanceBoard* board, uint16_t raw, int pos);
 
 /**
  * @brief Displays the stored calibration data.
@@ -505,5 +1076,4 @@ uint16_t calc_mass(const WiiBalanceBoard* board, uint16_t raw, int pos);
  */
 void print_calibration_data(const WiiBalanceBoard* board);
 /** @} */
-#endif //YAWIIBB_EXTENDED
 #endif // YAWIIBBESSENTIALS_H
@@ -0,0 +1,171 @@
+#include "YAWiiBBfilter.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+/**
+ * @file YAWiiBBfilter.c
+ * @brief Core file for the filter and resampling stage predefined in YAWiiBBfilter.h.
+ */
+
+FilterConfig filter_config;
+
+
+// Audio EQ Cookbook, normalisiert auf a0 = 1
+static Biquad design_biquad(bool notch, double frequency, double q, double rate) {
+    double w0 = 2.0 * M_PI * frequency / rate;
+    double cosw = cos(w0), alpha = sin(w0) / (2.0 * q), a0 = 1.0 + alpha;
+    double b0 = notch ? 1.0 : (1.0 - cosw) / 2.0;
+    double b1 = notch ? -2.0 * cosw : 1.0 - cosw;
+    return (Biquad){
+        .b0 = b0 / a0, .b1 = b1 / a0, .b2 = b0 / a0,
+        .a1 = -2.0 * cosw / a0, .a2 = (1.0 - alpha) / a0
+    };
+}
+
+int filter_configure(FilterConfig* config, const char* spec, uint32_t rate) {
+    memset(config, 0, sizeof(*config));
+    if (rate < 1 || rate > FILTER_MAX_RATE) {
+        fprintf(stderr, "Fehler: Ausgaberate %u Hz, erlaubt sind 1 bis %d Hz\n", rate, FILTER_MAX_RATE);
+        return -1;
+    }
+    config->rate = rate;
+    config->oversampling = (FILTER_INTERNAL_MIN_RATE + rate - 1) / rate;
+    config->internal_rate = rate * config->oversampling;
+
+    const char* p = spec;
+    while (p != NULL && *p != '\0') {
+        bool notch;
+        if (strncmp(p, "lp:", 3) == 0) notch = false;
+        else if (strncmp(p, "notch:", 6) == 0) notch = true;
+        else {
+            fprintf(stderr, "Fehler: unbekannter Filter \"%s\", erwartet lp:<Hz>[:<Q>] oder notch:<Hz>[:<Q>]\n", p);
+            return -1;
+        }
+        if (config->stages == FILTER_MAX_STAGES) {
+            fprintf(stderr, "Fehler: höchstens %d Filterstufen\n", FILTER_MAX_STAGES);
+            return -1;
+        }
+        char* end;
+        double frequency = strtod(p + (notch ? 6 : 3), &end);
+        double q = notch ? FILTER_NOTCH_Q : FILTER_LOWPASS_Q;
+        if (*end == ':') q = strtod(end + 1, &end);
+        if (*end != ',' && *end != '\0') {
+            fprintf(stderr, "Fehler: Filterstufe \"%s\" nicht lesbar\n", p);
+            return -1;
+        }
+        // Oberhalb der halben Rate des Rasters ist der Entwurf nicht definiert
+        if (!(frequency > 0 && frequency < config->internal_rate / 2.0) || !(q > 0)) {
+            fprintf(stderr, "Fehler: Filterstufe \"%.*s\": Frequenz muss zwischen 0 und %.1f Hz liegen, Q über 0\n",
+                    (int)(end - p), p, config->internal_rate / 2.0);
+            return -1;
+        }
+        config->biquad[config->stages] = design_biquad(notch, frequency, q, config->internal_rate);
+        snprintf(config->description[config->stages], sizeof(config->description[0]), "%s %.4g Hz Q %.3g",
+                 notch ? "Kerbfilter" : "Tiefpass", frequency, q);
+        config->stages++;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return 0;
+}
+
+// Vektoren nur über Zeiger, als Wert übergeben hinge die Aufrufkonvention von -mavx ab
+static inline void load_masses(FilterVector* x, const uint32_t mass[4]) {
+    *x = (FilterVector){ mass[0], mass[1], mass[2], mass[3] };
+}
+
+// Nächster Rasterpunkt, ganzzahlig ab der vollen Sekunde, damit sich keine Rundungsfehler aufsummieren
+static inline uint64_t grid_point(const FilterConfig* config, const FilterState* state) {
+    return state->second_ns + (uint64_t)state->tick * 1000000000ull / config->internal_rate;
+}
+
+// Neubeginn bei x: Raster ab dem ersten Ausgabepunkt nach received_ns, Biquads im eingeschwungenen Zustand
+static void restart(const FilterConfig* config, FilterState* state, const FilterVector* first, uint64_t received_ns) {
+    uint64_t offset = received_ns % 1000000000ull;
+    uint64_t tick = (offset * config->internal_rate + 999999999ull) / 1000000000ull;
+    tick = (tick + config->oversampling - 1) / config->oversampling * config->oversampling;
+    state->second_ns = received_ns - offset;
+    if (tick >= config->internal_rate) {
+        state->second_ns += 1000000000ull;
+        tick = 0;
+    }
+    state->tick = (uint32_t)tick;
+
+    FilterVector x = *first;
+    for (int i = 0; i < config->stages; i++) {
+        const Biquad* b = &config->biquad[i];
+        double gain = (b->b0 + b->b1 + b->b2) / (1.0 + b->a1 + b->a2);
+        FilterVector y = gain * x;
+        state->z1[i] = y - b->b0 * x;
+        state->z2[i] = b->b2 * x - b->a2 * y;
+        x = y;
+    }
+}
+
+void filter_push(const FilterConfig* config, FilterState* state, const uint32_t mass[4], uint64_t received_ns) {
+    FilterVector x;
+    load_masses(&x, mass);
+    state->inputs++;
+    if (state->started && received_ns <= state->current_ns) {
+        state->skipped++; // Doppelt oder rückwärts, das Raster kann nur vorwärts
+        return;
+    }
+    if (!state->started || received_ns - state->current_ns > FILTER_MAX_GAP_MS * 1000000ull) {
+        if (state->started) state->restarts++;
+        state->started = true;
+        restart(config, state, &x, received_ns);
+        state->last = x;
+        state->last_ns = received_ns;
+    } else {
+        state->last = state->current;
+        state->last_ns = state->current_ns;
+    }
+    state->current = x;
+    state->current_ns = received_ns;
+}
+
+// Transponierte Direktform II, alle vier Sensoren in einem Vektor
+static inline void run_cascade(const FilterConfig* config, FilterState* state, FilterVector* value) {
+    FilterVector x = *value;
+    for (int i = 0; i < config->stages; i++) {
+        const Biquad* b = &config->biquad[i];
+        FilterVector y = b->b0 * x + state->z1[i];
+        state->z1[i] = b->b1 * x - b->a1 * y + state->z2[i];
+        state->z2[i] = b->b2 * x - b->a2 * y;
+        x = y;
+    }
+    *value = x;
+}
+
+bool filter_next(const FilterConfig* config, FilterState* state, uint32_t mass[4], uint64_t* sample_ns) {
+    if (!state->started) return false;
+    while (true) {
+        uint64_t point = grid_point(config, state);
+        if (point > state->current_ns) return false;
+
+        // Linear zwischen den beiden Reports, die den Rasterpunkt einschließen
+        FilterVector x = state->current;
+        if (point < state->current_ns) {
+            double t = (double)(point - state->last_ns) / (double)(state->current_ns - state->last_ns);
+            x = state->last + (state->current - state->last) * t;
+        }
+        run_cascade(config, state, &x);
+
+        bool emit = state->tick % config->oversampling == 0;
+        if (++state->tick == config->internal_rate) {
+            state->tick = 0;
+            state->second_ns += 1000000000ull;
+        }
+        if (!emit) continue;
+
+        for (int s = 0; s < 4; s++) mass[s] = x[s] > 0.0 ? (uint32_t)lrint(x[s]) : 0;
+        *sample_ns = point;
+        state->outputs++;
+        return true;
+    }
+}
+
+void filter_print(const FilterState* state, const char* prefix, FILE* out) {
+    fprintf(out, "%sFilter: %llu Werte, %llu Ausgaben, %llu Neustarts nach Lücken, %llu übersprungen\n", prefix,
+            (unsigned long long)state->inputs, (unsigned long long)state->outputs,
+            (unsigned long long)state->restarts, (unsigned long long)state->skipped);
+}
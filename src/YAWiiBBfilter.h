@@ -0,0 +1,148 @@
+#ifndef YAWIIBBFILTER_H
+#define YAWIIBBFILTER_H
+
+/**
+ * @file YAWiiBBfilter.h
+ * @brief Filter and resampling stage for the masses (`-F`, `-R`).
+ *
+ * The board sends its reports at an irregular rate (around 100 Hz with radio jitter
+ * and gaps), and the load cells are noisy. Instead of every consumer filtering on
+ * uneven timestamps, the output thread can put the masses of every calibrated board
+ * through this stage right after `calc_mass()`:
+ *
+ * 1. **Resampling**: the masses are interpolated linearly between two consecutive
+ *    reports at the points of a fixed grid, using the reception timestamps. The grid
+ *    runs at the output rate times `oversampling` and is aligned to whole seconds of
+ *    `CLOCK_MONOTONIC`, so the samples of all boards fall on the same points in time.
+ * 2. **Filtering**: a cascade of up to `FILTER_MAX_STAGES` biquads (low-pass and notch,
+ *    coefficients after the Audio EQ Cookbook) runs at the grid rate. The four
+ *    sensors are one `FilterVector`, so every biquad is a handful of vector
+ *    operations for all sensors (one AVX register, two SSE2 or NEON registers). The
+ *    lanes are doubles: at a low cutoff the poles lie close to 1, and float rounding of
+ *    masses around 30 kg drifts the output by several gram.
+ * 3. **Decimation**: every `oversampling`-th grid point is emitted. The internal rate
+ *    is at least `FILTER_INTERNAL_MIN_RATE`, so a low-pass below half the output rate
+ *    also keeps a 50 Hz output free of aliasing.
+ *
+ * Biquads need a constant sample rate, which is why the resampling comes first. The
+ * state of a board is a fixed-size `FilterState` (no buffers, no allocation). A gap
+ * longer than `FILTER_MAX_GAP_MS` (reconnect, nobody reading) restarts the grid, and the
+ * biquads start in the steady state of the first sample instead of ringing from zero.
+ *
+ * Every emitted sample goes through the normal outputs as a data report of its board
+ * with the filtered masses (rounded to gram) and the grid time as reception time;
+ * text, binary, shm, the socket server and the sway metrics therefore need no
+ * changes. Reports of uncalibrated boards and all other reports pass unchanged.
+ *
+ * @code
+ * filter_configure(&filter_config, "lp:8,notch:25", 100);
+ * filter_push(&filter_config, &board->filter, mass, received_ns);
+ * while (filter_next(&filter_config, &board->filter, mass, &sample_ns)) output(mass, sample_ns);
+ * @endcode
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define FILTER_MAX_STAGES 8               /**< Biquads in one cascade */
+#define FILTER_DEFAULT_RATE 100           /**< Output rate in Hz if `-F` is given without `-R` */
+#define FILTER_MAX_RATE 1000              /**< Highest output rate in Hz */
+#define FILTER_INTERNAL_MIN_RATE 200      /**< Least rate of the grid the biquads run at */
+#define FILTER_MAX_GAP_MS 250             /**< Longer gaps between two reports restart the stage */
+#define FILTER_LOWPASS_Q 0.70710678       /**< Butterworth Q of `lp` */
+#define FILTER_NOTCH_Q 5.0                /**< Default Q of `notch` */
+
+/** @brief The masses TR, BR, TL, BL of one sample, one vector lane per sensor. */
+typedef double FilterVector __attribute__((vector_size(32)));
+
+/**
+ * @struct Biquad
+ * @brief Coefficients of one second-order section, normalised to `a0 = 1`.
+ */
+typedef struct {
+    double b0, b1, b2;              /**< Numerator */
+    double a1, a2;                  /**< Denominator */
+} Biquad;
+
+/**
+ * @struct FilterConfig
+ * @brief The stage shared by all boards, set up once from `-F` and `-R`.
+ */
+typedef struct {
+    uint32_t rate;                  /**< Output rate in Hz, 0 = stage off */
+    uint32_t oversampling;          /**< Grid points per output sample */
+    uint32_t internal_rate;         /**< `rate * oversampling`, the rate of the biquads */
+    int stages;                     /**< Biquads in `biquad` */
+    Biquad biquad[FILTER_MAX_STAGES]; /**< Cascade in processing order */
+    char description[FILTER_MAX_STAGES][48]; /**< Stages for the messages, e.g. `"Tiefpass 8 Hz"` */
+} FilterConfig;
+
+extern FilterConfig filter_config;   /**< Selected with `-F` and `-R` */
+
+/**
+ * @struct FilterState
+ * @brief Resampling position and biquad state of one board (constant size).
+ */
+typedef struct {
+    bool started;                   /**< A first sample has been pushed */
+    uint64_t last_ns;               /**< Time of the previous sample */
+    FilterVector last;              /**< Masses of the previous sample */
+    uint64_t current_ns;            /**< Time of the newest sample */
+    FilterVector current;           /**< Masses of the newest sample */
+    uint64_t second_ns;             /**< Whole second the grid position counts from */
+    uint32_t tick;                  /**< Next grid point within the second (0 to `internal_rate - 1`) */
+    FilterVector z1[FILTER_MAX_STAGES], z2[FILTER_MAX_STAGES]; /**< Transposed direct form II state */
+    uint64_t inputs;                /**< Samples pushed */
+    uint64_t outputs;               /**< Samples emitted */
+    uint64_t restarts;              /**< Starts after a gap (without the first one) */
+    uint64_t skipped;               /**< Samples not newer than their predecessor */
+} FilterState;
+
+/**
+ * @brief Sets up the stage from a filter list and an output rate.
+ *
+ * The list holds comma-separated stages `lp:<Hz>[:<Q>]` (low-pass, Butterworth Q by
+ * default) and `notch:<Hz>[:<Q>]` (default Q `FILTER_NOTCH_Q`); an empty list only
+ * resamples. Every frequency must lie below half the internal rate.
+ *
+ * @param config Configuration to fill.
+ * @param spec   Filter list, `NULL` or empty for none.
+ * @param rate   Output rate in Hz (1 to `FILTER_MAX_RATE`).
+ * @return 0 on success, -1 for an invalid list or rate (message printed).
+ */
+int filter_configure(FilterConfig* config, const char* spec, uint32_t rate);
+
+/**
+ * @brief Adds the masses of one report to the stage of a board.
+ *
+ * Afterwards `filter_next()` returns the grid samples up to this report.
+ *
+ * @param config      Configured stage.
+ * @param state       State of the board.
+ * @param mass        Masses TR, BR, TL, BL in gram.
+ * @param received_ns Reception of the report (`CLOCK_MONOTONIC`).
+ */
+void filter_push(const FilterConfig* config, FilterState* state, const uint32_t mass[4], uint64_t received_ns);
+
+/**
+ * @brief Takes the next filtered sample up to the last pushed report.
+ *
+ * @param config    Configured stage.
+ * @param state     State of the board.
+ * @param mass      Receives the filtered masses in gram (rounded, negative values are 0).
+ * @param sample_ns Receives the grid time of the sample.
+ * @return `false` if no further sample is due.
+ */
+bool filter_next(const FilterConfig* config, FilterState* state, uint32_t mass[4], uint64_t* sample_ns);
+
+/**
+ * @brief Prints the counters of a board.
+ *
+ * @param state  State of the board.
+ * @param prefix Board tag (`"[0] "` or empty).
+ * @param out    Target stream (stderr).
+ */
+void filter_print(const FilterState* state, const char* prefix, FILE* out);
+
+#endif // YAWIIBBFILTER_H
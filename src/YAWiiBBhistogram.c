@@ -0,0 +1,41 @@
+#include "YAWiiBBhistogram.h"
+/**
+ * @file YAWiiBBhistogram.c
+ * @brief Core file for the histograms predefined in YAWiiBBhistogram.h.
+ */
+
+
+// Mitte des Wertebereichs eines Buckets
+static uint64_t bucket_middle(int index) {
+    if (index < (1 << HISTOGRAM_SUB_BITS)) return (uint64_t)index;
+    int magnitude = (index >> (HISTOGRAM_SUB_BITS - 1)) - 1;
+    uint64_t sub = (uint64_t)(index & ((1 << (HISTOGRAM_SUB_BITS - 1)) - 1)) + (1u << (HISTOGRAM_SUB_BITS - 1));
+    return (sub << magnitude) + ((1ull << magnitude) >> 1);
+}
+
+uint64_t histogram_percentile(const Histogram* histogram, double percentile) {
+    if (histogram->total == 0) return 0;
+    // Rang des gesuchten Werts, mindestens der erste
+    uint64_t rank = (uint64_t)(percentile / 100.0 * histogram->total + 0.5);
+    if (rank < 1) rank = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= rank) {
+            uint64_t value = bucket_middle(i);
+            if (value < histogram->min) return histogram->min;
+            return value > histogram->max ? histogram->max : value;
+        }
+    }
+    return histogram->max;
+}
+
+void histogram_print(const Histogram* histogram, const char* label, double divisor, const char* unit, FILE* out) {
+    if (histogram->total == 0) return;
+    fprintf(out, "%s: %llu Werte, Min %.3f, p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, Max %.3f, Mittel %.3f %s\n",
+            label, (unsigned long long)histogram->total, histogram->min / divisor,
+            histogram_percentile(histogram, 50) / divisor, histogram_percentile(histogram, 90) / divisor,
+            histogram_percentile(histogram, 99) / divisor, histogram_percentile(histogram, 99.9) / divisor,
+            histogram->max / divisor, histogram->sum / (double)histogram->total / divisor, unit);
+}
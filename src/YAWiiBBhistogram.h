@@ -0,0 +1,91 @@
+#ifndef YAWIIBBHISTOGRAM_H
+#define YAWIIBBHISTOGRAM_H
+
+/**
+ * @file YAWiiBBhistogram.h
+ * @brief Log-linear histograms of time intervals in the style of HdrHistogram.
+ *
+ * Every power of two is split into `2^(HISTOGRAM_SUB_BITS - 1)` linear buckets, so a
+ * value is reported (as the middle of its bucket) with a relative error below 1/128
+ * over the whole range from 1 ns to `2^HISTOGRAM_MAX_BITS` ns (about 18 minutes).
+ * Recording is a few shifts and one increment, the memory is fixed (`HISTOGRAM_BUCKETS`
+ * counters), so a histogram can be updated for every single report and kept for the
+ * whole run.
+ *
+ * ## Bucket Index
+ * Values below `2^HISTOGRAM_SUB_BITS` get a bucket of their own. Above, with `e` the
+ * position of the highest set bit and `m = e - HISTOGRAM_SUB_BITS + 1`, the value
+ * falls into bucket `64 * m + (value >> m)`; the lowest value of bucket `i >= 128` is
+ * `(i % 64 + 64) << (i / 64 - 1)`.
+ *
+ * @code
+ * Histogram h = { 0 };
+ * histogram_record(&h, interval_ns);
+ * histogram_print(&h, "Intervall", 1e6, "ms", stderr);
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define HISTOGRAM_SUB_BITS 7        /**< Bits of the linear part, 64 buckets per power of two */
+#define HISTOGRAM_MAX_BITS 40       /**< Values from `2^HISTOGRAM_MAX_BITS` on are recorded in the last bucket */
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 2) << (HISTOGRAM_SUB_BITS - 1)) /**< Number of counters */
+
+/**
+ * @struct Histogram
+ * @brief Counters of one histogram together with count, sum and extremes.
+ */
+typedef struct {
+    uint64_t counts[HISTOGRAM_BUCKETS]; /**< Number of values per bucket */
+    uint64_t total;                 /**< Number of recorded values */
+    uint64_t sum;                   /**< Sum of all recorded values (for the mean) */
+    uint64_t min;                   /**< Smallest recorded value (exact) */
+    uint64_t max;                   /**< Largest recorded value (exact) */
+} Histogram;
+
+/**
+ * @brief Returns the bucket of a value.
+ */
+static inline int histogram_index(uint64_t value) {
+    if (value >= (1ull << HISTOGRAM_MAX_BITS)) value = (1ull << HISTOGRAM_MAX_BITS) - 1;
+    if (value < (1u << HISTOGRAM_SUB_BITS)) return (int)value;
+    int magnitude = 63 - __builtin_clzll(value) - HISTOGRAM_SUB_BITS + 1;
+    return (magnitude << (HISTOGRAM_SUB_BITS - 1)) + (int)(value >> magnitude);
+}
+
+/**
+ * @brief Records one value.
+ */
+static inline void histogram_record(Histogram* histogram, uint64_t value) {
+    histogram->counts[histogram_index(value)]++;
+    if (histogram->total == 0 || value < histogram->min) histogram->min = value;
+    if (value > histogram->max) histogram->max = value;
+    histogram->total++;
+    histogram->sum += value;
+}
+
+/**
+ * @brief Returns the value below which the given share of the recorded values lies.
+ *
+ * The result is the middle of the bucket that contains the percentile, limited to the
+ * exact minimum and maximum.
+ *
+ * @param histogram  Histogram to evaluate.
+ * @param percentile Share in percent (0-100).
+ * @return The value at the percentile, 0 for an empty histogram.
+ */
+uint64_t histogram_percentile(const Histogram* histogram, double percentile);
+
+/**
+ * @brief Prints count, minimum, percentiles (50, 90, 99, 99.9), maximum and mean in one line.
+ *
+ * @param histogram Histogram to print (nothing is printed if it is empty).
+ * @param label     Text in front of the values.
+ * @param divisor   Divisor from nanoseconds to the printed unit (e.g. `1e6` for ms).
+ * @param unit      Printed unit.
+ * @param out       Stream to print to.
+ */
+void histogram_print(const Histogram* histogram, const char* label, double divisor, const char* unit, FILE* out);
+
+#endif // YAWIIBBHISTOGRAM_H
@@ -0,0 +1,24 @@
+#include "YAWiiBBreport.h"
+/**
+ * @file YAWiiBBreport.c
+ * @brief Layout table of the report parser predefined in YAWiiBBreport.h.
+ */
+
+
+// Nicht aufgeführte IDs bleiben 0, also REPORT_INVALID
+const ReportFormat report_formats[256] = {
+    [0x20] = { REPORT_STATUS, 8, 1, 0, 0 },
+    [0x21] = { REPORT_READ, 7, 1, 0, 0 },
+    [0x22] = { REPORT_ACK, 6, 1, 0, 0 },
+    [0x30] = { REPORT_INPUT, 4, 1, 0, 0 },
+    [0x31] = { REPORT_INPUT, 7, 1, 0, 0 },
+    [0x32] = { REPORT_DATA, 12, 1, 4, 8 },
+    [0x33] = { REPORT_INPUT, 19, 1, 0, 0 },
+    [0x34] = { REPORT_DATA, 23, 1, 4, 19 },
+    [0x35] = { REPORT_DATA, 23, 1, 7, 16 },
+    [0x36] = { REPORT_DATA, 23, 1, 14, 9 },
+    [0x37] = { REPORT_INPUT, 23, 1, 17, 6 },
+    [0x3d] = { REPORT_DATA, 23, 0, 2, 21 },
+    [0x3e] = { REPORT_INPUT, 23, 1, 0, 0 },
+    [0x3f] = { REPORT_INPUT, 23, 1, 0, 0 },
+};
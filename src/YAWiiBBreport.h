@@ -0,0 +1,205 @@
+#ifndef YAWIIBBREPORT_H
+#define YAWIIBBREPORT_H
+
+/**
+ * @file YAWiiBBreport.h
+ * @brief Table-driven parser for the input reports of the board.
+ *
+ * Every report starts with the HID header `0xa1` and the report ID. The table
+ * `report_formats` holds, indexed by that ID, the kind of the report, its minimum
+ * length and where buttons and extension bytes lie. `parse_report()` looks the ID up
+ * and checks the length once; all fields of the returned `ReportView` can then be
+ * read without further bounds checks. The view points into the receive buffer,
+ * nothing is copied.
+ *
+ * | ID        | Kind        | Min. length | Bytes after `a1 ID`                      |
+ * |-----------|-------------|-------------|------------------------------------------|
+ * | 0x20      | status      | 8           | `BB BB LF 00 00 VV` (flags, battery)     |
+ * | 0x21      | memory read | 7           | `BB BB SE AA AA` + up to 16 data bytes   |
+ * | 0x22      | acknowledge | 6           | `BB BB RR EE` (command, error code)      |
+ * | 0x30      | input       | 4           | `BB BB`                                  |
+ * | 0x31      | input       | 7           | `BB BB` + 3 accelerometer                |
+ * | 0x32      | data        | 12          | `BB BB` + 8 extension                    |
+ * | 0x33      | input       | 19          | `BB BB` + 3 accelerometer + 12 IR        |
+ * | 0x34      | data        | 23          | `BB BB` + 19 extension                   |
+ * | 0x35      | data        | 23          | `BB BB` + 3 accelerometer + 16 extension |
+ * | 0x36      | data        | 23          | `BB BB` + 10 IR + 9 extension            |
+ * | 0x37      | input       | 23          | `BB BB` + 3 accelerometer + 10 IR + 6 extension |
+ * | 0x3d      | data        | 23          | 21 extension                             |
+ * | 0x3e/0x3f | input       | 23          | `BB BB` + interleaved accelerometer/IR   |
+ *
+ * The balance board sends its four sensors (TR, BR, TL, BL, big-endian) in the first
+ * eight extension bytes. Only the layouts with at least eight extension bytes (0x32, 
+ * 0x34, 0x35, 0x36 and 0x3d) are `REPORT_DATA`, and `data.sensors` is always set for 
+ * them. The other 0x3x reports carry no sensor block and are `REPORT_INPUT`; they are 
+ * parsed (buttons, extension bytes of 0x37) but neither printed nor turned into samples. 
+ * Unknown IDs and reports shorter than their minimum length are `REPORT_INVALID`.
+ *
+ * @code
+ * ReportView report;
+ * if (parse_report(buffer, length, &report) == REPORT_DATA)
+ *     for (int i = 0; i < 4; i++) raw[i] = report_sensor(&report, i);
+ * @endcode
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define REPORT_BUTTON_A 0x0008            /**< Button bit of the balance board (its only button) */
+#define REPORT_READ_MAX 16                /**< Data bytes of one memory read packet */
+
+/**
+ * @enum ReportKind
+ * @brief Kind of an input report.
+ */
+typedef enum {
+    REPORT_INVALID,                 /**< Unknown ID or too short */
+    REPORT_STATUS,                  /**< 0x20 status */
+    REPORT_READ,                    /**< 0x21 memory read data */
+    REPORT_ACK,                     /**< 0x22 acknowledge of an output report */
+    REPORT_DATA,                    /**< Data report with the four sensor values (0x32, 0x34-0x36, 0x3d) */
+    REPORT_INPUT                    /**< Other 0x3x data report, no sensor block */
+} ReportKind;
+
+/**
+ * @struct ReportFormat
+ * @brief Entry of `report_formats`, layout of one report ID.
+ */
+typedef struct {
+    uint8_t kind;                   /**< `ReportKind` */
+    uint8_t min_length;             /**< Bytes including `a1 ID` */
+    uint8_t has_buttons;            /**< Bytes 2-3 hold the buttons */
+    uint8_t extension;              /**< Offset of the extension bytes, 0 = none */
+    uint8_t extension_length;       /**< Number of extension bytes */
+} ReportFormat;
+
+/**
+ * @brief Layout of every report ID, see the table above.
+ */
+extern const ReportFormat report_formats[256];
+
+/**
+ * @struct ReportView
+ * @brief Parsed report, the pointers refer to the receive buffer.
+ */
+typedef struct {
+    ReportKind kind;                /**< Kind, `REPORT_INVALID` if the report must not be interpreted */
+    uint8_t id;                     /**< Report ID (byte 1), 0 for reports shorter than 2 bytes */
+    uint16_t buttons;               /**< Buttons (bytes 2-3, big-endian), 0 if the report has none */
+    const unsigned char* bytes;     /**< Whole report starting with `0xa1` */
+    int length;                     /**< Number of bytes of the report */
+    union {
+        struct {
+            uint8_t flags;          /**< Byte 4: LEDs and flags */
+            uint8_t battery;        /**< Byte 7: battery level */
+        } status;                   /**< `REPORT_STATUS` */
+        struct {
+            uint8_t error;          /**< Lower half of byte 4, 0 = success */
+            uint8_t size;           /**< Data bytes announced in the upper half of byte 4 */
+            uint16_t address;       /**< Bytes 5-6: lower 16 bits of the address */
+            uint8_t length;         /**< Data bytes actually present (at most `REPORT_READ_MAX`) */
+            const unsigned char* data; /**< Byte 7: first data byte */
+        } read;                     /**< `REPORT_READ` */
+        struct {
+            uint8_t command;        /**< Byte 4: acknowledged output report */
+            uint8_t error;          /**< Byte 5: error code, 0 = success */
+        } ack;                      /**< `REPORT_ACK` */
+        struct {
+            const unsigned char* extension; /**< Extension bytes or `NULL` */
+            uint8_t extension_length;       /**< Number of extension bytes */
+            const unsigned char* sensors;   /**< Four big-endian sensor values, `NULL` for `REPORT_INPUT` */
+            uint32_t mass[4];               /**< Masses in gram of `REPORT_DATA`; not set by `parse_report()`, the output thread fills them before the report is processed */
+        } data;                     /**< `REPORT_DATA` and `REPORT_INPUT` */
+    };
+} ReportView;
+
+/** @brief Reads a big-endian 16-bit value, the caller guarantees both bytes exist. */
+static inline uint16_t report_be16(const unsigned char* bytes) {
+    return (uint16_t)((bytes[0] << 8) | bytes[1]);
+}
+
+/**
+ * @brief Parses a report once, see the table above.
+ *
+ * @param bytes  Report starting with `0xa1`.
+ * @param length Number of bytes.
+ * @param report View to fill.
+ * @return `report->kind`.
+ */
+static inline ReportKind parse_report(const unsigned char* bytes, int length, ReportView* report) {
+    report->bytes = bytes;
+    report->length = length;
+    report->id = length > 1 ? bytes[1] : 0;
+    const ReportFormat* format = &report_formats[report->id];
+    report->kind = length >= format->min_length ? (ReportKind)format->kind : REPORT_INVALID;
+    report->buttons = (report->kind != REPORT_INVALID && format->has_buttons) ? report_be16(bytes + 2) : 0;
+
+    switch (report->kind) {
+        case REPORT_STATUS:
+            report->status.flags = bytes[4];
+            report->status.battery = bytes[7];
+            break;
+        case REPORT_READ: {
+            int present = length - 7;
+            report->read.error = bytes[4] & 0x0f;
+            report->read.size = (uint8_t)((bytes[4] >> 4) + 1);
+            report->read.address = report_be16(bytes + 5);
+            report->read.length = (uint8_t)(present < REPORT_READ_MAX ? present : REPORT_READ_MAX);
+            report->read.data = bytes + 7;
+            break;
+        }
+        case REPORT_ACK:
+            report->ack.command = bytes[4];
+            report->ack.error = bytes[5];
+            break;
+        case REPORT_DATA:
+        case REPORT_INPUT:
+            report->data.extension = format->extension ? bytes + format->extension : NULL;
+            report->data.extension_length = format->extension_length;
+            report->data.sensors = format->extension_length >= 8 ? bytes + format->extension : NULL;
+            break;
+        case REPORT_INVALID:
+            break;
+    }
+    return report->kind;
+}
+
+/**
+ * @brief Points a view at a copy of its report.
+ *
+ * The pointers of a view refer to the bytes it was parsed from. After the report 
+ * has been copied (e.g. out of a ring slot), the view is moved to the copy instead 
+ * of parsing it again.
+ *
+ * @param report View parsed by `parse_report()`.
+ * @param bytes  Copy of `report->bytes`.
+ */
+static inline void report_rebase(ReportView* report, const unsigned char* bytes) {
+    const unsigned char* old = report->bytes;
+    report->bytes = bytes;
+    switch (report->kind) {
+        case REPORT_READ:
+            report->read.data = bytes + (report->read.data - old);
+            break;
+        case REPORT_DATA:
+        case REPORT_INPUT:
+            if (report->data.extension != NULL) report->data.extension = bytes + (report->data.extension - old);
+            if (report->data.sensors != NULL) report->data.sensors = bytes + (report->data.sensors - old);
+            break;
+        case REPORT_STATUS:
+        case REPORT_ACK:
+        case REPORT_INVALID:
+            break;
+    }
+}
+
+/**
+ * @brief Raw value of sensor @p i (0 TR, 1 BR, 2 TL, 3 BL).
+ *
+ * Only valid for `REPORT_DATA`.
+ */
+static inline uint16_t report_sensor(const ReportView* report, int i) {
+    return report_be16(report->data.sensors + 2 * i);
+}
+
+#endif // YAWIIBBREPORT_H
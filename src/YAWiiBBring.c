@@ -0,0 +1,88 @@
+#include "YAWiiBBring.h"
+#include <stdlib.h>
+#include <string.h>
+/**
+ * @file YAWiiBBring.c
+ * @brief Core file for the report ring predefined in YAWiiBBring.h.
+ */
+
+
+int ring_init(ReportRing* ring, uint32_t slots, DropPolicy policy) {
+    // Auf die nächste Zweierpotenz runden, damit der Index per Maske berechnet werden kann
+    uint32_t size = 1;
+    while (size < slots) size <<= 1;
+
+    memset(ring, 0, sizeof(*ring));
+    ring->slots = calloc(size, sizeof(ReportSlot));
+    if (ring->slots == NULL) return -1;
+    ring->mask = size - 1;
+    ring->policy = policy;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->overflows, 0);
+    atomic_init(&ring->closed, false);
+    return 0;
+}
+
+void ring_free(ReportRing* ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+ReportSlot* ring_reserve(ReportRing* ring) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    // Voll: in den Scratch-Slot empfangen, die Drop-Policy greift erst in ring_commit()
+    if (head - tail > ring->mask) return &ring->scratch;
+    return &ring->slots[head & ring->mask];
+}
+
+uint32_t ring_reserve_many(ReportRing* ring, ReportSlot** slots, uint32_t count) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint64_t free = ring->mask + 1 - (head - tail);
+    if (free == 0) {
+        slots[0] = &ring->scratch;
+        return 1;
+    }
+    // Hinter head liegen nur freie Slots, der Consumer liest sie erst nach ring_commit()
+    if (count > free) count = (uint32_t)free;
+    for (uint32_t i = 0; i < count; i++) slots[i] = &ring->slots[(head + i) & ring->mask];
+    return count;
+}
+
+void ring_commit(ReportRing* ring, ReportSlot* slot) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if (slot == &ring->scratch) {
+        if (ring->policy == DROP_NEWEST) {
+            atomic_fetch_add_explicit(&ring->overflows, 1, memory_order_relaxed);
+            return;
+        }
+        // DROP_OLDEST: ältesten Report verwerfen. Schlägt der CAS fehl, hat der Consumer
+        // inzwischen selbst gelesen und es ist ohnehin wieder Platz.
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head - tail > ring->mask &&
+            atomic_compare_exchange_strong_explicit(&ring->tail, &tail, tail + 1,
+                                                    memory_order_acq_rel, memory_order_acquire))
+            atomic_fetch_add_explicit(&ring->overflows, 1, memory_order_relaxed);
+        ring->slots[head & ring->mask] = ring->scratch;
+    }
+
+    uint64_t fill = head + 1 - atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (fill > ring->high_water) ring->high_water = fill;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+bool ring_pop(ReportRing* ring, ReportSlot* out) {
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    while (true) {
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail == head) return false;
+        *out = ring->slots[tail & ring->mask];
+        // Nur gültig, wenn der Producer den Slot nicht zwischenzeitlich verworfen hat
+        if (atomic_compare_exchange_strong_explicit(&ring->tail, &tail, tail + 1,
+                                                    memory_order_acq_rel, memory_order_acquire))
+            return true;
+    }
+}
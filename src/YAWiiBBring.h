@@ -0,0 +1,135 @@
+#ifndef YAWIIBBRING_H
+#define YAWIIBBRING_H
+
+/**
+ * @file YAWiiBBring.h
+ * @brief Lock-free single-producer/single-consumer ring for received reports.
+ *
+ * The receive thread (producer) `recv()`s every report directly into a slot of
+ * this preallocated ring, the output thread (consumer) decodes and writes the
+ * reports to stdout. A stalled consumer therefore never stops the producer from
+ * draining the L2CAP sockets; once the ring is full, the `DropPolicy` decides
+ * which report is lost and `overflows` counts it.
+ *
+ * ## Producer
+ * @code
+ * ReportSlot* slot = ring_reserve(ring);
+ * slot->length = recv(sock, slot->data, sizeof(slot->data), MSG_DONTWAIT);
+ * if (slot->length > 1) ring_commit(ring, slot);
+ * @endcode
+ * A batched receive (`recvmmsg()`) takes several consecutive slots at once with
+ * `ring_reserve_many()` and commits them one after the other.
+ *
+ * ## Consumer
+ * @code
+ * ReportSlot report;
+ * while (ring_pop(ring, &report)) process(&report);
+ * @endcode
+ *
+ * `head` is only written by the producer. `tail` is advanced by the consumer and,
+ * with `DROP_OLDEST`, also by the producer when it discards the oldest report;
+ * both use compare-and-swap, so a consumer that copied a slot while the producer
+ * dropped it notices the failed swap and discards its copy.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "YAWiiBBreport.h"
+
+#define RING_SLOT_SIZE 24       /**< Payload bytes per slot, equal to BUFFER_SIZE */
+#define RING_DEFAULT_SLOTS 1024 /**< Default number of slots (about 10 s of reports of one board) */
+
+/**
+ * @enum DropPolicy
+ * @brief Decides which report is discarded when the ring is full.
+ */
+typedef enum {
+    DROP_OLDEST,    /**< Overwrite the oldest queued report, the consumer always sees the latest data */
+    DROP_NEWEST     /**< Discard the report just received, queued reports stay untouched */
+} DropPolicy;
+
+/**
+ * @struct ReportSlot
+ * @brief One received report together with its origin.
+ */
+typedef struct {
+    void* board;                    /**< `WiiBalanceBoard*` that received the report */
+    uint64_t received_ns;           /**< `CLOCK_MONOTONIC` at reception (kernel receive timestamp if available) */
+    int length;                     /**< Number of valid bytes in `data` */
+    unsigned char data[RING_SLOT_SIZE]; /**< Report as received */
+    ReportView view;                /**< `data` parsed by the receiving thread, see `report_rebase()` for copies */
+} ReportSlot;
+
+/**
+ * @struct ReportRing
+ * @brief Preallocated ring of `ReportSlot`s with overflow counters.
+ */
+typedef struct {
+    ReportSlot* slots;              /**< `size` slots, `size` is a power of two */
+    uint32_t mask;                  /**< `size - 1` */
+    DropPolicy policy;              /**< Behaviour when full */
+    _Atomic uint64_t head;          /**< Next slot to be written (producer) */
+    _Atomic uint64_t tail;          /**< Next slot to be read (consumer) */
+    _Atomic uint64_t overflows;     /**< Number of reports lost because the ring was full */
+    uint64_t high_water;            /**< Largest fill level seen by the producer */
+    atomic_bool closed;             /**< Set by the producer when no more reports will follow */
+    ReportSlot scratch;             /**< Receive target while the ring is full */
+} ReportRing;
+
+/**
+ * @brief Allocates the slots of the ring.
+ *
+ * @param ring   Ring to initialise.
+ * @param slots  Requested number of slots, rounded up to the next power of two.
+ * @param policy Drop policy when the ring is full.
+ * @return 0 on success, -1 if the memory could not be allocated.
+ */
+int ring_init(ReportRing* ring, uint32_t slots, DropPolicy policy);
+
+/**
+ * @brief Releases the slots of the ring.
+ */
+void ring_free(ReportRing* ring);
+
+/**
+ * @brief Returns the slot the producer shall receive the next report into.
+ *
+ * If the ring is full, the internal scratch slot is returned and the drop policy
+ * is applied in `ring_commit()`. Nothing is published until `ring_commit()` is called,
+ * so an empty `recv()` simply does not commit.
+ */
+ReportSlot* ring_reserve(ReportRing* ring);
+
+/**
+ * @brief Returns up to @p count consecutive slots for one batched receive.
+ *
+ * `slots[0]` is the slot `ring_reserve()` would return, the others follow it. They
+ * are published in this order by `ring_commit()`, one call per slot; slots not
+ * committed are handed out again. If the ring is full, only the scratch slot is
+ * returned, so the drop policy still decides about every single report.
+ *
+ * @param ring  Ring to reserve from.
+ * @param slots Receives the slots.
+ * @param count Number of slots wanted, at least 1.
+ * @return Number of slots in @p slots, at least 1.
+ */
+uint32_t ring_reserve_many(ReportRing* ring, ReportSlot** slots, uint32_t count);
+
+/**
+ * @brief Publishes the slot returned by `ring_reserve()` to the consumer.
+ *
+ * Slots of `ring_reserve_many()` are committed in the order they were returned.
+ */
+void ring_commit(ReportRing* ring, ReportSlot* slot);
+
+/**
+ * @brief Takes the oldest report out of the ring (consumer only).
+ *
+ * @param ring Ring to read from.
+ * @param out  Receives a copy of the report.
+ * @return `true` if a report was copied, `false` if the ring is empty.
+ */
+bool ring_pop(ReportRing* ring, ReportSlot* out);
+
+#endif // YAWIIBBRING_H
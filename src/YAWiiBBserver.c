@@ -0,0 +1,328 @@
+#define _GNU_SOURCE // accept4()
+#include "YAWiiBBserver.h"
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <ctype.h>
+/**
+ * @file YAWiiBBserver.c
+ * @brief Core file for the fan-out server predefined in YAWiiBBserver.h.
+ */
+
+
+int server_open(FanoutServer* server, const char* path, int board_count) {
+    memset(server, 0, sizeof(*server));
+    for (int i = 0; i < SERVER_MAX_SUBSCRIBERS; i++) server->subscribers[i].fd = -1;
+    server->board_count = board_count;
+
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socketpfad zu lang: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    strcpy(server->path, path);
+
+    // Sammelt nur, der Text eines Reports wird von hier in die Warteschlangen kopiert
+    int text_result = writer_init(&server->text, SERVER_TEXT_MAX, NULL);
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (text_result != 0 || server->listen_fd < 0) {
+        perror("Fehler beim Anlegen des Server-Sockets");
+        return -1;
+    }
+    // Ein Socket eines früheren Laufs bleibt als Datei liegen, andere Dateien werden nie gelöscht
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "%s existiert und ist kein Socket, wird nicht ersetzt\n", path);
+            close(server->listen_fd);
+            return -1;
+        }
+        unlink(path);
+    }
+    if (bind(server->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(server->listen_fd, 8) < 0) {
+        perror("Fehler beim Öffnen des Server-Sockets");
+        close(server->listen_fd);
+        return -1;
+    }
+    return 0;
+}
+
+// Trennt einen Abonnenten und gibt seinen Slot frei
+static void drop_subscriber(FanoutServer* server, Subscriber* subscriber, const char* reason) {
+    fprintf(stderr, "Abonnent %d getrennt (%s), %llu Reports\n", subscriber->number, reason,
+            (unsigned long long)subscriber->reports);
+    if (subscriber->active) {
+        if (subscriber->format == OUTPUT_BINARY) server->binary_subscribers--;
+        else server->text_subscribers--;
+    }
+    close(subscriber->fd);
+    free(subscriber->queue);
+    free(subscriber->skipped);
+    memset(subscriber, 0, sizeof(*subscriber));
+    subscriber->fd = -1;
+}
+
+// Hängt Bytes an die Warteschlange, false wenn sie nicht mehr hineinpassen
+static bool enqueue(Subscriber* subscriber, const void* data, uint32_t length) {
+    if (SERVER_QUEUE_SIZE - (subscriber->head - subscriber->tail) < length) return false;
+    uint32_t start = subscriber->head & (SERVER_QUEUE_SIZE - 1);
+    uint32_t first = SERVER_QUEUE_SIZE - start < length ? SERVER_QUEUE_SIZE - start : length;
+    memcpy(subscriber->queue + start, data, first);
+    memcpy(subscriber->queue, (const unsigned char*)data + first, length - first);
+    subscriber->head += length;
+    return true;
+}
+
+// Wertet die Anfragezeile "<text|binary> [Dezimierung]" aus
+static void handle_request(FanoutServer* server, Subscriber* subscriber) {
+    char format[16];
+    unsigned long decimation = 1;
+    int consumed = 0;
+    bool valid = sscanf(subscriber->request, "%15s%n", format, &consumed) == 1;
+
+    if (valid && strcmp(format, "binary") == 0) subscriber->format = OUTPUT_BINARY;
+    else if (valid && strcmp(format, "text") == 0) subscriber->format = OUTPUT_TEXT;
+    else valid = false;
+    // strtoul() nähme auch "-1" an (als ULONG_MAX), daher nur Ziffern und eine Obergrenze
+    const char* p = subscriber->request + consumed;
+    while (*p == ' ' || *p == '\t') p++;
+    if (valid && *p != '\0') {
+        char* end;
+        errno = 0;
+        decimation = isdigit((unsigned char)*p) ? strtoul(p, &end, 10) : 0;
+        if (decimation != 0) p = end;
+        while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+        valid = errno == 0 && *p == '\0';
+    }
+    if (!valid || decimation == 0 || decimation > SERVER_MAX_DECIMATION) {
+        drop_subscriber(server, subscriber, "ungültige Anfrage");
+        return;
+    }
+
+    subscriber->decimation = (uint32_t)decimation;
+    subscriber->queue = malloc(SERVER_QUEUE_SIZE);
+    subscriber->skipped = calloc(server->board_count, sizeof(uint32_t));
+    if (subscriber->queue == NULL || subscriber->skipped == NULL) {
+        drop_subscriber(server, subscriber, "kein Speicher");
+        return;
+    }
+    subscriber->active = true;
+    if (subscriber->format == OUTPUT_BINARY) {
+        unsigned char header[YAWIIBB_BINARY_HEADER_SIZE];
+        binary_encode_header(header, (uint32_t)server->board_count);
+        enqueue(subscriber, header, sizeof(header));
+        server->binary_subscribers++;
+    } else {
+        server->text_subscribers++;
+    }
+    fprintf(stderr, "Abonnent %d: %s, jeder %lu. Datenreport\n", subscriber->number, format, decimation);
+}
+
+void server_publish(FanoutServer* server, const ReportView* report, const WiiBalanceBoard* board, bool formatted) {
+    if (server->text_subscribers + server->binary_subscribers == 0) return;
+
+    // Jedes Format höchstens einmal kodieren, egal wie viele Abonnenten es wollen
+    unsigned char record[YAWIIBB_BINARY_RECORD_SIZE];
+    BinarySample sample;
+    bool binary = server->binary_subscribers > 0 && build_binary_sample(report, board, &sample);
+    if (binary) binary_encode_sample(record, &sample);
+
+    // Ohne Text auf stdout (binär, Shared Memory) wird der Text hier formatiert
+    if (!formatted) {
+        server->text.length = 0;
+        if (server->text_subscribers > 0) print_info(report, board, &server->text);
+    }
+
+    bool data_report = report->kind == REPORT_DATA;
+    int board_index = board->id < 0 ? 0 : board->id;
+    for (int i = 0; i < SERVER_MAX_SUBSCRIBERS; i++) {
+        Subscriber* subscriber = &server->subscribers[i];
+        if (!subscriber->active) continue;
+        const void* data = subscriber->format == OUTPUT_BINARY ? (const void*)record : (const void*)server->text.buffer;
+        uint32_t length = subscriber->format == OUTPUT_BINARY ? (binary ? sizeof(record) : 0) : (uint32_t)server->text.length;
+        if (length == 0) continue;
+        // Fensterrecords (-W) sind schon ausgedünnt, sie gehen an jeden Text-Abonnenten
+        bool thin = data_report && (subscriber->format == OUTPUT_BINARY || aggregate_config.count == 0);
+        if (thin && subscriber->decimation > 1) {
+            if (subscriber->skipped[board_index] > 0) {
+                subscriber->skipped[board_index]--;
+                continue;
+            }
+            subscriber->skipped[board_index] = subscriber->decimation - 1;
+        }
+        if (!enqueue(subscriber, data, length)) {
+            drop_subscriber(server, subscriber, "zu langsam, Warteschlange voll");
+            continue;
+        }
+        subscriber->reports++;
+    }
+}
+
+void server_publish_text(FanoutServer* server) {
+    if (server->text.length == 0) return;
+    for (int i = 0; i < SERVER_MAX_SUBSCRIBERS; i++) {
+        Subscriber* subscriber = &server->subscribers[i];
+        if (!subscriber->active || subscriber->format != OUTPUT_TEXT) continue;
+        if (!enqueue(subscriber, server->text.buffer, (uint32_t)server->text.length)) {
+            drop_subscriber(server, subscriber, "zu langsam, Warteschlange voll");
+            continue;
+        }
+        subscriber->reports++;
+    }
+}
+
+// Sendet die Warteschlange mit einem sendmsg(), false wenn der Abonnent getrennt wurde
+static bool send_queue(FanoutServer* server, Subscriber* subscriber) {
+    uint32_t queued = subscriber->head - subscriber->tail;
+    if (queued == 0) return true;
+
+    uint32_t start = subscriber->tail & (SERVER_QUEUE_SIZE - 1);
+    uint32_t first = SERVER_QUEUE_SIZE - start < queued ? SERVER_QUEUE_SIZE - start : queued;
+    struct iovec iov[2] = {
+        { .iov_base = subscriber->queue + start, .iov_len = first },
+        { .iov_base = subscriber->queue, .iov_len = queued - first }
+    };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = queued > first ? 2 : 1 };
+    ssize_t sent = sendmsg(subscriber->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent < 0 && errno != EAGAIN && errno != EINTR) {
+        drop_subscriber(server, subscriber, strerror(errno));
+        return false;
+    }
+    if (sent > 0) subscriber->tail += (uint32_t)sent;
+    return true;
+}
+
+void server_flush(FanoutServer* server) {
+    for (int i = 0; i < SERVER_MAX_SUBSCRIBERS; i++)
+        if (server->subscribers[i].active) send_queue(server, &server->subscribers[i]);
+}
+
+// Nimmt alle wartenden Verbindungen an
+static void accept_subscribers(FanoutServer* server) {
+    int fd;
+    while ((fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        Subscriber* subscriber = NULL;
+        for (int i = 0; i < SERVER_MAX_SUBSCRIBERS && subscriber == NULL; i++)
+            if (server->subscribers[i].fd < 0) subscriber = &server->subscribers[i];
+        if (subscriber == NULL) {
+            fprintf(stderr, "Zu viele Abonnenten, Verbindung abgelehnt\n");
+            close(fd);
+            continue;
+        }
+        subscriber->fd = fd;
+        subscriber->number = ++server->connections;
+        subscriber->accepted_ns = monotonic_ns();
+    }
+}
+
+// Liest die Anfragezeile oder erkennt, dass der Abonnent aufgelegt hat
+static void read_subscriber(FanoutServer* server, Subscriber* subscriber, short revents) {
+    char buffer[SERVER_REQUEST_MAX];
+    ssize_t length = recv(subscriber->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    // Nur die Senderichtung geschlossen (socat, nc nach der Anfrage): weiter beliefern
+    if (length == 0 && subscriber->active && !(revents & (POLLHUP | POLLERR))) {
+        subscriber->input_closed = true;
+        return;
+    }
+    if (length == 0 || (length < 0 && errno != EAGAIN && errno != EINTR)) {
+        drop_subscriber(server, subscriber, "aufgelegt");
+        return;
+    }
+    // Nach der Anfrage wird alles Weitere ignoriert
+    for (ssize_t i = 0; i < length && !subscriber->active; i++) {
+        if (buffer[i] == '\n') {
+            subscriber->request[subscriber->request_length] = 0;
+            handle_request(server, subscriber);
+            return;
+        }
+        if (subscriber->request_length == SERVER_REQUEST_MAX - 1) {
+            drop_subscriber(server, subscriber, "Anfrage zu lang");
+            return;
+        }
+        subscriber->request[subscriber->request_length++] = buffer[i];
+    }
+}
+
+// Trennt Verbindungen ohne Anfragezeile nach SERVER_REQUEST_TIMEOUT_MS, liefert die Wartezeit bis zur nächsten Frist
+static int reap_idle_subscribers(FanoutServer* server) {
+    uint64_t now = monotonic_ns();
+    uint64_t timeout = (uint64_t)SERVER_REQUEST_TIMEOUT_MS * 1000000ull;
+    int wait_ms = -1;
+    for (int i = 0; i < SERVER_MAX_SUBSCRIBERS; i++) {
+        Subscriber* subscriber = &server->subscribers[i];
+        if (subscriber->fd < 0 || subscriber->active) continue;
+        uint64_t waited = now - subscriber->accepted_ns;
+        if (waited >= timeout) {
+            drop_subscriber(server, subscriber, "keine Anfrage");
+            continue;
+        }
+        int remaining = (int)((timeout - waited + 999999) / 1000000);
+        if (wait_ms < 0 || remaining < wait_ms) wait_ms = remaining;
+    }
+    return wait_ms;
+}
+
+int server_wait(FanoutServer* server, int wake_fd, int timeout_ms) {
+    struct pollfd fds[SERVER_MAX_SUBSCRIBERS + 2];
+    int slots[SERVER_MAX_SUBSCRIBERS + 2];
+    uint64_t deadline = timeout_ms < 0 ? UINT64_MAX : monotonic_ns() + (uint64_t)timeout_ms * 1000000ull;
+
+    while (true) {
+        int wait_ms = reap_idle_subscribers(server);
+        // Frist des Aufrufers (Fenster von -W), dann kehrt er ohne Report zurück
+        if (deadline != UINT64_MAX) {
+            uint64_t now = monotonic_ns();
+            if (now >= deadline) return 0;
+            int remaining = (int)((deadline - now + 999999) / 1000000);
+            if (wait_ms < 0 || remaining < wait_ms) wait_ms = remaining;
+        }
+        int count = 0;
+        fds[count++] = (struct pollfd){ .fd = wake_fd, .events = POLLIN };
+        fds[count++] = (struct pollfd){ .fd = server->listen_fd, .events = POLLIN };
+        for (int i = 0; i < SERVER_MAX_SUBSCRIBERS; i++) {
+            Subscriber* subscriber = &server->subscribers[i];
+            if (subscriber->fd < 0) continue;
+            // Rest der Warteschlange senden, sobald der Socket wieder Platz hat
+            short events = subscriber->input_closed ? 0 : POLLIN;
+            if (subscriber->head != subscriber->tail) events |= POLLOUT;
+            slots[count] = i;
+            fds[count++] = (struct pollfd){ .fd = subscriber->fd, .events = events };
+        }
+
+        if (poll(fds, count, wait_ms) < 0) {
+            if (errno == EINTR) continue;
+            perror("Fehler beim Warten auf Reports");
+            return -1;
+        }
+        if (fds[1].revents & POLLIN) accept_subscribers(server);
+        for (int i = 2; i < count; i++) {
+            Subscriber* subscriber = &server->subscribers[slots[i]];
+            if (subscriber->fd != fds[i].fd) continue;
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) read_subscriber(server, subscriber, fds[i].revents);
+            if (subscriber->fd == fds[i].fd && (fds[i].revents & POLLOUT)) send_queue(server, subscriber);
+        }
+        if (fds[0].revents & POLLIN) {
+            uint64_t wakeups;
+            if (read(wake_fd, &wakeups, sizeof(wakeups)) < 0 && errno != EINTR && errno != EAGAIN) {
+                perror("Fehler beim Warten auf Reports");
+                return -1;
+            }
+            return 0;
+        }
+    }
+}
+
+void server_close(FanoutServer* server) {
+    // Restliche Warteschlangen noch ausliefern, solange die Abonnenten lesen
+    for (int i = 0; i < SERVER_MAX_SUBSCRIBERS; i++) {
+        Subscriber* subscriber = &server->subscribers[i];
+        struct pollfd fd = { .fd = subscriber->fd, .events = POLLOUT };
+        while (subscriber->active && subscriber->head != subscriber->tail &&
+               poll(&fd, 1, SERVER_CLOSE_TIMEOUT_MS) > 0 && send_queue(server, subscriber)) {}
+    }
+    for (int i = 0; i < SERVER_MAX_SUBSCRIBERS; i++)
+        if (server->subscribers[i].fd >= 0) drop_subscriber(server, &server->subscribers[i], "Ende");
+    close(server->listen_fd);
+    unlink(server->path);
+    writer_free(&server->text);
+}
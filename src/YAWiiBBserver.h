@@ -0,0 +1,148 @@
+#ifndef YAWIIBBSERVER_H
+#define YAWIIBBSERVER_H
+
+/**
+ * @file YAWiiBBserver.h
+ * @brief Unix-domain socket server fanning the reports out to several subscribers.
+ *
+ * stdout can only feed one consumer. With `-u path` the output thread additionally
+ * listens on a Unix stream socket, so a recorder, a live display and an analysis can
+ * all follow the same boards. Every subscriber chooses its format and decimation
+ * with one request line right after connecting (within `SERVER_REQUEST_TIMEOUT_MS`):
+ * @code
+ * binary\n          every data report as binary record, see YAWiiBBbinary.h
+ * text 10\n         the text output, but only every 10th data report of each board
+ * @endcode
+ * n is a decimal number from 1 to `SERVER_MAX_DECIMATION`; any other request line
+ * closes the connection. A binary subscriber first gets the stream header, so its
+ * stream is byte for byte what `-o binary` writes to stdout. Decimation only thins
+ * out data reports (0x30-0x3f); status and calibration lines are always passed on.
+ *
+ * Each report is encoded at most once per format, no matter how many subscribers
+ * want it, and the bytes are appended to the queue of every subscriber. The queues
+ * are sent with one `sendmsg()` per subscriber at the same points where stdout is
+ * flushed (when the report ring runs empty), so a burst of reports costs one system
+ * call per subscriber rather than one per report. A queue holds `SERVER_QUEUE_SIZE`
+ * bytes; a subscriber that does not read fast enough to keep it from overflowing is
+ * disconnected, so one stalled consumer never holds up the others or the boards.
+ *
+ * The server belongs to the output thread, which waits in `server_wait()` (poll on
+ * its eventfd, the listening socket and all subscribers) instead of a plain read of
+ * the eventfd.
+ */
+
+#include "YAWiiBBessentials.h"
+
+#define SERVER_MAX_SUBSCRIBERS 16          /**< Subscribers served at the same time */
+#define SERVER_QUEUE_SIZE (1u << 18)       /**< Bytes queued per subscriber before it is disconnected */
+#define SERVER_REQUEST_MAX 64              /**< Longest accepted request line */
+/** Longest text of one report: the records of all window sizes (`-W`) closed by one sample */
+#define SERVER_TEXT_MAX (AGGREGATE_MAX_WINDOWS * (WRITER_LINE_MAX + AGGREGATE_LINE_MAX))
+#define SERVER_CLOSE_TIMEOUT_MS 200        /**< Longest wait for a subscriber to take its last bytes on exit */
+#define SERVER_REQUEST_TIMEOUT_MS 2000     /**< A connection without request line after this time is closed */
+#define SERVER_MAX_DECIMATION 10000        /**< Largest n of a request line `text|binary n` */
+
+/**
+ * @struct Subscriber
+ * @brief One connected client of the server.
+ */
+typedef struct {
+    int fd;                         /**< Connected socket, -1 if the slot is free */
+    int number;                     /**< Running number for the messages */
+    bool active;                    /**< Request line received, reports are queued */
+    OutputFormat format;            /**< `OUTPUT_TEXT` or `OUTPUT_BINARY` */
+    uint32_t decimation;            /**< Only every n-th data report of a board is passed on */
+    uint32_t* skipped;              /**< Data reports skipped since the last one passed on, per board */
+    char request[SERVER_REQUEST_MAX]; /**< Request line received so far */
+    int request_length;             /**< Bytes in `request` */
+    bool input_closed;              /**< The subscriber shut down its sending side after the request */
+    unsigned char* queue;           /**< Byte ring of `SERVER_QUEUE_SIZE` bytes */
+    uint32_t head;                  /**< Write position (free running) */
+    uint32_t tail;                  /**< Send position (free running) */
+    uint64_t reports;               /**< Reports queued for this subscriber */
+    uint64_t accepted_ns;           /**< `CLOCK_MONOTONIC` of the accept, for `SERVER_REQUEST_TIMEOUT_MS` */
+} Subscriber;
+
+/**
+ * @struct FanoutServer
+ * @brief Listening socket and subscribers of the server (`-u`).
+ */
+typedef struct FanoutServer {
+    int listen_fd;                  /**< Listening Unix stream socket */
+    char path[108];                 /**< Socket path, removed on exit */
+    int board_count;                /**< Boards of the daemon (binary header, decimation counters) */
+    Subscriber subscribers[SERVER_MAX_SUBSCRIBERS]; /**< Subscriber slots */
+    int connections;                /**< Number of accepted connections so far */
+    int text_subscribers;           /**< Active subscribers that want text */
+    int binary_subscribers;         /**< Active subscribers that want binary records */
+    TextWriter text;                /**< Collecting writer the text encoding is formatted into */
+} FanoutServer;
+
+/**
+ * @brief Creates the listening socket.
+ *
+ * @param server      Server to initialize.
+ * @param path        Socket path; a stale socket file is replaced, any other existing file is an error.
+ * @param board_count Number of boards of the daemon.
+ * @return 0 on success, -1 on failure (an error message is printed).
+ */
+int server_open(FanoutServer* server, const char* path, int board_count);
+
+/**
+ * @brief Encodes one report for the subscribers and appends it to their queues.
+ *
+ * Called by the output thread for every report after `process_received_data()`.
+ * Subscribers whose queue would overflow are disconnected.
+ *
+ * With text on stdout the output thread has already formatted the text of the report
+ * into `server->text` (data line, sway line with `-a`, or the records of the windows
+ * the report closed with `-W`) and written the same bytes to stdout, so a text
+ * subscriber without decimation gets exactly what stdout gets from its connect on.
+ * Otherwise the server formats the text with `print_info()`. Window records are never
+ * thinned out by the decimation of a subscriber.
+ *
+ * @param server    Server.
+ * @param report    Report parsed by the output thread.
+ * @param board     Board that received the report.
+ * @param formatted `server->text` already holds the text of the report.
+ */
+void server_publish(FanoutServer* server, const ReportView* report, const WiiBalanceBoard* board, bool formatted);
+
+/**
+ * @brief Appends text that belongs to no report to the queues of all text subscribers.
+ *
+ * The output thread formats the window records of `-W` that are closed without a new
+ * sample (idle or lost board, exit) into `server->text`, writes them to stdout and
+ * passes the same bytes on with this function.
+ *
+ * @param server Server.
+ */
+void server_publish_text(FanoutServer* server);
+
+/**
+ * @brief Sends as much of every queue as the sockets take, one `sendmsg()` each.
+ */
+void server_flush(FanoutServer* server);
+
+/**
+ * @brief Serves the socket until the eventfd of the output thread becomes readable
+ *        or @p timeout_ms has passed.
+ *
+ * Accepts new subscribers, reads their request lines, sends queues that could not
+ * be sent completely before and removes subscribers that hung up. A connection that
+ * has not sent its request line within `SERVER_REQUEST_TIMEOUT_MS` is closed, so idle
+ * connects cannot use up the `SERVER_MAX_SUBSCRIBERS` slots.
+ *
+ * @param server     Server.
+ * @param wake_fd    eventfd of the output thread, read (reset) before returning.
+ * @param timeout_ms Return after this time even without a report, -1 = no limit.
+ * @return 0, or -1 if waiting failed.
+ */
+int server_wait(FanoutServer* server, int wake_fd, int timeout_ms);
+
+/**
+ * @brief Disconnects all subscribers and removes the socket.
+ */
+void server_close(FanoutServer* server);
+
+#endif // YAWIIBBSERVER_H
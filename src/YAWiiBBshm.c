@@ -0,0 +1,141 @@
+#include "YAWiiBBshm.h"
+#include "YAWiiBBsway.h"
+#include <stdio.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+/**
+ * @file YAWiiBBshm.c
+ * @brief Core file for the shared-memory ring predefined in YAWiiBBshm.h.
+ */
+
+
+_Static_assert(offsetof(ShmRingHeader, write_seq) == 64, "write_seq muss bei Offset 64 liegen");
+_Static_assert(sizeof(ShmRingHeader) == YAWIIBB_SHM_MAC_OFFSET, "Kopf muss 128 Bytes groß sein");
+_Static_assert(sizeof(ShmLatest) == 64, "Ein Latest-Slot muss eine Cache-Line füllen");
+
+// Prüft, ob das Objekt gerade von einem noch lebenden Treiber beschrieben wird
+static bool owner_alive(const char* name, uint32_t* pid) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    bool alive = false;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(ShmRingHeader)) {
+        ShmRingHeader* header = mmap(NULL, sizeof(ShmRingHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if (header != MAP_FAILED) {
+            *pid = header->writer_pid;
+            // kill(pid, 0) stellt nur fest, ob der Prozess existiert; EPERM heißt: er lebt, gehört aber jemand anderem
+            alive = memcmp(header->magic, YAWIIBB_SHM_MAGIC, 4) == 0 &&
+                    __atomic_load_n(&header->running, __ATOMIC_ACQUIRE) && *pid != 0 &&
+                    (kill((pid_t)*pid, 0) == 0 || errno == EPERM);
+            munmap(header, sizeof(ShmRingHeader));
+        }
+    }
+    close(fd);
+    return alive;
+}
+
+int shm_ring_open(ShmRing* ring, const char* name, uint32_t capacity, uint32_t board_count) {
+    memset(ring, 0, sizeof(*ring));
+    snprintf(ring->name, sizeof(ring->name), "%s%s", name[0] == '/' ? "" : "/", name);
+
+    uint32_t records = 1;
+    while (records < capacity && records < (1u << 31)) records <<= 1;
+    // Latest-Slots und Datenbereich auf Cache-Lines ausrichten
+    uint32_t latest_offset = (YAWIIBB_SHM_MAC_OFFSET + 18 * board_count + 63) & ~63u;
+    uint32_t data_offset = latest_offset + (uint32_t)sizeof(ShmLatest) * board_count;
+    ring->size = data_offset + (size_t)records * YAWIIBB_BINARY_RECORD_SIZE;
+
+    // Ein verwaistes Objekt eines beendeten oder abgestürzten Laufs wird ersetzt, Leser mit alter
+    // Abbildung behalten es. Das Objekt eines laufenden Treibers bleibt unangetastet.
+    uint32_t owner = 0;
+    if (owner_alive(ring->name, &owner)) {
+        fprintf(stderr, "Shared-Memory-Ring %s wird bereits von Prozess %u beschrieben, anderen Namen mit -m wählen\n",
+                ring->name, owner);
+        return -1;
+    }
+    shm_unlink(ring->name);
+    int fd = shm_open(ring->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        perror("Fehler beim Anlegen des Shared-Memory-Rings");
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)ring->size) < 0) {
+        perror("Fehler beim Anlegen des Shared-Memory-Rings");
+        close(fd);
+        shm_unlink(ring->name);
+        return -1;
+    }
+    void* base = mmap(NULL, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("Fehler beim Abbilden des Shared-Memory-Rings");
+        shm_unlink(ring->name);
+        return -1;
+    }
+
+    ring->header = (ShmRingHeader*)base;
+    ring->records = (unsigned char*)base + data_offset;
+    ring->latest = (ShmLatest*)((unsigned char*)base + latest_offset);
+    ring->mask = records - 1;
+    memcpy(ring->header->magic, YAWIIBB_SHM_MAGIC, 4);
+    ring->header->version = YAWIIBB_SHM_VERSION;
+    ring->header->record_size = YAWIIBB_BINARY_RECORD_SIZE;
+    ring->header->capacity = records;
+    ring->header->board_count = board_count;
+    ring->header->data_offset = data_offset;
+    ring->header->latest_offset = latest_offset;
+    for (uint32_t i = 0; i < board_count; i++) ring->latest[i].board_id = (uint16_t)i;
+    ring->header->writer_pid = (uint32_t)getpid();
+    __atomic_store_n(&ring->header->running, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void shm_ring_set_mac(ShmRing* ring, uint32_t board_id, const char* mac) {
+    if (board_id >= ring->header->board_count) return;
+    char* entry = (char*)ring->header + YAWIIBB_SHM_MAC_OFFSET + 18 * board_id;
+    strncpy(entry, mac, 17);
+    entry[17] = 0;
+}
+
+void shm_latest_update(ShmRing* ring, const BinarySample* sample) {
+    if (sample->board_id >= ring->header->board_count) return;
+    ShmLatest* slot = &ring->latest[sample->board_id];
+    // Nur dieser Thread schreibt, ungerade Sequenz kündigt den Umbau an
+    uint32_t sequence = slot->sequence;
+    __atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    uint32_t total = sample->mass[0] + sample->mass[1] + sample->mass[2] + sample->mass[3];
+    slot->flags = sample->flags;
+    slot->timestamp_ns = sample->timestamp_ns;
+    slot->count++;
+    memcpy(slot->raw, sample->raw, sizeof(slot->raw));
+    memcpy(slot->mass, sample->mass, sizeof(slot->mass));
+    slot->total = total;
+    // Dieselbe Formel wie die Schwankungsmaße (-a)
+    if (sway_cop(sample->mass, slot->cop) && (sample->flags & BINARY_FLAG_MASS_VALID)) slot->flags |= SHM_FLAG_COP_VALID;
+    else slot->cop[0] = slot->cop[1] = 0.0f;
+
+    __atomic_store_n(&slot->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+void shm_ring_notify(ShmRing* ring) {
+    if (ring->write_seq == ring->notified_seq) return;
+    ring->notified_seq = ring->write_seq;
+    __atomic_add_fetch(&ring->header->wake, 1, __ATOMIC_SEQ_CST);
+    syscall(SYS_futex, &ring->header->wake, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+void shm_ring_close(ShmRing* ring) {
+    if (ring->header == NULL) return;
+    __atomic_store_n(&ring->header->running, 0, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&ring->header->wake, 1, __ATOMIC_SEQ_CST);
+    syscall(SYS_futex, &ring->header->wake, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+    munmap(ring->header, ring->size);
+    shm_unlink(ring->name);
+    ring->header = NULL;
+}
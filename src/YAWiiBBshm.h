@@ -0,0 +1,320 @@
+#ifndef YAWIIBBSHM_H
+#define YAWIIBBSHM_H
+
+/**
+ * @file YAWiiBBshm.h
+ * @brief Shared-memory ring of decoded samples (`-o shm`).
+ *
+ * With `-o shm` the output thread publishes every data report as a record of the
+ * binary format (`YAWiiBBbinary.h`) into a named POSIX shared-memory object
+ * (`-m name`, default `YAWIIBB_SHM_DEFAULT_NAME`, i.e. `/dev/shm/yawiibb`).
+ * Consumers map it read-only and follow a sequence counter, so reading a sample
+ * is a few loads and no system call. The driver never waits for its consumers:
+ * the ring simply overwrites the oldest records, and a consumer that fell behind
+ * by more than `capacity` records notices it from the counter and skips ahead.
+ *
+ * UIs that only show the current state of a board read its "latest" slot instead:
+ * one slot per board, protected by a seqlock and rewritten on every data report,
+ * holding raw values, masses, total weight, centre of pressure and timestamp. Any
+ * number of readers can sample it at their own frame rate without ever following
+ * the ring.
+ *
+ * Like `YAWiiBBbinary.h` this header only needs the C standard library and Linux
+ * headers, so readers can include it without BlueZ (see `testing/readShm.c`).
+ *
+ * ## Layout
+ * All header fields are in host byte order (the object never leaves the machine),
+ * the records are little-endian as in the binary stream.
+ * | Offset      | Size | Field        | Description                                         |
+ * |-------------|------|--------------|-----------------------------------------------------|
+ * | 0           | 4    | magic        | `"YWBS"`                                            |
+ * | 4           | 2    | version      | `YAWIIBB_SHM_VERSION`                               |
+ * | 6           | 2    | record_size  | Size of one record (`YAWIIBB_BINARY_RECORD_SIZE`)   |
+ * | 8           | 4    | capacity     | Number of records in the ring (power of two)        |
+ * | 12          | 4    | board_count  | Number of boards                                    |
+ * | 16          | 4    | data_offset  | Offset of record 0 from the start of the object     |
+ * | 20          | 4    | running      | 1 while the driver publishes, 0 after it ended      |
+ * | 24          | 4    | writer_pid   | Process ID of the driver                            |
+ * | 28          | 4    | latest_offset | Offset of the latest slot of board 0               |
+ * | 64          | 8    | write_seq    | Number of records published so far                  |
+ * | 72          | 4    | wake         | Futex word, incremented after every batch           |
+ * | 128         | 18 * boards | mac   | MAC address of every board (0 terminated)           |
+ * | latest_offset | 64 * boards | latest | Latest slot of every board (`ShmLatest`)         |
+ * | data_offset | record_size * capacity | records | The ring                          |
+ *
+ * Record number `n` (counting from 0 since the start of the driver) lives at
+ * `data_offset + (n % capacity) * record_size`. `write_seq` sits on a cache line of
+ * its own, so polling it does not disturb the static fields.
+ *
+ * ## Reading
+ * A consumer keeps the number `next` of the record it wants to read next:
+ * 1. Load `write_seq` (acquire). Nothing new if it equals `next`.
+ * 2. If `write_seq - next > capacity` the records up to `write_seq - capacity` are
+ *    lost; continue there.
+ * 3. Copy record `next`, then load `write_seq` again. The driver may already be
+ *    writing record `write_seq`, which replaces record `write_seq - capacity`, so the
+ *    copy is valid only if `write_seq - next < capacity`; otherwise go back to 2.
+ *
+ * `shm_ring_read()` implements exactly this. To block instead of polling, a consumer
+ * loads `wake`, checks `write_seq` once more and calls `FUTEX_WAIT` on `wake` with the
+ * loaded value (`shm_ring_wait()`); the driver increments `wake` and calls
+ * `FUTEX_WAKE` once per batch, not per record. The futex is a shared (not private)
+ * one and works on the read-only mapping.
+ *
+ * ## Latest Slot
+ * | Offset | Size | Field        | Description                                          |
+ * |--------|------|--------------|------------------------------------------------------|
+ * | 0      | 4    | sequence     | Seqlock counter, odd while the driver writes the slot |
+ * | 4      | 2    | board_id     | Index of the board                                   |
+ * | 6      | 1    | flags        | `BINARY_FLAG_*` and `SHM_FLAG_COP_VALID`             |
+ * | 8      | 8    | timestamp_ns | `CLOCK_MONOTONIC` at reception                       |
+ * | 16     | 8    | count        | Number of data reports of the board so far (0 = none yet) |
+ * | 24     | 8    | raw          | Raw sensor values TR, BR, TL, BL                     |
+ * | 32     | 16   | mass         | Masses in gram TR, BR, TL, BL                        |
+ * | 48     | 4    | total        | Sum of the masses in gram                            |
+ * | 52     | 8    | cop          | Centre of pressure x, y in mm (float)                |
+ *
+ * A reader loads `sequence` (acquire), retries while it is odd, copies the slot and
+ * accepts the copy if `sequence` is unchanged afterwards (`shm_latest_read()`). The
+ * masses, total and COP are only valid with `BINARY_FLAG_MASS_VALID` (calibrated board);
+ * the COP additionally needs `SHM_COP_MIN_WEIGHT` on the board.
+ * x points to the right (TR, BR), y to the front (TR, TL), the origin is the middle
+ * between the four sensors.
+ *
+ * ## numpy
+ * @code
+ * import mmap, numpy as np
+ * header = np.dtype([("magic", "S4"), ("version", "<u2"), ("record_size", "<u2"),
+ *                    ("capacity", "<u4"), ("board_count", "<u4"), ("data_offset", "<u4"),
+ *                    ("running", "<u4"), ("writer_pid", "<u4"), ("latest_offset", "<u4"),
+ *                    ("reserved", "V32"),
+ *                    ("write_seq", "<u8"), ("wake", "<u4"), ("reserved2", "V52")])
+ * sample = np.dtype([("timestamp_ns", "<u8"), ("board_id", "<u2"), ("report_type", "u1"),
+ *                    ("flags", "u1"), ("raw", "<u2", 4), ("mass", "<u4", 4)])
+ * with open("/dev/shm/yawiibb", "rb") as f:
+ *     mm = mmap.mmap(f.fileno(), 0, prot=mmap.PROT_READ)
+ * h = np.frombuffer(mm, header, count=1)[0]
+ * ring = np.frombuffer(mm, sample, count=h["capacity"], offset=h["data_offset"])
+ * seq = int(np.frombuffer(mm, "<u8", count=1, offset=64)[0])
+ * last = ring[(seq - 1) % h["capacity"]]
+ * latest = np.dtype([("sequence", "<u4"), ("board_id", "<u2"), ("flags", "u1"), ("pad", "u1"),
+ *                    ("timestamp_ns", "<u8"), ("count", "<u8"), ("raw", "<u2", 4),
+ *                    ("mass", "<u4", 4), ("total", "<u4"), ("cop", "<f4", 2), ("pad2", "V4")])
+ * slots = np.frombuffer(mm, latest, count=h["board_count"], offset=h["latest_offset"])
+ * @endcode
+ * A numpy view reads without the re-check of step 3, so copy what is needed and
+ * compare `write_seq` afterwards when records near the oldest end matter.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "YAWiiBBbinary.h"
+
+#define YAWIIBB_SHM_MAGIC "YWBS"              /**< Magic at the start of the shared-memory object */
+#define YAWIIBB_SHM_VERSION 1                 /**< Current version of the layout */
+#define YAWIIBB_SHM_DEFAULT_NAME "/yawiibb"   /**< Object name without `-m` */
+#define YAWIIBB_SHM_DEFAULT_RECORDS (1u << 16) /**< Records in the ring, about a minute at 1 kHz */
+#define YAWIIBB_SHM_MAC_OFFSET 128            /**< Offset of the MAC table */
+
+#define SHM_FLAG_COP_VALID 0x04               /**< `cop` of the latest slot is valid (continues `BINARY_FLAG_*`) */
+#define SHM_COP_MIN_WEIGHT 1000               /**< Least total weight in gram for a centre of pressure */
+#define SHM_SENSOR_DISTANCE_X 433.0f          /**< Distance of the left and right sensors in mm */
+#define SHM_SENSOR_DISTANCE_Y 238.0f          /**< Distance of the front and rear sensors in mm */
+
+/**
+ * @struct ShmRingHeader
+ * @brief Header at the start of the shared-memory object, see the layout table.
+ */
+typedef struct {
+    char magic[4];                  /**< `"YWBS"` */
+    uint16_t version;               /**< `YAWIIBB_SHM_VERSION` */
+    uint16_t record_size;           /**< Size of one record */
+    uint32_t capacity;              /**< Number of records, a power of two */
+    uint32_t board_count;           /**< Number of boards */
+    uint32_t data_offset;           /**< Offset of record 0 */
+    uint32_t running;               /**< 1 while the driver publishes */
+    uint32_t writer_pid;            /**< Process ID of the driver */
+    uint32_t latest_offset;         /**< Offset of the latest slot of board 0 */
+    uint32_t reserved[8];           /**< Zero */
+    uint64_t write_seq;             /**< Number of published records */
+    uint32_t wake;                  /**< Futex word, incremented after every batch */
+    uint32_t reserved2[13];         /**< Zero, fills the cache line of `write_seq` */
+} ShmRingHeader;
+
+/**
+ * @struct ShmLatest
+ * @brief Latest slot of one board, see the layout table.
+ */
+typedef struct {
+    uint32_t sequence;              /**< Seqlock counter, odd while the slot is written */
+    uint16_t board_id;              /**< Index of the board */
+    uint8_t flags;                  /**< `BINARY_FLAG_*` and `SHM_FLAG_COP_VALID` */
+    uint8_t reserved;               /**< Zero */
+    uint64_t timestamp_ns;          /**< `CLOCK_MONOTONIC` at reception */
+    uint64_t count;                 /**< Number of data reports so far */
+    uint16_t raw[4];                /**< Raw sensor values TR, BR, TL, BL */
+    uint32_t mass[4];               /**< Masses in gram TR, BR, TL, BL */
+    uint32_t total;                 /**< Sum of the masses in gram */
+    float cop[2];                   /**< Centre of pressure x, y in mm */
+    uint32_t reserved2;             /**< Zero, fills the slot to 64 bytes */
+} ShmLatest;
+
+/**
+ * @struct ShmRing
+ * @brief Writer side of the ring, owned by the output thread.
+ */
+typedef struct {
+    ShmRingHeader* header;          /**< Start of the mapping, `NULL` if not open */
+    unsigned char* records;         /**< Record 0 */
+    ShmLatest* latest;              /**< Latest slot of board 0 */
+    uint32_t mask;                  /**< `capacity - 1` */
+    uint64_t write_seq;             /**< Local copy of `header->write_seq` */
+    uint64_t notified_seq;          /**< `write_seq` at the last wakeup */
+    size_t size;                    /**< Size of the mapping */
+    char name[64];                  /**< Name of the object, for `shm_unlink()` */
+} ShmRing;
+
+/**
+ * @brief Checks magic, version and record size of a mapped object.
+ */
+static inline bool shm_ring_valid(const ShmRingHeader* header) {
+    return memcmp(header->magic, YAWIIBB_SHM_MAGIC, 4) == 0 && header->version == YAWIIBB_SHM_VERSION &&
+           header->record_size >= YAWIIBB_BINARY_RECORD_SIZE;
+}
+
+/**
+ * @brief Returns the MAC address of a board from the MAC table.
+ */
+static inline const char* shm_ring_mac(const ShmRingHeader* header, uint32_t board_id) {
+    return (const char*)header + YAWIIBB_SHM_MAC_OFFSET + 18 * board_id;
+}
+
+/**
+ * @brief Reads the next record for a consumer.
+ *
+ * @param header Mapped object.
+ * @param next   Number of the next record to read, advanced on success.
+ * @param sample Receives the record.
+ * @param lost   Incremented by the number of records that were overwritten before
+ *               they could be read.
+ * @return true if a record was read, false if there is nothing new.
+ */
+static inline bool shm_ring_read(const ShmRingHeader* header, uint64_t* next, BinarySample* sample, uint64_t* lost) {
+    const unsigned char* records = (const unsigned char*)header + header->data_offset;
+    uint64_t capacity = header->capacity;
+    uint64_t seq = __atomic_load_n(&header->write_seq, __ATOMIC_ACQUIRE);
+
+    while (*next < seq) {
+        if (seq - *next > capacity) {
+            *lost += seq - capacity - *next;
+            *next = seq - capacity;
+        }
+        binary_decode_sample(records + (*next & (capacity - 1)) * header->record_size, sample);
+        // Wurde der Slot während des Kopierens überschrieben?
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq = __atomic_load_n(&header->write_seq, __ATOMIC_RELAXED);
+        if (seq - *next < capacity) {
+            (*next)++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Takes a consistent copy of the latest slot of a board.
+ *
+ * @param header   Mapped object.
+ * @param board_id Index of the board (below `board_count`).
+ * @param latest   Receives the copy; `count == 0` means the board sent no data yet.
+ * @return true on success, false if the slot stayed inconsistent (driver died while
+ *         writing it).
+ */
+static inline bool shm_latest_read(const ShmRingHeader* header, uint32_t board_id, ShmLatest* latest) {
+    const ShmLatest* slot = (const ShmLatest*)((const unsigned char*)header + header->latest_offset) + board_id;
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        uint32_t before = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) continue;
+        memcpy(latest, slot, sizeof(*latest));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == before) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Blocks until records behind @p next are published, the driver ended or
+ *        the timeout expired.
+ *
+ * @param header     Mapped object.
+ * @param next       Number of the next record the consumer wants.
+ * @param timeout_ms Longest wait; the driver may die without a last wakeup.
+ */
+static inline void shm_ring_wait(const ShmRingHeader* header, uint64_t next, int timeout_ms) {
+    uint32_t wake = __atomic_load_n(&header->wake, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&header->write_seq, __ATOMIC_SEQ_CST) > next ||
+        !__atomic_load_n(&header->running, __ATOMIC_SEQ_CST)) return;
+    struct timespec timeout = { timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000 };
+    syscall(SYS_futex, &header->wake, FUTEX_WAIT, wake, &timeout, NULL, 0);
+}
+
+/**
+ * @brief Creates (or replaces) the shared-memory object and writes its header.
+ *
+ * An existing object is only replaced if its driver has ended: if its header says 
+ * `running` and `writer_pid` still exists, the call fails, so a second driver started 
+ * with the same `-m` name cannot destroy the ring of the first one.
+ *
+ * @param ring        Writer state to initialize.
+ * @param name        Object name, a leading `/` is added if missing.
+ * @param capacity    Number of records, rounded up to a power of two.
+ * @param board_count Number of boards (size of the MAC table).
+ * @return 0 on success, -1 on failure (an error message is printed).
+ */
+int shm_ring_open(ShmRing* ring, const char* name, uint32_t capacity, uint32_t board_count);
+
+/**
+ * @brief Enters the MAC address of a board into the MAC table.
+ */
+void shm_ring_set_mac(ShmRing* ring, uint32_t board_id, const char* mac);
+
+/**
+ * @brief Publishes one record.
+ *
+ * The record is visible to consumers as soon as this returns; sleeping consumers
+ * are only woken by `shm_ring_notify()`.
+ */
+static inline void shm_ring_publish(ShmRing* ring, const BinarySample* sample) {
+    binary_encode_sample(ring->records + (ring->write_seq & ring->mask) * YAWIIBB_BINARY_RECORD_SIZE, sample);
+    __atomic_store_n(&ring->header->write_seq, ++ring->write_seq, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Rewrites the latest slot of the board of @p sample.
+ *
+ * Computes total weight and centre of pressure from the masses and publishes
+ * everything under the seqlock. Called for every data report.
+ */
+void shm_latest_update(ShmRing* ring, const BinarySample* sample);
+
+/**
+ * @brief Wakes sleeping consumers if records were published since the last call.
+ *
+ * Called by the output thread once per batch, so there is at most one system call
+ * per wakeup of the output thread.
+ */
+void shm_ring_notify(ShmRing* ring);
+
+/**
+ * @brief Marks the ring as ended, wakes all consumers and removes the object.
+ *
+ * Consumers that still have it mapped keep reading the last records.
+ */
+void shm_ring_close(ShmRing* ring);
+
+#endif // YAWIIBBSHM_H
@@ -0,0 +1,90 @@
+#include "YAWiiBBsway.h"
+#include "YAWiiBBwriter.h"
+#include <math.h>
+/**
+ * @file YAWiiBBsway.c
+ * @brief Core file for the sway metrics predefined in YAWiiBBsway.h.
+ */
+
+SwayOutput sway_output = SWAY_OFF;
+
+
+bool sway_update(SwayStats* stats, const uint32_t mass[4], uint64_t received_ns) {
+    float cop[2];
+    if (!sway_cop(mass, cop)) {
+        stats->previous = false; // Niemand auf dem Board, der Weg setzt neu an
+        return false;
+    }
+    double x = cop[0], y = cop[1];
+    if (stats->previous && received_ns > stats->last_ns) {
+        stats->path += hypot(x - stats->x, y - stats->y);
+        stats->path_ns += received_ns - stats->last_ns;
+    }
+
+    // Welford: Mittelwert und Abweichungsquadrate in einem Durchgang
+    stats->count++;
+    double dx = x - stats->mean_x, dy = y - stats->mean_y;
+    stats->mean_x += dx / stats->count;
+    stats->mean_y += dy / stats->count;
+    stats->m2_x += dx * (x - stats->mean_x);
+    stats->m2_y += dy * (y - stats->mean_y);
+    stats->c_xy += dx * (y - stats->mean_y);
+
+    stats->x = x;
+    stats->y = y;
+    stats->last_ns = received_ns;
+    stats->previous = true;
+    return true;
+}
+
+void sway_metrics(const SwayStats* stats, SwayMetrics* metrics) {
+    metrics->count = stats->count;
+    metrics->duration_s = stats->path_ns / 1e9;
+    metrics->path_mm = stats->path;
+    metrics->velocity_mm_s = stats->path_ns ? stats->path / metrics->duration_s : 0;
+    double var_x = stats->count ? stats->m2_x / stats->count : 0;
+    double var_y = stats->count ? stats->m2_y / stats->count : 0;
+    double cov = stats->count ? stats->c_xy / stats->count : 0;
+    metrics->rms_x_mm = sqrt(var_x);
+    metrics->rms_y_mm = sqrt(var_y);
+    metrics->rms_mm = sqrt(var_x + var_y);
+    // Rundungsfehler können die Determinante knapp unter 0 drücken
+    double det = var_x * var_y - cov * cov;
+    metrics->ellipse_mm2 = det > 0 ? M_PI * SWAY_CHI2_95 * sqrt(det) : 0;
+}
+
+char* sway_format(const SwayStats* stats, bool valid, char* out) {
+    SwayMetrics metrics;
+    sway_metrics(stats, &metrics);
+    out = format_text(out, "COP ");
+    if (valid) {
+        out = format_tenths(out, stats->x);
+        *out++ = ' ';
+        out = format_tenths(out, stats->y);
+        out = format_text(out, " mm, Weg ");
+    } else {
+        out = format_text(out, "- (unter 1 kg), Weg ");
+    }
+    out = format_tenths(out, metrics.path_mm);
+    out = format_text(out, " mm, v ");
+    out = format_tenths(out, metrics.velocity_mm_s);
+    out = format_text(out, " mm/s, RMS ");
+    out = format_tenths(out, metrics.rms_x_mm);
+    *out++ = ' ';
+    out = format_tenths(out, metrics.rms_y_mm);
+    *out++ = ' ';
+    out = format_tenths(out, metrics.rms_mm);
+    out = format_text(out, " mm, Ellipse 95 % ");
+    out = format_tenths(out, metrics.ellipse_mm2);
+    out = format_text(out, " mm²\n");
+    return out;
+}
+
+void sway_print(const SwayStats* stats, const char* prefix, FILE* out) {
+    SwayMetrics metrics;
+    sway_metrics(stats, &metrics);
+    fprintf(out, "%sSchwankung: %llu Werte mit COP über %.1f s, mittlerer COP %.1f %.1f mm\n", prefix,
+            (unsigned long long)metrics.count, metrics.duration_s, stats->mean_x, stats->mean_y);
+    fprintf(out, "%sWeg %.1f mm, v %.1f mm/s, RMS x %.1f y %.1f gesamt %.1f mm, Ellipse 95 %% %.1f mm²\n", prefix,
+            metrics.path_mm, metrics.velocity_mm_s, metrics.rms_x_mm, metrics.rms_y_mm, metrics.rms_mm, metrics.ellipse_mm2);
+}
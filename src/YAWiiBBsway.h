@@ -0,0 +1,134 @@
+#ifndef YAWIIBBSWAY_H
+#define YAWIIBBSWAY_H
+
+/**
+ * @file YAWiiBBsway.h
+ * @brief Centre of pressure and postural sway metrics computed while streaming (`-a`).
+ *
+ * For balance measurements every consumer used to compute the centre of pressure (COP)
+ * from the four masses and to scan the whole session again for the sway metrics. The
+ * output thread now does both for every data report of a calibrated board, with a
+ * constant amount of work per sample and a few doubles of state per board:
+ *
+ * - COP x (right positive) and y (front positive) in mm from the masses TR, BR, TL, BL
+ *   and the sensor distances `SHM_SENSOR_DISTANCE_X`/`_Y`, the same formula as the
+ *   latest slot of `-o shm`. Below `SHM_COP_MIN_WEIGHT` there is no COP.
+ * - Sway path length: sum of the distances between consecutive COPs. A sample without
+ *   COP (nobody on the board) interrupts the path, the step back on is not counted.
+ * - Mean velocity: path length divided by the time covered by the path.
+ * - RMS: standard deviation of x and y around the mean COP and its total
+ *   `sqrt(var_x + var_y)`, updated with Welford's method (no second pass, no
+ *   cancellation over long sessions).
+ * - 95 % confidence ellipse area: `pi * chi2(0.95, 2) * sqrt(var_x * var_y - cov_xy^2)`
+ *   with `chi2(0.95, 2) = 5.991` (`SWAY_CHI2_95`).
+ *
+ * With `-a add` every data line of the text output is followed by a sway line, with
+ * `-a only` the sway line replaces it; the other reports are printed as before:
+ * @code
+ * [0] COP -12.3 45.6 mm, Weg 812.4 mm, v 20.3 mm/s, RMS 6.1 4.2 7.4 mm, Ellipse 95 % 512.7 mm²
+ * @endcode
+ * The metrics of the whole run are also printed to stderr with the other statistics.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "YAWiiBBshm.h"
+
+#define SWAY_CHI2_95 5.991464547107979 /**< 95 % quantile of the chi-square distribution with 2 degrees of freedom */
+
+/**
+ * @enum SwayOutput
+ * @brief What the text output shows for data reports (`-a`).
+ */
+typedef enum {
+    SWAY_OFF,                       /**< No sway metrics (default) */
+    SWAY_ADD,                       /**< Sway line after every data line */
+    SWAY_ONLY                       /**< Sway line instead of the data line */
+} SwayOutput;
+
+extern SwayOutput sway_output;     /**< Selected with `-a off|add|only` */
+
+/**
+ * @struct SwayStats
+ * @brief Running state of the sway metrics of one board.
+ */
+typedef struct {
+    uint64_t count;                 /**< Samples with a COP */
+    bool previous;                  /**< The last sample had a COP (the path continues) */
+    double x, y;                    /**< Last COP in mm */
+    uint64_t last_ns;               /**< Reception of the last sample with COP */
+    double mean_x, mean_y;          /**< Mean COP (Welford) */
+    double m2_x, m2_y, c_xy;        /**< Sums of squared deviations and of the co-deviations */
+    double path;                    /**< Sway path length in mm */
+    uint64_t path_ns;               /**< Time covered by the path */
+} SwayStats;
+
+/**
+ * @struct SwayMetrics
+ * @brief Metrics derived from `SwayStats`.
+ */
+typedef struct {
+    uint64_t count;                 /**< Samples with a COP */
+    double duration_s;              /**< Time covered by the path */
+    double path_mm;                 /**< Sway path length */
+    double velocity_mm_s;           /**< Mean velocity of the COP */
+    double rms_x_mm, rms_y_mm;      /**< Standard deviation of x and y */
+    double rms_mm;                  /**< `sqrt(rms_x^2 + rms_y^2)` */
+    double ellipse_mm2;             /**< Area of the 95 % confidence ellipse */
+} SwayMetrics;
+
+/**
+ * @brief Computes the centre of pressure from the masses TR, BR, TL, BL.
+ *
+ * @param mass Masses in gram.
+ * @param cop  Receives x (right positive) and y (front positive) in mm.
+ * @return `false` (and 0/0) if the total is below `SHM_COP_MIN_WEIGHT`.
+ */
+static inline bool sway_cop(const uint32_t mass[4], float cop[2]) {
+    uint32_t total = mass[0] + mass[1] + mass[2] + mass[3];
+    if (total < SHM_COP_MIN_WEIGHT) {
+        cop[0] = cop[1] = 0.0f;
+        return false;
+    }
+    // TR + BR rechts, TR + TL vorne
+    float right = (float)mass[0] + mass[1], front = (float)mass[0] + mass[2];
+    cop[0] = (2.0f * right / total - 1.0f) * SHM_SENSOR_DISTANCE_X / 2.0f;
+    cop[1] = (2.0f * front / total - 1.0f) * SHM_SENSOR_DISTANCE_Y / 2.0f;
+    return true;
+}
+
+/**
+ * @brief Adds one sample to the running metrics.
+ *
+ * @param stats       State of the board.
+ * @param mass        Masses TR, BR, TL, BL in gram.
+ * @param received_ns Reception of the sample (`CLOCK_MONOTONIC`).
+ * @return `true` if the sample had a COP.
+ */
+bool sway_update(SwayStats* stats, const uint32_t mass[4], uint64_t received_ns);
+
+/**
+ * @brief Derives path, velocity, RMS and ellipse area from the running state.
+ */
+void sway_metrics(const SwayStats* stats, SwayMetrics* metrics);
+
+/**
+ * @brief Formats the sway line of the last sample (without board tag), returns the end.
+ *
+ * Needs at most `SWAY_LINE_MAX` bytes.
+ */
+char* sway_format(const SwayStats* stats, bool valid, char* out);
+
+#define SWAY_LINE_MAX 192               /**< Longest line of `sway_format()` */
+
+/**
+ * @brief Prints the metrics of the whole run of a board.
+ *
+ * @param stats  State of the board.
+ * @param prefix Board tag (`"[0] "` or empty).
+ * @param out    Target stream (stderr).
+ */
+void sway_print(const SwayStats* stats, const char* prefix, FILE* out);
+
+#endif // YAWIIBBSWAY_H
@@ -0,0 +1,361 @@
+#define _GNU_SOURCE // recvmmsg()
+#include "YAWiiBBtransport.h"
+#include <strings.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+#include <linux/input.h>
+/**
+ * @file YAWiiBBtransport.c
+ * @brief Core file for the transports predefined in YAWiiBBtransport.h.
+ */
+
+// Ältere Header kennen die Abfrage der eindeutigen ID noch nicht (Kernel 5.6)
+#ifndef HIDIOCGRAWUNIQ
+#define HIDIOCGRAWUNIQ(len) _IOC(_IOC_READ, 'H', 0x08, len)
+#endif
+
+
+// Nachrichtenköpfe für recvmmsg(), nur vom Empfangsthread benutzt
+static struct {
+    struct mmsghdr messages[RECEIVE_BATCH];
+    struct iovec iov[RECEIVE_BATCH];
+    char control[RECEIVE_BATCH][CMSG_SPACE(sizeof(struct timespec))];
+} receive_batch;
+
+/* ---------- L2CAP ---------- */
+
+void l2cap_transport_init(void) {
+    // Die Nachrichtenköpfe bleiben gleich, pro Aufruf werden nur die Ziele der Slots eingetragen
+    for (int i = 0; i < RECEIVE_BATCH; i++) {
+        receive_batch.iov[i].iov_len = BUFFER_SIZE;
+        receive_batch.messages[i].msg_hdr = (struct msghdr){
+            .msg_iov = &receive_batch.iov[i],
+            .msg_iovlen = 1,
+            .msg_control = receive_batch.control[i]
+        };
+    }
+}
+
+static int l2cap_send(WiiBalanceBoard* board, const unsigned char* command, int length) {
+    return send_command(board->control_sock, command, length);
+}
+
+// Zeitstempel des Kernels für jeden empfangenen Report anfordern, ohne sie gilt CLOCK_MONOTONIC nach recvmsg()
+static void l2cap_prepare(WiiBalanceBoard* board) {
+    int on = 1;
+    if (setsockopt(board->receive_sock, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0)
+        perror("Hinweis: keine Empfangszeitstempel des Kernels");
+}
+
+// Kernelzeitstempel (CLOCK_REALTIME) mit dem Abstand der beiden Uhren nach CLOCK_MONOTONIC umrechnen
+static uint64_t receive_timestamp(WiiBalanceBoard* board, struct msghdr* msg, int64_t realtime_offset) {
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPNS) continue;
+        struct timespec ts;
+        memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+        if (ts.tv_sec == 0) break;
+        board->stats.kernel_stamps++;
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec - (uint64_t)realtime_offset;
+    }
+    board->stats.fallback_stamps++;
+    return monotonic_ns();
+}
+
+static int l2cap_receive(WiiBalanceBoard* board, ReportSlot** slots, uint32_t count, int64_t realtime_offset, bool* drained) {
+    // Direkt in die reservierten Slots empfangen, alles Wartende mit einem Aufruf
+    for (uint32_t i = 0; i < count; i++) {
+        receive_batch.iov[i].iov_base = slots[i]->data;
+        receive_batch.messages[i].msg_hdr.msg_controllen = sizeof(receive_batch.control[i]);
+    }
+    int received = recvmmsg(board->receive_sock, receive_batch.messages, count, MSG_DONTWAIT, NULL);
+    board->stats.receive_calls++;
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        *drained = true; // Socket leer
+        return 0;
+    }
+    if (received < 0) return -1;
+    // Weniger Reports als Slots: der Socket ist leer, ein weiterer Aufruf brächte nur EAGAIN
+    *drained = (uint32_t)received < count;
+
+    int filled = 0;
+    for (int i = 0; i < received; i++) {
+        int bytes_read = (int)receive_batch.messages[i].msg_len;
+        if (bytes_read == 0) {
+            // Verbindung getrennt: erst die Reports davor abgeben
+            *drained = true;
+            if (filled > 0) return filled;
+            errno = 0;
+            return -1;
+        }
+        if (bytes_read == 1) continue; // Zu kurz für einen Report, Verbindung aber intakt
+        // Nach einem übersprungenen Report rücken die folgenden in den nächsten freien Slot
+        ReportSlot* slot = slots[filled];
+        if (slot != slots[i]) memcpy(slot->data, slots[i]->data, (size_t)bytes_read);
+        slot->length = bytes_read;
+        slot->received_ns = receive_timestamp(board, &receive_batch.messages[i].msg_hdr, realtime_offset);
+        filled++;
+    }
+    return filled;
+}
+
+const Transport l2cap_transport = {
+    .name = "l2cap",
+    .send = l2cap_send,
+    .receive = l2cap_receive,
+    .prepare = l2cap_prepare,
+    .reopen = NULL
+};
+
+/* ---------- hidraw ---------- */
+
+// hidraw erwartet die Report-ID als erstes Byte, der HIDP-Kopf 0x52 entfällt
+static int hidraw_send(WiiBalanceBoard* board, const unsigned char* command, int length) {
+    if (write(board->receive_sock, command + 1, (size_t)(length - 1)) < 0) {
+        perror("Fehler beim Senden des Befehls");
+        return -1;
+    }
+    return 0;
+}
+
+static int hidraw_receive(WiiBalanceBoard* board, ReportSlot** slots, uint32_t count, int64_t realtime_offset, bool* drained) {
+    (void)realtime_offset; // hidraw liefert keine Zeitstempel des Kernels
+    int filled = 0;
+    while ((uint32_t)filled < count) {
+        // Ein Report pro read(), ohne HIDP-Kopf: 0xa1 davor, dann gleicht er dem L2CAP-Report
+        ReportSlot* slot = slots[filled];
+        ssize_t bytes_read = read(board->receive_sock, slot->data + 1, sizeof(slot->data) - 1);
+        board->stats.receive_calls++;
+        if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            *drained = true;
+            break;
+        }
+        if (bytes_read <= 0) {
+            // Gerät entfernt (EIO/ENODEV) oder Ende: erst die Reports davor abgeben
+            *drained = true;
+            if (filled > 0) break;
+            if (bytes_read == 0) errno = 0;
+            return -1;
+        }
+        slot->data[0] = 0xa1;
+        slot->length = (int)bytes_read + 1;
+        slot->received_ns = monotonic_ns();
+        board->stats.fallback_stamps++;
+        filled++;
+    }
+    return filled;
+}
+
+// Gerätename enthält HIDRAW_BOARD_NAME und (falls verlangt) die eindeutige ID ist die MAC-Adresse
+static bool hidraw_matches(int fd, const char* mac, char* uniq, size_t uniq_size) {
+    char name[256] = "";
+    if (ioctl(fd, HIDIOCGRAWNAME(sizeof(name)), name) < 0 || strstr(name, HIDRAW_BOARD_NAME) == NULL) return false;
+    memset(uniq, 0, uniq_size);
+    if (ioctl(fd, HIDIOCGRAWUNIQ(uniq_size - 1), uniq) < 0) uniq[0] = 0;
+    // Ohne vorgegebene MAC muss das Gerät seine Adresse nennen, sonst ließe es sich nicht wiederfinden
+    if (mac[0] == 0) return strlen(uniq) == 17;
+    return strcasecmp(uniq, mac) == 0;
+}
+
+// Durchsucht /dev/hidraw*, liefert den geöffneten Deskriptor und die ID des Geräts
+static int hidraw_find(const char* mac, char* uniq, size_t uniq_size, char* path, size_t path_size) {
+    for (int i = 0; i < HIDRAW_MAX_DEVICES; i++) {
+        snprintf(path, path_size, "/dev/hidraw%d", i);
+        int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) continue;
+        if (hidraw_matches(fd, mac, uniq, uniq_size)) return fd;
+        close(fd);
+    }
+    errno = ENODEV;
+    return -1;
+}
+
+int hidraw_open(WiiBalanceBoard* board) {
+    char uniq[64], path[32];
+    int fd = hidraw_find(board->mac, uniq, sizeof(uniq), path, sizeof(path));
+    if (fd < 0) {
+        fprintf(stderr, "Fehler: kein hidraw-Gerät für %s gefunden\n", board->mac[0] ? board->mac : "ein Balance Board");
+        return -1;
+    }
+    if (board->mac[0] == 0) {
+        // Erstes gefundenes Board, Schreibweise wie bei der Suche über Bluetooth
+        for (int i = 0; i < 17; i++) board->mac[i] = (char)toupper((unsigned char)uniq[i]);
+        board->mac[17] = 0;
+    }
+    board->receive_sock = fd;
+    board->control_sock = -1;
+    fprintf(stderr, "%s über %s\n", board->mac, path);
+    return 0;
+}
+
+// Ohne Meldung, den Fehlschlag meldet check_connections() mit dem nächsten Backoff
+static int hidraw_reopen(WiiBalanceBoard* board) {
+    char uniq[64], path[32];
+    board->receive_sock = hidraw_find(board->mac, uniq, sizeof(uniq), path, sizeof(path));
+    return board->receive_sock < 0 ? -1 : 0;
+}
+
+const Transport hidraw_transport = {
+    .name = "hidraw",
+    .send = hidraw_send,
+    .receive = hidraw_receive,
+    .prepare = NULL,
+    .reopen = hidraw_reopen
+};
+
+/* ---------- evdev ---------- */
+
+// Ereignisse eines read(), zwei pro Slot: jeder Rahmen hat mindestens eine Achse und sein SYN_REPORT
+static struct input_event evdev_events[2 * RECEIVE_BATCH];
+
+// Achsen in der Reihenfolge der Sensoren im 0x32-Report
+static const uint16_t evdev_axes[4] = { ABS_HAT0X, ABS_HAT0Y, ABS_HAT1X, ABS_HAT1Y };
+
+static uint16_t evdev_value(int32_t value) {
+    return value < 0 ? 0 : value > 0xffff ? 0xffff : (uint16_t)value;
+}
+
+// Achsen direkt abfragen: beim Öffnen und nach verlorenen Ereignissen
+static void evdev_sync(WiiBalanceBoard* board) {
+    for (int s = 0; s < 4; s++) {
+        struct input_absinfo info;
+        if (ioctl(board->receive_sock, EVIOCGABS(evdev_axes[s]), &info) == 0) board->evdev.axis[s] = evdev_value(info.value);
+    }
+    board->evdev.dropped = false;
+}
+
+// Der Kernel sendet nichts an das Board, die Init-Sequenz hat er selbst erledigt
+static int evdev_send(WiiBalanceBoard* board, const unsigned char* command, int length) {
+    (void)length;
+    fprintf(stderr, "%s: Kommando 0x%02x über evdev nicht möglich\n", board->mac, command[1]);
+    return -1;
+}
+
+static void evdev_prepare(WiiBalanceBoard* board) {
+    board->needStatus = board->needCalibration = board->needLed = false;
+    board->needActivation = board->needDumpStart = false;
+    // Kalibrierung, mit der calc_mass() die Achsen (10 g) exakt in Gramm umrechnet
+    for (int pos = 0; pos < 4; pos++)
+        for (int point = 0; point < 3; point++) board->calibration[point][pos] = (uint16_t)(point * EVDEV_UNIT_CALIBRATION);
+    precompute_mass_coefficients(board);
+    board->calibrated = true;
+    board->persist_calibration = false;
+    evdev_sync(board);
+}
+
+// Ein Rahmen als 0x32-Report: keine Tasten, die Achsen als Sensorwerte (Big Endian)
+static void evdev_fill_report(ReportSlot* slot, const EvdevFrame* frame) {
+    memset(slot->data, 0, 4);
+    slot->data[0] = 0xa1;
+    slot->data[1] = 0x32;
+    for (int s = 0; s < 4; s++) {
+        slot->data[4 + 2 * s] = (unsigned char)(frame->axis[s] >> 8);
+        slot->data[5 + 2 * s] = (unsigned char)frame->axis[s];
+    }
+    slot->length = 12;
+}
+
+static int evdev_receive(WiiBalanceBoard* board, ReportSlot** slots, uint32_t count, int64_t realtime_offset, bool* drained) {
+    (void)realtime_offset; // Die Ereigniszeit ist bereits CLOCK_MONOTONIC
+    size_t wanted = 2 * (size_t)count;
+    ssize_t bytes_read = read(board->receive_sock, evdev_events, wanted * sizeof(struct input_event));
+    board->stats.receive_calls++;
+    if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        *drained = true;
+        return 0;
+    }
+    if (bytes_read <= 0) {
+        // Gerät entfernt (ENODEV)
+        *drained = true;
+        if (bytes_read == 0) errno = 0;
+        return -1;
+    }
+    size_t events = (size_t)bytes_read / sizeof(struct input_event);
+    // Weniger Ereignisse als Platz: das Gerät ist leer
+    *drained = events < wanted;
+
+    EvdevFrame* frame = &board->evdev;
+    int filled = 0;
+    for (size_t i = 0; i < events; i++) {
+        const struct input_event* ev = &evdev_events[i];
+        if (ev->type == EV_ABS && !frame->dropped) {
+            for (int s = 0; s < 4; s++)
+                if (ev->code == evdev_axes[s]) frame->axis[s] = evdev_value(ev->value);
+        } else if (ev->type == EV_SYN && ev->code == SYN_DROPPED) {
+            frame->dropped = true;
+        } else if (ev->type == EV_SYN && ev->code == SYN_REPORT) {
+            // Nach verlorenen Ereignissen gilt erst wieder der abgefragte Stand
+            if (frame->dropped) evdev_sync(board);
+            // Mehr Rahmen als Slots gibt es nur nach SYN_DROPPED, die Achsen gehen in den nächsten ein
+            if ((uint32_t)filled == count) continue;
+            ReportSlot* slot = slots[filled++];
+            evdev_fill_report(slot, frame);
+            slot->received_ns = (uint64_t)ev->input_event_sec * 1000000000ull + (uint64_t)ev->input_event_usec * 1000ull;
+            board->stats.kernel_stamps++;
+        }
+    }
+    return filled;
+}
+
+// Name enthält EVDEV_BOARD_NAME und (falls verlangt) die eindeutige ID ist die MAC-Adresse
+static int evdev_find(const char* mac, char* uniq, size_t uniq_size, char* path, size_t path_size) {
+    for (int i = 0; i < EVDEV_MAX_DEVICES; i++) {
+        snprintf(path, path_size, "/dev/input/event%d", i);
+        int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) continue;
+        char name[256] = "";
+        memset(uniq, 0, uniq_size);
+        if (ioctl(fd, EVIOCGNAME(sizeof(name)), name) >= 0 && strstr(name, EVDEV_BOARD_NAME) != NULL) {
+            if (ioctl(fd, EVIOCGUNIQ(uniq_size - 1), uniq) < 0) uniq[0] = 0;
+            if (mac[0] == 0 || strcasecmp(uniq, mac) == 0) {
+                int clock = CLOCK_MONOTONIC;
+                if (ioctl(fd, EVIOCSCLOCKID, &clock) < 0) perror("Hinweis: Ereigniszeit bleibt CLOCK_REALTIME");
+                // Exklusiv wie in testing/newTry.c, sonst liest z.B. die Joystick-Schicht mit
+                if (ioctl(fd, EVIOCGRAB, 1) < 0) perror("Hinweis: kein exklusiver Zugriff auf das Gerät");
+                return fd;
+            }
+        }
+        close(fd);
+    }
+    errno = ENODEV;
+    return -1;
+}
+
+int evdev_open(WiiBalanceBoard* board) {
+    char uniq[64], path[32];
+    int fd = evdev_find(board->mac, uniq, sizeof(uniq), path, sizeof(path));
+    if (fd < 0) {
+        fprintf(stderr, "Fehler: kein evdev-Gerät für %s gefunden\n", board->mac[0] ? board->mac : "ein Balance Board");
+        return -1;
+    }
+    if (board->mac[0] == 0) {
+        // Ohne eindeutige ID steht der Gerätepfad in der Ausgabe
+        snprintf(board->mac, sizeof(board->mac), "%.18s", uniq[0] ? uniq : path);
+        for (char* p = board->mac; *p && uniq[0]; p++) *p = (char)toupper((unsigned char)*p);
+    }
+    board->receive_sock = fd;
+    board->control_sock = -1;
+    fprintf(stderr, "%s über %s\n", board->mac, path);
+    return 0;
+}
+
+static int evdev_reopen(WiiBalanceBoard* board) {
+    char uniq[64], path[32];
+    // Ein Gerätepfad statt einer MAC-Adresse passt auf das nächste gefundene Board
+    board->receive_sock = evdev_find(strncmp(board->mac, "/dev/", 5) == 0 ? "" : board->mac, uniq, sizeof(uniq), path, sizeof(path));
+    return board->receive_sock < 0 ? -1 : 0;
+}
+
+const Transport evdev_transport = {
+    .name = "evdev",
+    .send = evdev_send,
+    .receive = evdev_receive,
+    .prepare = evdev_prepare,
+    .reopen = evdev_reopen
+};
+
+const Transport* find_transport(const char* name) {
+    static const Transport* const transports[] = { &l2cap_transport, &hidraw_transport, &evdev_transport };
+    for (size_t i = 0; i < sizeof(transports) / sizeof(transports[0]); i++)
+        if (strcmp(name, transports[i]->name) == 0) return transports[i];
+    return NULL;
+}
@@ -0,0 +1,150 @@
+#ifndef YAWIIBBTRANSPORT_H
+#define YAWIIBBTRANSPORT_H
+
+/**
+ * @file YAWiiBBtransport.h
+ * @brief Transports between the driver and a board: L2CAP sockets, a hidraw or an evdev device.
+ *
+ * The event loop, the init sequence and the output path do not care how reports
+ * arrive and commands leave. Every board therefore has a `Transport` that sends its
+ * commands and receives its reports into ring slots; everything after the ring
+ * (`parse_report()`, `process_received_data()`, calibration) is the same for all of them.
+ *
+ * - `l2cap_transport`: the two L2CAP channels (control 0x11, data 0x13). Reports are
+ *   received with `recvmmsg()` into consecutive ring slots together with the kernel
+ *   receive timestamp. The board simulator (`-s`) and the replay (`-i`) use the same
+ *   transport over Unix sockets.
+ * - `hidraw_transport` (`-b hidraw`): the kernel pairs the board and runs L2CAP/HIDP;
+ *   the driver only opens `/dev/hidrawN`. The device is found by its HID name
+ *   (`HIDRAW_BOARD_NAME`) and, with a MAC address, by its unique ID (the MAC of the
+ *   board). The file descriptor is non-blocking and watched by the same epoll
+ *   instance. hidraw delivers one report per `read()` without the HIDP header, so
+ *   the transport puts the `0xa1` in front and the reports look exactly like the L2CAP
+ *   ones; commands are written without the `0x52` header. There is no kernel
+ *   timestamp, the reports are stamped with `CLOCK_MONOTONIC` after `read()`.
+ *
+ * - `evdev_transport` (`-b evdev`): the `hid-wiimote` kernel driver runs the board and
+ *   publishes the calibrated sensors as the axes `ABS_HAT0X` (TR), `ABS_HAT0Y` (BR),
+ *   `ABS_HAT1X` (TL) and `ABS_HAT1Y` (BL) of an input device in units of 10 g. One
+ *   `read()` takes up to two events per free ring slot (every frame has at least one
+ *   axis and its `SYN_REPORT`); the axes are collected in `board->evdev` and every
+ *   `SYN_REPORT` becomes one 0x32 report with the axes as sensor values, stamped with
+ *   the event time (`EVIOCSCLOCKID` switches it to `CLOCK_MONOTONIC`). The board gets
+ *   the calibration 0/1700/3400 for every sensor, so `calc_mass()` and the batch kernels
+ *   turn the values into exactly ten times as many grams and all outputs work
+ *   unchanged. After `SYN_DROPPED` the axes are read again with `EVIOCGABS`. The
+ *   device is read-only: there is no init sequence, and the buttons (power button)
+ *   belong to another input device of the board.
+ *
+ * If the `hid-wiimote` kernel driver is bound to the board, it also configures
+ * the board; with hidraw the commands of the init sequence simply repeat its settings.
+ *
+ * @code
+ * board->transport = &hidraw_transport;
+ * if (hidraw_open(board) < 0) exit(1);   // board->receive_sock is the device
+ * board->transport->send(board, status_command, sizeof(status_command));
+ * @endcode
+ */
+
+#include "YAWiiBBessentials.h"
+
+#define HIDRAW_BOARD_NAME "RVL-WBC-01"    /**< Part of the HID name of the balance board ("Nintendo RVL-WBC-01") */
+#define HIDRAW_MAX_DEVICES 64             /**< `/dev/hidraw0` to `/dev/hidraw63` are searched */
+#define EVDEV_BOARD_NAME "Balance Board"  /**< Part of the input device name ("Nintendo Wii Remote Balance Board") */
+#define EVDEV_MAX_DEVICES 64              /**< `/dev/input/event0` to `/dev/input/event63` are searched */
+#define EVDEV_UNIT_CALIBRATION 1700       /**< 17 kg in the units of the evdev axes (10 g) */
+
+/**
+ * @struct Transport
+ * @brief Functions of one way to talk to a board.
+ */
+typedef struct Transport {
+    const char* name;               /**< Name for `-b` and messages */
+
+    /**
+     * @brief Sends an output report (with the `0x52` header of the L2CAP commands).
+     * @return 0 on success, -1 on error (message printed).
+     */
+    int (*send)(WiiBalanceBoard* board, const unsigned char* command, int length);
+
+    /**
+     * @brief Receives the waiting reports of a board into ring slots.
+     *
+     * Fills `data`, `length` and `received_ns` of up to @p count slots in order and
+     * counts every system call in `stats.receive_calls`. Reports shorter than two
+     * bytes are skipped.
+     *
+     * @param board           Board whose `receive_sock` is readable.
+     * @param slots           Reserved ring slots.
+     * @param count           Number of slots.
+     * @param realtime_offset `CLOCK_REALTIME - CLOCK_MONOTONIC` to convert kernel timestamps.
+     * @param drained         Set when nothing more is waiting.
+     * @return Number of filled slots, or -1 if the connection is gone (`errno` 0 for an
+     *         orderly disconnect). Slots filled before the end are returned first, the
+     *         still readable end is then reported by the next call.
+     */
+    int (*receive)(WiiBalanceBoard* board, ReportSlot** slots, uint32_t count, int64_t realtime_offset, bool* drained);
+
+    /**
+     * @brief Prepares a freshly connected `receive_sock` for the event loop (may be `NULL`).
+     *
+     * Called after the init commands have been scheduled, so a transport without
+     * commands can cancel them.
+     */
+    void (*prepare)(WiiBalanceBoard* board);
+
+    /**
+     * @brief Reopens a lost board synchronously, `NULL` for the non-blocking two-channel
+     *        reconnect of L2CAP in `check_connections()`.
+     * @return 0 if `receive_sock` is open again, -1 otherwise.
+     */
+    int (*reopen)(WiiBalanceBoard* board);
+} Transport;
+
+extern const Transport l2cap_transport;   /**< L2CAP channels, simulator and replay sockets */
+extern const Transport hidraw_transport;  /**< `/dev/hidrawN` of a board paired by the kernel */
+extern const Transport evdev_transport;   /**< `/dev/input/eventN` of the `hid-wiimote` driver */
+
+/**
+ * @brief Looks up a transport by name (`l2cap`, `hidraw`, `evdev`).
+ *
+ * @return The transport or `NULL` for an unknown name.
+ */
+const Transport* find_transport(const char* name);
+
+/**
+ * @brief Prepares the shared `recvmmsg()` headers of the L2CAP transport.
+ *
+ * Called once by `setup_event_loop()`; only the receive thread uses them.
+ */
+void l2cap_transport_init(void);
+
+/**
+ * @brief Opens the hidraw device of a board.
+ *
+ * Searches `/dev/hidraw*` for a device whose name contains `HIDRAW_BOARD_NAME`. If
+ * `board->mac` is set, the unique ID of the device (the board's MAC address) must
+ * match it; otherwise the first board found is taken and its MAC address is copied
+ * to `board->mac`. The device is opened read/write, non-blocking and close-on-exec
+ * and becomes `receive_sock`; `control_sock` stays -1.
+ *
+ * @param board Board to open.
+ * @return 0 on success, -1 if no matching device could be opened (message printed).
+ */
+int hidraw_open(WiiBalanceBoard* board);
+
+/**
+ * @brief Opens the evdev input device of a board.
+ *
+ * Searches `/dev/input/event*` for a device whose name contains `EVDEV_BOARD_NAME`.
+ * If `board->mac` is set, the unique ID of the device must match it; otherwise the
+ * first board found is taken and its unique ID (or, if it has none, the device path)
+ * is copied to `board->mac`. The device is opened non-blocking and close-on-exec,
+ * grabbed exclusively (`EVIOCGRAB`) and switched to `CLOCK_MONOTONIC` event times.
+ *
+ * @param board Board to open.
+ * @return 0 on success, -1 if no matching device could be opened (message printed).
+ */
+int evdev_open(WiiBalanceBoard* board);
+
+#endif // YAWIIBBTRANSPORT_H
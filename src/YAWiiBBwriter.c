@@ -0,0 +1,29 @@
+#include "YAWiiBBwriter.h"
+#include <stdlib.h>
+/**
+ * @file YAWiiBBwriter.c
+ * @brief Core file for the text writer predefined in YAWiiBBwriter.h.
+ */
+
+
+int writer_init(TextWriter* writer, size_t capacity, FILE* target) {
+    writer->buffer = malloc(capacity);
+    writer->length = 0;
+    writer->capacity = capacity;
+    writer->target = target;
+    return writer->buffer == NULL ? -1 : 0;
+}
+
+void writer_flush(TextWriter* writer) {
+    if (writer->target != NULL && writer->length > 0) {
+        fwrite(writer->buffer, 1, writer->length, writer->target);
+        fflush(writer->target);
+    }
+    writer->length = 0;
+}
+
+void writer_free(TextWriter* writer) {
+    writer_flush(writer);
+    free(writer->buffer);
+    writer->buffer = NULL;
+}
@@ -0,0 +1,185 @@
+#ifndef YAWIIBBWRITER_H
+#define YAWIIBBWRITER_H
+
+/**
+ * @file YAWiiBBwriter.h
+ * @brief Buffered text writer with hand-written number formatting for `print_info()`.
+ *
+ * The text output used to call `printf()` once per byte in RAW mode and format four
+ * `%.2f` floats per report in DEBUG mode. The formatters here produce exactly the
+ * same characters (`%u`, `%i`, `%02x`, `%06llu` and `%.2f` of gram / 1000.0) with a
+ * few integer operations, and write them into a large buffer owned by one thread.
+ *
+ * A caller reserves room for a whole line once (`writer_reserve()`), formats into the
+ * returned pointer without further checks and hands the end back with
+ * `writer_commit()`. The buffer is passed on to its `FILE*` (and flushed) when it is
+ * full or when the owner calls `writer_flush()`; the output thread does that
+ * together with `fflush(stdout)` whenever the report ring runs empty, when the oldest
+ * buffered report is older than `OUTPUT_FLUSH_MS`, and before it exits. A writer
+ * without target only collects the bytes (used by the fan-out server to encode a
+ * report once for all its text subscribers).
+ *
+ * @code
+ * char* p = writer_reserve(&writer, 64);
+ * p = format_text(p, "Gewicht ");
+ * p = format_kg(p, 70250);               // "70.25"
+ * *p++ = '\n';
+ * writer_commit(&writer, p);
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define WRITER_BUFFER_SIZE (1 << 16)      /**< Buffer of the stdout writer of the output thread */
+#define WRITER_LINE_MAX 256               /**< Room reserved for one text line of a report */
+
+/**
+ * @struct TextWriter
+ * @brief Output buffer and its target.
+ */
+typedef struct {
+    char* buffer;                   /**< Formatted bytes not yet passed on */
+    size_t length;                  /**< Bytes in `buffer` */
+    size_t capacity;                /**< Size of `buffer` */
+    FILE* target;                   /**< Stream the buffer is written to, `NULL` = collect only */
+} TextWriter;
+
+/**
+ * @brief Allocates the buffer of a writer.
+ *
+ * @param writer   Writer to initialize.
+ * @param capacity Size of the buffer in bytes.
+ * @param target   Stream to write to, or `NULL` to only collect.
+ * @return 0 on success, -1 if the buffer cannot be allocated.
+ */
+int writer_init(TextWriter* writer, size_t capacity, FILE* target);
+
+/**
+ * @brief Writes the buffer to the target and flushes the target.
+ *
+ * A writer without target is simply emptied.
+ */
+void writer_flush(TextWriter* writer);
+
+/**
+ * @brief Flushes the writer and releases its buffer.
+ */
+void writer_free(TextWriter* writer);
+
+/**
+ * @brief Makes room for @p bytes and returns where to format them.
+ *
+ * The writer is flushed first if the room is not free, so @p bytes must not exceed
+ * the capacity.
+ */
+static inline char* writer_reserve(TextWriter* writer, size_t bytes) {
+    if (writer->capacity - writer->length < bytes) writer_flush(writer);
+    return writer->buffer + writer->length;
+}
+
+/**
+ * @brief Takes the bytes formatted up to @p end into the buffer.
+ */
+static inline void writer_commit(TextWriter* writer, char* end) {
+    writer->length = (size_t)(end - writer->buffer);
+}
+
+/** @brief Copies a 0-terminated string, returns the end. */
+static inline char* format_text(char* out, const char* text) {
+    size_t length = strlen(text);
+    memcpy(out, text, length);
+    return out + length;
+}
+
+/** @brief Formats like `%llu`, returns the end. */
+static inline char* format_u64(char* out, uint64_t value) {
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (count > 0) *out++ = digits[--count];
+    return out;
+}
+
+/** @brief Formats like `%u`, returns the end. */
+static inline char* format_u32(char* out, uint32_t value) {
+    return format_u64(out, value);
+}
+
+/** @brief Formats like `%0<width>llu`, returns the end. */
+static inline char* format_u64_padded(char* out, uint64_t value, int width) {
+    char* end = format_u64(out, value);
+    int length = (int)(end - out);
+    if (length >= width) return end;
+    memmove(out + width - length, out, (size_t)length);
+    memset(out, '0', (size_t)(width - length));
+    return out + width;
+}
+
+/** @brief Formats like `%02x`, returns the end. */
+static inline char* format_hex2(char* out, uint8_t value) {
+    static const char hex[] = "0123456789abcdef";
+    out[0] = hex[value >> 4];
+    out[1] = hex[value & 0x0f];
+    return out + 2;
+}
+
+/**
+ * @brief Decides the halfway cases (`x.xx5`) of `%.2f` for `grams / 1000.0`.
+ *
+ * printf rounds the double, which mostly lies a bit above or below `x.xx5`. The
+ * product of the double and 1000 is computed exactly (Dekker's two-product, no FMA
+ * needed) and compared with @p grams. If @p grams is a multiple of 125 the double is
+ * exact and printf rounds half to even.
+ *
+ * @param grams      Mass in gram, last digit 5.
+ * @param hundredths Hundredths of a kilogram before rounding.
+ * @return 1 if the hundredths are rounded up.
+ */
+static inline int kg_rounds_up(uint32_t grams, uint32_t hundredths) {
+    const double split = 134217729.0; // 2^27 + 1
+    double kg = grams / 1000.0, product = kg * 1000.0;
+    double t = split * kg, kg_high = t - (t - kg), kg_low = kg - kg_high;
+    t = split * 1000.0;
+    double k_high = t - (t - 1000.0), k_low = 1000.0 - k_high;
+    double error = ((kg_high * k_high - product) + kg_high * k_low + kg_low * k_high) + kg_low * k_low;
+    double difference = (product - grams) + error;
+    return difference > 0 || (difference == 0 && (hundredths & 1));
+}
+
+/** @brief Formats like `printf("%.2f", grams / 1000.0)`, returns the end. */
+static inline char* format_kg(char* out, uint32_t grams) {
+    uint32_t kg = grams / 1000, rest = grams % 1000;
+    uint32_t hundredths = rest / 10, digit = rest % 10;
+    if (digit > 5 || (digit == 5 && kg_rounds_up(grams, hundredths))) hundredths++;
+    if (hundredths == 100) {
+        kg++;
+        hundredths = 0;
+    }
+    out = format_u32(out, kg);
+    *out++ = '.';
+    *out++ = (char)('0' + hundredths / 10);
+    *out++ = (char)('0' + hundredths % 10);
+    return out;
+}
+
+/** @brief Formats with one decimal, halfway cases away from zero (`llround()`), returns the end. */
+static inline char* format_tenths(char* out, double value) {
+    long long tenths = llround(value * 10.0);
+    if (tenths < 0) {
+        *out++ = '-';
+        tenths = -tenths;
+    }
+    out = format_u64(out, (uint64_t)(tenths / 10));
+    *out++ = '.';
+    *out++ = (char)('0' + tenths % 10);
+    return out;
+}
+
+#endif // YAWIIBBWRITER_H
@@ -0,0 +1,274 @@
+// Prüft die Fensteraggregation (src/YAWiiBBaggregate.h) mit mehreren Fenstergrößen gegen eine direkte Statistik je
+// Größe über dieselben Werte, mit Lücken, Schließen über den Zeitgeber und beim Beenden, und misst ns pro Wert
+// gcc -Wall -O2 -I../src -o benchAggregate benchAggregate.c ../src/YAWiiBBaggregate.c -lm
+// ./benchAggregate [-n 2000000] [-W 250,1000,5000,60000]
+
+#include "YAWiiBBaggregate.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define IDLE_NS (AGGREGATE_IDLE_DELAY_MS * 1000000ull)
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Ein geschlossenes Fenster: Größe, Beginn, Anzahl und je Wert Minimum, Maximum, Mittelwert und Standardabweichung.
+ */
+typedef struct {
+    int size;
+    uint64_t start_ns;
+    uint64_t count;
+    uint32_t min[AGGREGATE_VALUES];
+    uint32_t max[AGGREGATE_VALUES];
+    double mean[AGGREGATE_VALUES];
+    double sd[AGGREGATE_VALUES];
+} Record;
+
+/**
+ * @brief Gesammelte Records, in der Reihenfolge ihrer Ausgabe.
+ */
+typedef struct {
+    Record* record;
+    size_t count, capacity;
+} Records;
+
+static Record* next_record(Records* list) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? 2 * list->capacity : 1024;
+        list->record = realloc(list->record, list->capacity * sizeof(Record));
+        if (list->record == NULL) {
+            perror("Fehler beim Anlegen der Records");
+            exit(1);
+        }
+    }
+    return &list->record[list->count++];
+}
+
+static void keep_window(Records* list, const AggregateWindow* window, int size) {
+    Record* r = next_record(list);
+    r->size = size;
+    r->start_ns = window->start_ns;
+    r->count = window->count;
+    for (int v = 0; v < AGGREGATE_VALUES; v++) {
+        r->min[v] = window->min[v];
+        r->max[v] = window->max[v];
+        r->mean[v] = window->mean[v];
+        r->sd[v] = sqrt(window->m2[v] / window->count);
+    }
+}
+
+// Alle fälligen Fenster ausgeben und schließen, wie print_due_windows() im Ausgabethread
+static void close_due(const AggregateConfig* config, AggregateState* state, uint64_t now, Records* list) {
+    int i;
+    while ((i = aggregate_due(config, state, now)) >= 0) {
+        if (list != NULL) keep_window(list, &state->window[i], i);
+        aggregate_close(config, state, i);
+    }
+}
+
+// Wie der Ausgabethread: kommt bis t kein Wert, weckt ihn der Zeitgeber IDLE_NS nach dem Ende des nächsten Fensters
+static void feed(const AggregateConfig* config, AggregateState* state, const uint32_t mass[4], uint64_t t, Records* list) {
+    uint64_t end;
+    while ((end = aggregate_next_end(config, state)) != UINT64_MAX && end + IDLE_NS <= t)
+        close_due(config, state, end + IDLE_NS, list);
+    close_due(config, state, t, list);
+    aggregate_add(config, state, mass, t);
+}
+
+// Werte mit etwa 100 Hz und Jitter, eine Person verlagert langsam ihr Gewicht; ab und zu Lücken von 0.3 bis 90 s
+static void make_samples(size_t n, uint64_t* stamps, uint32_t (*mass)[4]) {
+    uint64_t t = 5000000000ull + 123456789ull;
+    for (size_t i = 0; i < n; i++) {
+        double shift = sin(i / 700.0) * 3000.0;
+        for (int s = 0; s < 4; s++) mass[i][s] = (uint32_t)(17000.0 + (s < 2 ? shift : -shift) + rand() % 400);
+        stamps[i] = t;
+        if (rand() % 4000 == 0) t += 300000000ull + (uint64_t)(rand() % 90000) * 1000000ull;
+        else t += 10000000ull + (uint64_t)(rand() % 4000000) - 2000000ull;
+    }
+}
+
+// Referenz: für jede Größe die Werte nach Fensterbeginn gruppieren, Mittelwert und Abweichungen in zwei Durchgängen
+static void reference(const AggregateConfig* config, size_t n, const uint64_t* stamps, uint32_t (*mass)[4], Records* list) {
+    for (int size = 0; size < config->count; size++) {
+        uint64_t size_ns = config->size_ms[size] * 1000000ull;
+        for (size_t first = 0; first < n;) {
+            uint64_t start = stamps[first] - stamps[first] % size_ns;
+            size_t last = first;
+            while (last < n && stamps[last] < start + size_ns) last++;
+            Record* r = next_record(list);
+            r->size = size;
+            r->start_ns = start;
+            r->count = last - first;
+            for (int v = 0; v < AGGREGATE_VALUES; v++) {
+                long double sum = 0, squares = 0;
+                r->min[v] = UINT32_MAX;
+                r->max[v] = 0;
+                for (size_t i = first; i < last; i++) {
+                    uint32_t value = v < 4 ? mass[i][v] : mass[i][0] + mass[i][1] + mass[i][2] + mass[i][3];
+                    if (value < r->min[v]) r->min[v] = value;
+                    if (value > r->max[v]) r->max[v] = value;
+                    sum += value;
+                }
+                long double mean = sum / r->count;
+                for (size_t i = first; i < last; i++) {
+                    uint32_t value = v < 4 ? mass[i][v] : mass[i][0] + mass[i][1] + mass[i][2] + mass[i][3];
+                    squares += (value - mean) * (value - mean);
+                }
+                r->mean[v] = (double)mean;
+                r->sd[v] = (double)sqrtl(squares / r->count);
+            }
+            first = last;
+        }
+    }
+}
+
+static int by_size_and_start(const void* a, const void* b) {
+    const Record *x = a, *y = b;
+    if (x->size != y->size) return x->size - y->size;
+    return (x->start_ns > y->start_ns) - (x->start_ns < y->start_ns);
+}
+
+// Vergleicht die Records der Aggregation mit der Referenz, gibt die Zahl der Abweichungen zurück
+static int compare(const AggregateConfig* config, Records* got, const Records* want) {
+    int bad = 0;
+    // Je Größe in aufsteigender Reihenfolge ausgegeben, jeder Beginn nur einmal
+    uint64_t last_start[AGGREGATE_MAX_WINDOWS] = { 0 };
+    bool seen[AGGREGATE_MAX_WINDOWS] = { false };
+    for (size_t i = 0; i < got->count; i++) {
+        const Record* r = &got->record[i];
+        if (seen[r->size] && r->start_ns <= last_start[r->size]) {
+            fprintf(stderr, "%u ms: Fenster %.3f nach %.3f ausgegeben\n", config->size_ms[r->size], r->start_ns / 1e9,
+                    last_start[r->size] / 1e9);
+            bad++;
+        }
+        last_start[r->size] = r->start_ns;
+        seen[r->size] = true;
+    }
+    if (got->count != want->count) {
+        fprintf(stderr, "%zu Records statt %zu\n", got->count, want->count);
+        return bad + 1;
+    }
+    qsort(got->record, got->count, sizeof(Record), by_size_and_start);
+    double worst = 0;
+    for (size_t i = 0; i < got->count; i++) {
+        const Record *g = &got->record[i], *w = &want->record[i];
+        if (g->size != w->size || g->start_ns != w->start_ns || g->count != w->count) {
+            fprintf(stderr, "%u ms %.3f: %llu Werte statt %u ms %.3f: %llu Werte\n", config->size_ms[g->size], g->start_ns / 1e9,
+                    (unsigned long long)g->count, config->size_ms[w->size], w->start_ns / 1e9, (unsigned long long)w->count);
+            if (++bad > 10) return bad;
+            continue;
+        }
+        for (int v = 0; v < AGGREGATE_VALUES; v++) {
+            double d_mean = fabs(g->mean[v] - w->mean[v]) / w->mean[v];
+            double d_sd = fabs(g->sd[v] - w->sd[v]) / w->mean[v];
+            worst = fmax(worst, fmax(d_mean, d_sd));
+            if (g->min[v] != w->min[v] || g->max[v] != w->max[v] || d_mean > 1e-12 || d_sd > 1e-12) {
+                fprintf(stderr, "%u ms %.3f Wert %d: %u %.6f %u %.6f statt %u %.6f %u %.6f\n", config->size_ms[g->size],
+                        g->start_ns / 1e9, v, g->min[v], g->mean[v], g->max[v], g->sd[v], w->min[v], w->mean[v], w->max[v], w->sd[v]);
+                if (++bad > 10) return bad;
+            }
+        }
+    }
+    printf("%zu Records wie die direkte Statistik, größte Abweichung von Mittelwert/SD %.1e relativ zum Mittelwert\n", got->count, worst);
+    return bad;
+}
+
+// Ein Wert kommt nach dem Schließen seines Fensters über den Zeitgeber: er zählt ins nächste und als verspätet
+static int check_late(void) {
+    AggregateConfig config;
+    if (aggregate_configure(&config, "1000,5000") != 0) return 1;
+    AggregateState state;
+    memset(&state, 0, sizeof(state));
+    Records list = { 0 };
+    uint32_t mass[4] = { 10000, 11000, 12000, 13000 };
+    int bad = 0;
+    feed(&config, &state, mass, 10500000000ull, &list);
+    close_due(&config, &state, 11000000000ull + IDLE_NS, &list);
+    feed(&config, &state, mass, 10900000000ull, &list);
+    if (state.late != 1 || state.window[0].start_ns != 11000000000ull) {
+        fprintf(stderr, "Verspäteter Wert: %llu verspätet, Fenster ab %.3f statt 1 und 11.000\n", (unsigned long long)state.late,
+                state.window[0].start_ns / 1e9);
+        bad++;
+    }
+    close_due(&config, &state, UINT64_MAX, &list);
+    // 1000 ms ab 10 s, 1000 ms ab 11 s, 5000 ms ab 10 s mit beiden Werten
+    if (list.count != 3 || list.record[1].start_ns != 11000000000ull || list.record[2].count != 2) {
+        fprintf(stderr, "Verspäteter Wert: %zu Records statt 3\n", list.count);
+        bad++;
+    }
+    printf("Verspäteter Wert: %s\n", bad ? "falsch" : "ins nächste Fenster gezählt");
+    free(list.record);
+    return bad;
+}
+
+// Zeit pro Wert mit allen Abschlüssen, ohne die Records zu sammeln
+static double time_per_sample(const char* spec, size_t n, const uint64_t* stamps, uint32_t (*mass)[4]) {
+    AggregateConfig config;
+    if (aggregate_configure(&config, spec) != 0) exit(1);
+    AggregateState state;
+    memset(&state, 0, sizeof(state));
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < n; i++) feed(&config, &state, mass[i], stamps[i], NULL);
+    close_due(&config, &state, UINT64_MAX, NULL);
+    double ns = (double)(now_ns() - start) / n;
+    printf("-W %-24s %6.1f ns pro Wert, %llu Records\n", spec, ns, (unsigned long long)state.records);
+    return ns;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = 2000000;
+    const char* spec = "250,1000,5000,60000";
+    int opt;
+    while ((opt = getopt(argc, argv, "n:W:")) != -1) {
+        if (opt == 'n') n = strtoull(optarg, NULL, 10);
+        else if (opt == 'W') spec = optarg;
+        else {
+            fprintf(stderr, "Aufruf: %s [-n Werte] [-W Fenstergrößen in ms]\n", argv[0]);
+            return 1;
+        }
+    }
+    AggregateConfig config;
+    if (n < 1000 || aggregate_configure(&config, spec) != 0) {
+        fprintf(stderr, "Mindestens 1000 Werte und gültige Fenstergrößen\n");
+        return 1;
+    }
+    srand(1);
+    uint64_t* stamps = malloc(n * sizeof(*stamps));
+    uint32_t (*mass)[4] = malloc(n * sizeof(*mass));
+    if (stamps == NULL || mass == NULL) {
+        perror("Fehler beim Anlegen der Werte");
+        return 1;
+    }
+    make_samples(n, stamps, mass);
+    printf("%zu Werte über %.0f s\n", n, (stamps[n - 1] - stamps[0]) / 1e9);
+
+    // Aggregation wie im Ausgabethread, offene Fenster beim Beenden
+    AggregateState state;
+    memset(&state, 0, sizeof(state));
+    Records got = { 0 }, want = { 0 };
+    for (size_t i = 0; i < n; i++) feed(&config, &state, mass[i], stamps[i], &got);
+    close_due(&config, &state, UINT64_MAX, &got);
+    int bad = state.late != 0 || state.samples != n || state.records != got.count;
+    if (bad) fprintf(stderr, "Zähler: %llu Werte, %llu Records, %llu verspätet\n", (unsigned long long)state.samples,
+                     (unsigned long long)state.records, (unsigned long long)state.late);
+    reference(&config, n, stamps, mass, &want);
+    bad += compare(&config, &got, &want);
+    bad += check_late();
+
+    time_per_sample("1000", n, stamps, mass);
+    time_per_sample(spec, n, stamps, mass);
+
+    free(got.record);
+    free(want.record);
+    free(stamps);
+    free(mass);
+    printf("Abweichungen: %d\n", bad);
+    return bad == 0 ? 0 : 1;
+}
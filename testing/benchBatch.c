@@ -0,0 +1,138 @@
+// Prüft die Batch-Kernel aus YAWiiBBbatch.c (AVX2, SSE4.1, skalar) gegen calc_mass() und misst sie gegen
+// den Weg pro Report (Bytes einzeln lesen, calc_mass() je Sensor)
+// gcc -Wall -O2 -I../src -o benchBatch benchBatch.c $(ls ../src/YAWiiBB*.c | grep -v "YAWiiBBD.c\|YAWiiBBbatch.c") -lbluetooth -lpthread -lm
+// ./benchBatch [-t 500] [-n 1003] [-r 200]
+
+// Die Kernel sind static, daher wird die Datei direkt eingebunden
+#include "../src/YAWiiBBbatch.c"
+
+// Globale Variablen, die sonst YAWiiBBD.c definiert
+LogLevel debug_level = RAW;
+OutputFormat output_format = OUTPUT_TEXT;
+ShmRing shm_output;
+bool text_timestamps = false;
+
+typedef struct {
+    const char* name;
+    decode_kernel decode;
+    mass_kernel mass;
+    bool supported;
+} Kernel;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void random_calibration(WiiBalanceBoard* board) {
+    for (int pos = 0; pos < 4; pos++) {
+        int kg0 = rand() % 20000, span1 = 1 + rand() % 4000, span2 = 1 + rand() % 4000;
+        board->calibration[0][pos] = (uint16_t)kg0;
+        board->calibration[1][pos] = (uint16_t)(kg0 + span1);
+        board->calibration[2][pos] = (uint16_t)(kg0 + span1 + span2);
+    }
+    precompute_mass_coefficients(board);
+}
+
+// Reports im Abstand eines Ring-Slots wie im Ausgabethread, Sensorwerte zufällig über den ganzen 16-Bit-Bereich
+static void random_reports(unsigned char* reports, size_t stride, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        unsigned char* r = reports + i * stride;
+        r[0] = 0xa1;
+        r[1] = 0x32;
+        for (int k = 2; k < 22; k++) r[k] = (unsigned char)rand();
+    }
+}
+
+static void run_kernel(const Kernel* kernel, const WiiBalanceBoard* board, const unsigned char* reports, size_t stride, size_t n, SampleBlock* block) {
+    kernel->decode(reports, stride, n, block);
+    block->count = n;
+    for (int s = 0; s < 4; s++) kernel->mass(&board->coefficients, s, block->raw[s], block->mass[s], n);
+}
+
+int main(int argc, char* argv[]) {
+    int tables = 500, repeats = 200, opt;
+    size_t n = 1003;
+    while ((opt = getopt(argc, argv, "t:n:r:")) != -1) {
+        if (opt == 't') tables = atoi(optarg);
+        else if (opt == 'n') n = (size_t)atol(optarg);
+        else if (opt == 'r') repeats = atoi(optarg);
+        else {
+            fprintf(stderr, "Aufruf: %s [-t Kalibriertabellen] [-n Reports] [-r Durchläufe]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (tables < 1 || n < 1 || repeats < 1) {
+        fprintf(stderr, "Tabellen, Reports und Durchläufe müssen positiv sein\n");
+        return 1;
+    }
+
+    Kernel kernels[] = {
+        { "skalar", decode_scalar, mass_scalar, true },
+#ifdef YAWIIBB_X86
+        { "sse4.1", decode_sse41, mass_sse41, __builtin_cpu_supports("sse4.1") },
+        { "avx2", decode_avx2, mass_avx2, __builtin_cpu_supports("avx2") },
+#endif
+    };
+    const int kernel_count = sizeof(kernels) / sizeof(kernels[0]);
+
+    const size_t stride = sizeof(ReportSlot);
+    unsigned char* reports = malloc(n * stride);
+    SampleBlock block;
+    if (reports == NULL || sample_block_init(&block, n) != 0) {
+        perror("Fehler beim Anlegen der Reports");
+        return 1;
+    }
+    printf("Zur Laufzeit gewählt: %s\n", batch_kernel_name());
+
+    // Jeder Kernel gegen report_be16() und calc_mass() für jede Probe
+    WiiBalanceBoard board = { 0 };
+    srand(3);
+    uint64_t bad = 0;
+    for (int t = 0; t < tables; t++) {
+        random_calibration(&board);
+        random_reports(reports, stride, n);
+        for (int k = 0; k < kernel_count; k++) {
+            if (!kernels[k].supported) continue;
+            memset(block.raw[0], 0, n * sizeof(uint16_t));
+            run_kernel(&kernels[k], &board, reports, stride, n, &block);
+            for (size_t i = 0; i < n; i++) {
+                for (int s = 0; s < 4; s++) {
+                    uint16_t raw = report_be16(reports + i * stride + 4 + 2 * s);
+                    if ((block.raw[s][i] != raw || block.mass[s][i] != calc_mass(&board, raw, s)) && bad++ < 10)
+                        fprintf(stderr, "%s Tabelle %d Report %zu Sensor %d: %u/%u statt %u/%u\n", kernels[k].name, t, i, s,
+                                block.raw[s][i], block.mass[s][i], raw, calc_mass(&board, raw, s));
+                }
+            }
+        }
+    }
+    printf("Exaktheit: %d Tabellen x %zu Reports, %llu Abweichungen\n", tables, n, (unsigned long long)bad);
+
+    // Laufzeit mit der letzten Tabelle, kürzeste Zeit aus allen Durchläufen
+    uint64_t sum = 0, best = UINT64_MAX;
+    for (int r = 0; r < repeats; r++) {
+        uint64_t start = now_ns();
+        for (size_t i = 0; i < n; i++)
+            for (int s = 0; s < 4; s++) sum += calc_mass(&board, report_be16(reports + i * stride + 4 + 2 * s), s);
+        uint64_t elapsed = now_ns() - start;
+        if (elapsed < best) best = elapsed;
+    }
+    printf("pro Report:     %6.2f ns/Report (Prüfsumme %llu)\n", (double)best / n, (unsigned long long)sum);
+    for (int k = 0; k < kernel_count; k++) {
+        if (!kernels[k].supported) continue;
+        sum = 0;
+        best = UINT64_MAX;
+        for (int r = 0; r < repeats; r++) {
+            uint64_t start = now_ns();
+            run_kernel(&kernels[k], &board, reports, stride, n, &block);
+            uint64_t elapsed = now_ns() - start;
+            if (elapsed < best) best = elapsed;
+            sum += block.mass[r % 4][(size_t)r % n];
+        }
+        printf("Batch %-8s  %6.2f ns/Report (Prüfsumme %llu)\n", kernels[k].name, (double)best / n, (unsigned long long)sum);
+    }
+    sample_block_free(&block);
+    free(reports);
+    return bad == 0 ? 0 : 1;
+}
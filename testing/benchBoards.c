@@ -0,0 +1,149 @@
+// Skalierungstest des Daemon-Modus: erzeugt für 1, 2, 4, ... Boards eine Aufzeichnung und spielt sie
+// mit "YAWiiBBD -i -f" ab, jedes Board hängt dabei an einem Socketpair statt an seinen L2CAP-Kanälen
+// gcc -Wall -O2 -o benchBoards benchBoards.c
+// ./benchBoards [-d ../src/YAWiiBBD] [-n 64] [-r 20000] [-s 262144]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+static void put_le(FILE* file, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) fputc((int)((value >> (8 * i)) & 0xff), file);
+}
+
+static void put_record(FILE* file, uint64_t timestamp, int board, const unsigned char* data, int length) {
+    put_le(file, timestamp, 8);
+    put_le(file, (uint64_t)board, 2);
+    fputc(length, file);
+    fwrite(data, 1, (size_t)length, file);
+}
+
+// Kalibrierung (zwei 0x21-Antworten) und danach reihum je Board ein 0x32-Report, Abstand wie bei 100 Hz
+static int write_capture(const char* path, int boards, int reports) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) return -1;
+    fwrite("YWBC", 1, 4, file);
+    put_le(file, 1, 2);
+    put_le(file, (uint64_t)boards, 2);
+    for (int b = 0; b < boards; b++) {
+        char mac[18] = { 0 };
+        snprintf(mac, sizeof(mac), "02:00:00:00:%02X:%02X", b >> 8, b & 0xff);
+        fwrite(mac, 1, sizeof(mac), file);
+    }
+
+    uint64_t timestamp = 1000000000ull;
+    static const unsigned char calibration0[23] = { 0xa1, 0x21, 0x00, 0x00, 0xf0, 0x00, 0x24,
+        0x04, 0x00, 0x04, 0x10, 0x04, 0x20, 0x04, 0x30, 0x0a, 0x00, 0x0a, 0x10, 0x0a, 0x20, 0x0a, 0x30 };
+    static const unsigned char calibration1[23] = { 0xa1, 0x21, 0x00, 0x00, 0xf0, 0x00, 0x34,
+        0x10, 0x00, 0x10, 0x10, 0x10, 0x20, 0x10, 0x30 };
+    for (int b = 0; b < boards; b++) {
+        put_record(file, timestamp, b, calibration0, sizeof(calibration0));
+        put_record(file, timestamp, b, calibration1, sizeof(calibration1));
+    }
+    unsigned char data[22] = { 0xa1, 0x32 };
+    for (int i = 0; i < reports; i++) {
+        timestamp += 10000000ull / (uint64_t)boards;
+        int value = 0x0500 + (i / boards) % 0x0800;
+        for (int s = 0; s < 4; s++) {
+            data[4 + 2 * s] = (unsigned char)(value >> 8);
+            data[5 + 2 * s] = (unsigned char)value;
+        }
+        put_record(file, timestamp, i % boards, data, sizeof(data));
+    }
+    return fclose(file);
+}
+
+// Startet den Treiber mit der Aufzeichnung, liest die Replay-Zeile von stderr und die CPU-Zeit des Kindes
+static int run_replay(const char* driver, const char* path, const char* slots, double* rate, unsigned long long* processed, double* cpu_s) {
+    int pipe_fds[2];
+    if (pipe(pipe_fds) < 0) return -1;
+    struct rusage before, after;
+    getrusage(RUSAGE_CHILDREN, &before);
+    pid_t pid = fork();
+    if (pid == 0) {
+        // stdin aus /dev/null: der Eingabethread endet sofort (ein geschlossenes fd 0 bekäme der erste Socket)
+        int null_fd = open("/dev/null", O_RDWR);
+        dup2(null_fd, STDIN_FILENO);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(pipe_fds[1], STDERR_FILENO);
+        close(pipe_fds[0]);
+        execl(driver, driver, "-o", "binary", "-r", slots, "-i", path, "-f", (char*)NULL);
+        perror("Fehler beim Starten des Treibers");
+        _exit(127);
+    }
+    close(pipe_fds[1]);
+
+    FILE* output = fdopen(pipe_fds[0], "r");
+    char line[512];
+    int found = 0;
+    while (fgets(line, sizeof(line), output) != NULL) {
+        unsigned long long sent;
+        double seconds;
+        if (sscanf(line, "Replay: %llu Reports gesendet, %llu verarbeitet in %lf s = %lf", &sent, processed, &seconds, rate) == 4) found = 1;
+    }
+    fclose(output);
+    int status;
+    waitpid(pid, &status, 0);
+    getrusage(RUSAGE_CHILDREN, &after);
+    *cpu_s = (after.ru_utime.tv_sec - before.ru_utime.tv_sec) + (after.ru_stime.tv_sec - before.ru_stime.tv_sec)
+           + ((after.ru_utime.tv_usec - before.ru_utime.tv_usec) + (after.ru_stime.tv_usec - before.ru_stime.tv_usec)) / 1e6;
+    return found && WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+int main(int argc, char* argv[]) {
+    const char* driver = "../src/YAWiiBBD";
+    const char* slots = "262144";
+    int max_boards = 64, per_board = 20000, opt;
+    while ((opt = getopt(argc, argv, "d:n:r:s:")) != -1) {
+        if (opt == 'd') driver = optarg;
+        else if (opt == 'n') max_boards = atoi(optarg);
+        else if (opt == 'r') per_board = atoi(optarg);
+        else if (opt == 's') slots = optarg;
+        else {
+            fprintf(stderr, "Aufruf: %s [-d Treiber] [-n max. Boards] [-r Reports pro Board] [-s Ring-Slots]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (max_boards < 1 || max_boards > 65535 || per_board < 1) {
+        fprintf(stderr, "Ungültige Anzahl Boards oder Reports\n");
+        return 1;
+    }
+
+    char path[] = "/tmp/benchBoardsXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("Fehler beim Anlegen der Aufzeichnung");
+        return 1;
+    }
+    close(fd);
+
+    printf("Boards  Reports  verarbeitet  Reports/s  CPU ns/Report  Effizienz\n");
+    double base = 0;
+    for (int boards = 1; boards <= max_boards; boards *= 2) {
+        double rate, cpu_s;
+        unsigned long long processed;
+        if (write_capture(path, boards, boards * per_board) != 0 ||
+            run_replay(driver, path, slots, &rate, &processed, &cpu_s) != 0) {
+            fprintf(stderr, "Lauf mit %d Boards fehlgeschlagen\n", boards);
+            unlink(path);
+            return 1;
+        }
+        // Jeder gesendete Report (inklusive der zwei Kalibrier-Antworten je Board) muss ausgegeben worden sein
+        if (processed != (unsigned long long)boards * (per_board + 2))
+            fprintf(stderr, "Warnung: %d Boards, %llu von %d Reports verarbeitet\n", boards, processed, boards * (per_board + 2));
+        // CPU-Zeit pro Report; bei linearer Skalierung bleibt sie konstant (Effizienz 100 %)
+        double ns_per_report = processed ? cpu_s * 1e9 / processed : 0;
+        if (boards == 1) base = ns_per_report;
+        printf("%6d  %7d  %11llu  %9.0f  %13.0f  %8.0f %%\n", boards, boards * per_board, processed, rate,
+               ns_per_report, ns_per_report > 0 ? 100.0 * base / ns_per_report : 0);
+        fflush(stdout);
+    }
+    unlink(path);
+    return 0;
+}
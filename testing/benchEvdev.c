@@ -0,0 +1,178 @@
+// Misst den evdev-Transport (ganze Rahmen bis SYN_REPORT, viele Ereignisse pro read()) gegen das Lesen
+// wie in newTry.c (ein read() pro Ereignis, eine Ausgabe pro Achse) an einem virtuellen uinput-Board
+// gcc -Wall -O2 -I../src -o benchEvdev benchEvdev.c $(ls ../src/YAWiiBB*.c | grep -v YAWiiBBD.c) -lbluetooth -lpthread -lm
+// sudo ./benchEvdev [-n 200000] [-k 8]      # -p: Pipe statt uinput, ohne Rechte und ohne Eingabeschicht des Kernels
+
+#define _GNU_SOURCE // pipe2()
+#include "YAWiiBBtransport.h"
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+
+// Globale Variablen, die sonst YAWiiBBD.c definiert
+LogLevel debug_level = RAW;
+OutputFormat output_format = OUTPUT_TEXT;
+ShmRing shm_output;
+bool text_timestamps = false;
+
+static const uint16_t axes[4] = { ABS_HAT0X, ABS_HAT0Y, ABS_HAT1X, ABS_HAT1Y };
+
+// Virtuelles Board mit den Achsen des hid-wiimote-Treibers, der Name enthält EVDEV_BOARD_NAME
+static int create_uinput(void) {
+    int fd = open("/dev/uinput", O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct uinput_setup setup = { .id = { .bustype = BUS_VIRTUAL, .vendor = 0x057e, .product = 0x0306 } };
+    snprintf(setup.name, sizeof(setup.name), "benchEvdev %s", EVDEV_BOARD_NAME);
+    if (ioctl(fd, UI_SET_EVBIT, EV_ABS) < 0 || ioctl(fd, UI_DEV_SETUP, &setup) < 0) {
+        close(fd);
+        return -1;
+    }
+    for (int s = 0; s < 4; s++) {
+        struct uinput_abs_setup abs = { .code = axes[s], .absinfo = { .minimum = 0, .maximum = 65535 } };
+        if (ioctl(fd, UI_SET_ABSBIT, axes[s]) < 0 || ioctl(fd, UI_ABS_SETUP, &abs) < 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    if (ioctl(fd, UI_DEV_CREATE) < 0) {
+        close(fd);
+        return -1;
+    }
+    usleep(300000); // udev legt /dev/input/eventN an
+    return fd;
+}
+
+// Rahmen i: jede Achse ändert sich, sonst unterdrückt die Eingabeschicht Ereignis und SYN_REPORT
+static uint16_t frame_value(uint64_t frame, int s) {
+    return (uint16_t)(1000 + s * 500 + frame % 4000);
+}
+
+static size_t make_events(struct input_event* events, uint64_t first, int frames) {
+    size_t n = 0;
+    for (int f = 0; f < frames; f++) {
+        for (int s = 0; s < 4; s++)
+            events[n++] = (struct input_event){ .type = EV_ABS, .code = axes[s], .value = frame_value(first + (uint64_t)f, s) };
+        events[n++] = (struct input_event){ .type = EV_SYN, .code = SYN_REPORT };
+    }
+    return n;
+}
+
+// Wie newTry.c: ein Ereignis pro read(), nach jeder Achse eine Zeile
+static uint64_t read_per_event(int fd, FILE* out, uint64_t* calls) {
+    struct input_event ev;
+    int value[4] = { 0 };
+    uint64_t frames = 0;
+    for (;;) {
+        ssize_t bytes = read(fd, &ev, sizeof(ev));
+        (*calls)++;
+        if (bytes < (ssize_t)sizeof(ev)) break;
+        if (ev.type == EV_ABS) {
+            for (int s = 0; s < 4; s++) if (ev.code == axes[s]) value[s] = ev.value;
+            fprintf(out, "%-10d %-10d %-10d %-10d\r", value[0], value[1], value[2], value[3]);
+        } else if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
+            frames++;
+        }
+    }
+    return frames;
+}
+
+// Transport des Treibers: ganze Rahmen in Ring-Slots, eine Zeile mit den Massen pro Rahmen
+static uint64_t read_frames(WiiBalanceBoard* board, ReportSlot** slots, FILE* out, uint64_t first, uint64_t* bad) {
+    uint64_t frames = 0;
+    bool drained = false;
+    while (!drained) {
+        int filled = evdev_transport.receive(board, slots, RECEIVE_BATCH, 0, &drained);
+        if (filled < 0) break;
+        for (int i = 0; i < filled; i++, frames++) {
+            uint32_t mass[4];
+            for (int s = 0; s < 4; s++) {
+                uint16_t raw = report_be16(slots[i]->data + 4 + 2 * s);
+                if (raw != frame_value(first + frames, s) && (*bad)++ < 10)
+                    fprintf(stderr, "Rahmen %llu Achse %d: %u statt %u\n", (unsigned long long)(first + frames), s, raw, frame_value(first + frames, s));
+                mass[s] = calc_mass(board, raw, s);
+            }
+            fprintf(out, "%u %u %u %u\n", mass[0], mass[1], mass[2], mass[3]);
+        }
+    }
+    return frames;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t total = 200000;
+    int chunk = 8, opt;
+    bool use_pipe = false;
+    while ((opt = getopt(argc, argv, "n:k:p")) != -1) {
+        if (opt == 'n') total = strtoull(optarg, NULL, 10);
+        else if (opt == 'k') chunk = atoi(optarg);
+        else if (opt == 'p') use_pipe = true;
+        else {
+            fprintf(stderr, "Aufruf: %s [-n Rahmen] [-k Rahmen pro Schreibvorgang] [-p]\n", argv[0]);
+            return 1;
+        }
+    }
+    // Der Puffer eines evdev-Lesers fasst nur einige Dutzend Ereignisse, größere Schübe enden in SYN_DROPPED
+    if (total < 1 || chunk < 1 || chunk > RECEIVE_BATCH) {
+        fprintf(stderr, "Rahmen positiv, 1 bis %d Rahmen pro Schreibvorgang\n", RECEIVE_BATCH);
+        return 1;
+    }
+
+    WiiBalanceBoard board = { .control_sock = -1, .receive_sock = -1, .transport = &evdev_transport };
+    int writer = -1;
+    if (use_pipe) {
+        int fds[2];
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+            perror("Fehler beim Anlegen der Pipe");
+            return 1;
+        }
+        board.receive_sock = fds[0];
+        writer = fds[1];
+        strcpy(board.mac, "pipe");
+    } else {
+        writer = create_uinput();
+        if (writer < 0) {
+            perror("Fehler beim Anlegen des uinput-Geräts (Rechte? sonst -p)");
+            return 1;
+        }
+        if (evdev_open(&board) != 0) return 1;
+    }
+    evdev_transport.prepare(&board);
+
+    static ReportSlot slot_storage[RECEIVE_BATCH];
+    ReportSlot* slots[RECEIVE_BATCH];
+    for (int i = 0; i < RECEIVE_BATCH; i++) slots[i] = &slot_storage[i];
+    FILE* out = fopen("/dev/null", "w");
+    static struct input_event events[RECEIVE_BATCH * 5];
+
+    // Beide Leser abwechselnd mit denselben Schüben, gemessen wird nur die CPU-Zeit des Lesens
+    uint64_t frames[2] = { 0 }, calls[2] = { 0 }, cpu[2] = { 0 }, bad = 0;
+    for (uint64_t first = 0; first < total; first += (uint64_t)chunk) {
+        int n = total - first < (uint64_t)chunk ? (int)(total - first) : chunk;
+        for (int reader = 0; reader < 2; reader++) {
+            size_t count = make_events(events, first, n);
+            if (write(writer, events, count * sizeof(struct input_event)) < 0) {
+                perror("Fehler beim Schreiben der Ereignisse");
+                return 1;
+            }
+            uint64_t receive_calls = board.stats.receive_calls;
+            uint64_t start = thread_cpu_ns();
+            if (reader == 0) frames[0] += read_per_event(board.receive_sock, out, &calls[0]);
+            else frames[1] += read_frames(&board, slots, out, first, &bad);
+            cpu[reader] += thread_cpu_ns() - start;
+            if (reader == 1) calls[1] += board.stats.receive_calls - receive_calls;
+        }
+    }
+
+    static const char* const names[2] = { "pro Ereignis", "Rahmen (evdev)" };
+    printf("%s, %llu Rahmen in Schüben von %d\n", use_pipe ? "Pipe" : "uinput", (unsigned long long)total, chunk);
+    for (int reader = 0; reader < 2; reader++)
+        printf("%-15s %9llu Rahmen  %6.2f read()/Rahmen  %7.0f ns CPU/Rahmen\n", names[reader], (unsigned long long)frames[reader],
+               frames[reader] ? (double)calls[reader] / frames[reader] : 0, frames[reader] ? (double)cpu[reader] / frames[reader] : 0);
+    if (frames[0] != total || frames[1] != total) fprintf(stderr, "Warnung: Rahmen verloren (SYN_DROPPED?), kleineres -k wählen\n");
+    printf("Abweichende Achsen: %llu\n", (unsigned long long)bad);
+
+    if (!use_pipe) ioctl(writer, UI_DEV_DESTROY);
+    close(writer);
+    close(board.receive_sock);
+    fclose(out);
+    return bad == 0 && frames[1] == total ? 0 : 1;
+}
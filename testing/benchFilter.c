@@ -0,0 +1,157 @@
+// Misst die Filter- und Umtaststufe (src/YAWiiBBfilter.h) in gefilterten Werten pro Sekunde und prüft sie
+// gegen eine Biquad-Kaskade in double, mit konstanter Last (Gleichverstärkung 1) und auf das Raster
+// gcc -Wall -O2 -I../src -o benchFilter benchFilter.c ../src/YAWiiBBfilter.c -lm
+// ./benchFilter [-n 2000000] [-R 100] [-j 3]
+
+#include "YAWiiBBfilter.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Etwa 100 Hz mit gleichverteiltem Jitter, jeder 500. Abstand ist eine Lücke, die die Stufe neu startet
+static void make_input(uint64_t* stamps, uint32_t (*mass)[4], size_t n, double jitter_ms) {
+    uint64_t t = 5000000000ull;
+    for (size_t i = 0; i < n; i++) {
+        double seconds = t / 1e9;
+        for (int s = 0; s < 4; s++)
+            mass[i][s] = (uint32_t)(20000 + 3000 * sin(2 * M_PI * 0.7 * seconds + s) + rand() % 400);
+        stamps[i] = t;
+        double step_ms = 10.0 + jitter_ms * (2.0 * rand() / RAND_MAX - 1.0);
+        if (i % 500 == 499) step_ms += FILTER_MAX_GAP_MS + 50;
+        t += (uint64_t)(step_ms * 1e6);
+    }
+}
+
+// Referenz: Kaskade in double auf Eingaben genau auf dem Raster, eingeschwungen ab dem ersten Wert
+static double check_reference(const char* spec, uint32_t rate) {
+    FilterConfig config;
+    FilterState state;
+    if (filter_configure(&config, spec, rate) != 0) exit(1);
+    memset(&state, 0, sizeof(state));
+    double z1[FILTER_MAX_STAGES][4], z2[FILTER_MAX_STAGES][4];
+    double worst = 0;
+    for (uint32_t k = 0; k < 20 * config.internal_rate; k++) {
+        uint64_t t = 7000000000ull + (uint64_t)(k / config.internal_rate) * 1000000000ull +
+                     (uint64_t)(k % config.internal_rate) * 1000000000ull / config.internal_rate;
+        uint32_t mass[4], filtered[4];
+        for (int s = 0; s < 4; s++) mass[s] = (uint32_t)(15000 + 5000 * sin(0.05 * k * (s + 1)) + rand() % 2000);
+        filter_push(&config, &state, mass, t);
+        for (int s = 0; s < 4; s++) {
+            double x = mass[s];
+            for (int i = 0; i < config.stages; i++) {
+                const Biquad* b = &config.biquad[i];
+                if (k == 0) {
+                    double y0 = (b->b0 + b->b1 + b->b2) / (1.0 + b->a1 + b->a2) * x;
+                    z1[i][s] = y0 - b->b0 * x;
+                    z2[i][s] = b->b2 * x - b->a2 * y0;
+                }
+                double y = b->b0 * x + z1[i][s];
+                z1[i][s] = b->b1 * x - b->a1 * y + z2[i][s];
+                z2[i][s] = b->b2 * x - b->a2 * y;
+                x = y;
+            }
+            mass[s] = x > 0 ? (uint32_t)lrint(x) : 0;
+        }
+        uint64_t sample_ns;
+        bool emitted = filter_next(&config, &state, filtered, &sample_ns);
+        if (emitted != (k % config.oversampling == 0) || (emitted && sample_ns != t)) {
+            fprintf(stderr, "Referenz: Rasterpunkt %u falsch ausgegeben\n", k);
+            return INFINITY;
+        }
+        for (int s = 0; emitted && s < 4; s++) worst = fmax(worst, fabs((double)filtered[s] - mass[s]));
+    }
+    return worst;
+}
+
+// Konstante Last bei ungleichmäßigem Eingang: jeder Wert exakt, jeder Zeitpunkt auf dem Raster
+static int check_constant(const char* spec, uint32_t rate, const uint64_t* stamps, size_t n) {
+    FilterConfig config;
+    FilterState state;
+    if (filter_configure(&config, spec, rate) != 0) exit(1);
+    memset(&state, 0, sizeof(state));
+    const uint32_t mass[4] = { 12345, 23456, 34567, 1000 };
+    uint64_t period = 1000000000ull / rate;
+    int bad = 0;
+    for (size_t i = 0; i < n; i++) {
+        filter_push(&config, &state, mass, stamps[i]);
+        uint32_t filtered[4];
+        uint64_t sample_ns;
+        while (filter_next(&config, &state, filtered, &sample_ns)) {
+            bool on_grid = 1000000000ull % rate != 0 || sample_ns % period == 0;
+            if ((memcmp(filtered, mass, sizeof(mass)) != 0 || !on_grid) && bad++ < 5)
+                fprintf(stderr, "Konstant: %llu ns: %u %u %u %u\n", (unsigned long long)sample_ns,
+                        filtered[0], filtered[1], filtered[2], filtered[3]);
+        }
+    }
+    return bad;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = 2000000;
+    uint32_t rate = 100;
+    double jitter_ms = 3.0;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:R:j:")) != -1) {
+        if (opt == 'n') n = strtoull(optarg, NULL, 10);
+        else if (opt == 'R') rate = (uint32_t)strtoul(optarg, NULL, 10);
+        else if (opt == 'j') jitter_ms = atof(optarg);
+        else {
+            fprintf(stderr, "Aufruf: %s [-n Werte] [-R Ausgaberate] [-j Jitter in ms]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (n < 1 || jitter_ms < 0 || jitter_ms >= 10) {
+        fprintf(stderr, "Werte positiv, Jitter 0 bis unter 10 ms\n");
+        return 1;
+    }
+
+    srand(1);
+    uint64_t* stamps = malloc(n * sizeof(*stamps));
+    uint32_t (*mass)[4] = malloc(n * sizeof(*mass));
+    if (stamps == NULL || mass == NULL) {
+        perror("Fehler beim Anlegen der Eingabe");
+        return 1;
+    }
+    make_input(stamps, mass, n, jitter_ms);
+
+    static const char* const specs[] = { "", "lp:8", "lp:8,notch:25", "lp:8,lp:8,notch:25,notch:35",
+                                         "lp:8,lp:8,lp:8,lp:8,notch:20,notch:25,notch:30,notch:35" };
+    printf("%zu Werte mit etwa 100 Hz (Jitter +-%.1f ms), Ausgabe %u Hz, %zu Byte Zustand pro Board\n",
+           n, jitter_ms, rate, sizeof(FilterState));
+    for (size_t c = 0; c < sizeof(specs) / sizeof(specs[0]); c++) {
+        FilterConfig config;
+        FilterState state;
+        if (filter_configure(&config, specs[c], rate) != 0) return 1;
+        memset(&state, 0, sizeof(state));
+        uint64_t outputs = 0, checksum = 0;
+        uint64_t start = now_ns();
+        for (size_t i = 0; i < n; i++) {
+            filter_push(&config, &state, mass[i], stamps[i]);
+            uint32_t filtered[4];
+            uint64_t sample_ns;
+            while (filter_next(&config, &state, filtered, &sample_ns)) {
+                outputs++;
+                checksum += filtered[0] + filtered[3];
+            }
+        }
+        double seconds = (now_ns() - start) / 1e9;
+        printf("%d Stufen %-58s %8.2f Mio. Werte/s  %8.2f Mio. gefilterte Werte/s  %5.1f ns pro Ausgabe (Summe %llu)\n",
+               config.stages, specs[c][0] ? specs[c] : "(nur umtasten)", n / seconds / 1e6, outputs / seconds / 1e6,
+               outputs ? seconds * 1e9 / outputs : 0, (unsigned long long)(checksum % 1000));
+    }
+
+    double worst = check_reference("lp:8,notch:25", rate);
+    int bad = check_constant("lp:1,lp:1,notch:10", rate, stamps, n < 200000 ? n : 200000);
+    printf("Größte Abweichung zur Referenz in double: %.0f g, abweichende Werte bei konstanter Last: %d\n", worst, bad);
+    free(stamps);
+    free(mass);
+    return worst <= 1 && bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+// Prüft calc_mass() mit den vorberechneten Festkomma-Koeffizienten gegen eine exakte Referenz und
+// misst sie gegen die frühere float-Variante (Verzweigungskette mit Division bei jedem Aufruf)
+// gcc -Wall -O2 -I../src -o benchMass benchMass.c $(ls ../src/YAWiiBB*.c | grep -v YAWiiBBD.c) -lbluetooth -lpthread -lm
+// ./benchMass [-t 2000] [-r 20]
+
+#include "YAWiiBBessentials.h"
+
+// Globale Variablen, die sonst YAWiiBBD.c definiert
+LogLevel debug_level = RAW;
+OutputFormat output_format = OUTPUT_TEXT;
+ShmRing shm_output;
+bool text_timestamps = false;
+
+// Frühere Variante, unverändert bis auf noinline (damit der Compiler sie nicht aus der Schleife hebt)
+__attribute__((noinline)) static uint16_t calc_mass_float(const WiiBalanceBoard* board, uint16_t raw, int pos) {
+    uint16_t mass;
+    if (raw < board->calibration[0][pos]) {
+        return 0;
+    } else if (raw < board->calibration[1][pos]) {
+        mass = (uint16_t)(34000 * ((float)(raw - board->calibration[0][pos]) /
+                                    (board->calibration[1][pos] - board->calibration[0][pos])));
+        return mass;
+    } else if (raw < board->calibration[2][pos]) {
+        mass = 17000 + (uint16_t)(17000 * ((float)(raw - board->calibration[1][pos]) /
+                                             (board->calibration[2][pos] - board->calibration[1][pos])));
+        return mass;
+    } else {
+        mass = 34000 + (uint16_t)(17000 * ((float)(raw - board->calibration[2][pos]) /
+                                             (board->calibration[2][pos] - board->calibration[1][pos])));
+        return mass;
+    }
+}
+
+// Referenz: floor(17000 * (raw - Anfang) / Spanne) in 64 Bit, ohne Festkomma; Spanne 0 liefert den Segmentanfang
+static uint32_t calc_mass_reference(const WiiBalanceBoard* board, uint16_t raw, int pos) {
+    int64_t kg0 = board->calibration[0][pos], kg17 = board->calibration[1][pos], kg34 = board->calibration[2][pos];
+    if (raw < kg0) return 0;
+    if (raw < kg17) return (uint32_t)(17000 * (raw - kg0) / (kg17 - kg0));
+    if (raw < kg34) return (uint32_t)(17000 + 17000 * (raw - kg17) / (kg34 - kg17));
+    if (kg34 == kg17) return 34000;
+    return (uint32_t)(34000 + 17000 * (raw - kg34) / (kg34 - kg17));
+}
+
+// Aufsteigende Kalibrierung je Sensor; die ersten Tabellen decken Randfälle ab
+static void make_table(WiiBalanceBoard* board, int table) {
+    for (int pos = 0; pos < 4; pos++) {
+        int kg0 = rand() % 20000, span1 = 1 + rand() % 4000, span2 = 1 + rand() % 4000;
+        if (table == 0) { kg0 = 0; span1 = 1; span2 = 1; }              // kleinste Spannen
+        if (table == 1) { kg0 = 0; span1 = 30000; span2 = 35535; }      // größte Spannen
+        if (table == 2) { kg0 = 65533; span1 = 1; span2 = 1; }          // Kalibrierung am oberen Rand
+        if (table == 3) { kg0 = 1000; span1 = 0; span2 = 0; }           // entartet: alle Punkte gleich
+        if (table == 4) { kg0 = 1000; span1 = 500; span2 = 0; }         // entartet: 17 kg = 34 kg
+        board->calibration[0][pos] = (uint16_t)kg0;
+        board->calibration[1][pos] = (uint16_t)(kg0 + span1);
+        board->calibration[2][pos] = (uint16_t)(kg0 + span1 + span2);
+    }
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Mehr Rohwerte, als die Sprungvorhersage der float-Variante auswendig lernen kann
+#define RAWS (1 << 20)
+
+// Kürzeste Zeit aus mehreren Durchläufen in ns pro Aufruf, beide Varianten abwechselnd
+static void measure(const char* name, const WiiBalanceBoard* board, const uint16_t* raws, int repeats) {
+    uint64_t sum_float = 0, sum_fixed = 0, best_float = UINT64_MAX, best_fixed = UINT64_MAX;
+    for (int r = 0; r < repeats; r++) {
+        uint64_t start = now_ns();
+        for (int i = 0; i < RAWS; i++) sum_float += calc_mass_float(board, raws[i], i & 3);
+        uint64_t middle = now_ns();
+        for (int i = 0; i < RAWS; i++) sum_fixed += calc_mass(board, raws[i], i & 3);
+        uint64_t end = now_ns();
+        if (middle - start < best_float) best_float = middle - start;
+        if (end - middle < best_fixed) best_fixed = end - middle;
+    }
+    printf("%-9s float %.2f ns/Aufruf, Festkomma %.2f ns/Aufruf (Prüfsummen %llu, %llu)\n", name,
+           (double)best_float / RAWS, (double)best_fixed / RAWS, (unsigned long long)sum_float, (unsigned long long)sum_fixed);
+}
+
+int main(int argc, char* argv[]) {
+    int tables = 2000, repeats = 20, opt;
+    while ((opt = getopt(argc, argv, "t:r:")) != -1) {
+        if (opt == 't') tables = atoi(optarg);
+        else if (opt == 'r') repeats = atoi(optarg);
+        else {
+            fprintf(stderr, "Aufruf: %s [-t Kalibriertabellen] [-r Durchläufe]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (tables < 5 || repeats < 1) {
+        fprintf(stderr, "Mindestens 5 Tabellen (Randfälle) und ein Durchlauf\n");
+        return 1;
+    }
+
+    // Vollständig über alle 65536 Rohwerte jedes Sensors jeder Tabelle
+    WiiBalanceBoard board = { 0 };
+    srand(1);
+    uint64_t checked = 0, bad = 0;
+    for (int t = 0; t < tables; t++) {
+        make_table(&board, t);
+        precompute_mass_coefficients(&board);
+        for (int pos = 0; pos < 4; pos++) {
+            for (uint32_t raw = 0; raw <= 0xffff; raw++) {
+                uint32_t expected = calc_mass_reference(&board, (uint16_t)raw, pos);
+                uint32_t result = calc_mass(&board, (uint16_t)raw, pos);
+                checked++;
+                if (result != expected && bad++ < 10)
+                    fprintf(stderr, "Tabelle %d Sensor %d Rohwert %u: %u statt %u\n", t, pos, raw, result, expected);
+            }
+        }
+    }
+    printf("Exaktheit: %llu Werte aus %d Tabellen geprüft, %llu Abweichungen\n",
+           (unsigned long long)checked, tables, (unsigned long long)bad);
+
+    // Laufzeit mit Rohwerten rund um den Kalibrierbereich (alle drei Segmente und unter 0 kg)
+    make_table(&board, 5);
+    precompute_mass_coefficients(&board);
+    static uint16_t raws[RAWS];
+    for (int i = 0; i < RAWS; i++) {
+        int pos = i & 3, low = board.calibration[0][pos] - 500, high = board.calibration[2][pos] + 3000;
+        if (low < 0) low = 0;
+        raws[i] = (uint16_t)(low + rand() % (high - low));
+    }
+    measure("zufällig", &board, raws, repeats);
+    // Langsame Gewichtsänderung wie beim Betreten des Boards: das Segment wechselt selten
+    for (int i = 0; i < RAWS; i++) {
+        int pos = i & 3, low = board.calibration[0][pos] - 500, high = board.calibration[2][pos] + 3000;
+        if (low < 0) low = 0;
+        raws[i] = (uint16_t)(low + (int)((uint64_t)(i / 4) * (uint64_t)(high - low) / (RAWS / 4)));
+    }
+    measure("Rampe", &board, raws, repeats);
+    return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+// Misst den Report-Parser aus YAWiiBBreport.h an einem Mitschnitt (-c) gegen die frühere
+// Auswertung (if-Kette über buffer[1], Längenprüfung in jedem bytes_to_int_big_endian())
+// gcc -Wall -O2 -o benchParser benchParser.c ../src/YAWiiBBreport.c
+// ./benchParser [-n 50] [-r 20] mitschnitt.ywbc
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "../src/YAWiiBBreport.h"
+
+typedef struct {
+    const unsigned char* data;
+    int length;
+} Report;
+
+// Andere Reports, die zwischen die Datenreports gemischt werden (unbekannt und zu kurz inklusive)
+static const unsigned char status[] = { 0xa1, 0x20, 0x00, 0x00, 0x02, 0x00, 0x00, 0xc0 };
+static const unsigned char read1[] = { 0xa1, 0x21, 0x00, 0x00, 0xf0, 0x00, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                       0x00, 0x00, 0x00, 0x10, 0x40, 0x10, 0x40, 0x10, 0x40, 0x10, 0x40 };
+static const unsigned char ack[] = { 0xa1, 0x22, 0x00, 0x00, 0x16, 0x00 };
+static const unsigned char data34[23] = { 0xa1, 0x34, 0x00, 0x00, 0x12, 0x34, 0x23, 0x45, 0x34, 0x56, 0x45, 0x67 };
+static const unsigned char data3d[23] = { 0xa1, 0x3d, 0x12, 0x34, 0x23, 0x45, 0x34, 0x56, 0x45, 0x67 };
+static const unsigned char data31[7] = { 0xa1, 0x31, 0x00, 0x08, 0x80, 0x80, 0x80 };
+static const unsigned char unknown[] = { 0xa1, 0x15, 0x00, 0x00 };
+static const unsigned char truncated[] = { 0xa1, 0x32, 0x00, 0x00, 0x12, 0x34, 0x23, 0x45 };
+static const Report mixed[] = {
+    { status, sizeof(status) }, { read1, sizeof(read1) }, { ack, sizeof(ack) }, { data34, sizeof(data34) },
+    { data3d, sizeof(data3d) }, { data31, sizeof(data31) }, { unknown, sizeof(unknown) }, { truncated, sizeof(truncated) }
+};
+
+// Bisherige Variante: jedes Feld prüft die Länge selbst
+static uint16_t bytes_to_int_big_endian(const unsigned char* buffer, size_t position, int* max) {
+    if (buffer == NULL || position + 1 >= (size_t)*max) return 0;
+    return (uint16_t)((buffer[position] << 8) | buffer[position + 1]);
+}
+
+static uint64_t extract_chain(const Report* report) {
+    const unsigned char* buffer = report->data;
+    int length = report->length;
+    uint64_t sum = 0;
+    if (length <= 1) return 0;
+    if (buffer[1] == 0x32) {
+        for (int i = 0; i < 4; i++) sum += bytes_to_int_big_endian(buffer, 4 + 2 * i, &length);
+        if (buffer[3] & 0x08) sum += 1;
+    } else if (buffer[1] == 0x21) {
+        if (length < 5) return 0;
+        sum += buffer[4] & 0x0f;
+        for (int i = 0; i < 8; i++) sum += bytes_to_int_big_endian(buffer, 7 + 2 * i, &length);
+    } else if (buffer[1] == 0x22) {
+        if (length < 6) return 0;
+        sum += buffer[4] + buffer[5];
+    } else if (buffer[1] == 0x20) {
+        if (length < 8) return 0;
+        sum += buffer[7];
+    }
+    return sum;
+}
+
+static uint64_t extract_table(const Report* report) {
+    ReportView view;
+    uint64_t sum = 0;
+    switch (parse_report(report->data, report->length, &view)) {
+        case REPORT_DATA:
+            for (int i = 0; i < 4; i++) sum += report_sensor(&view, i);
+            if (view.buttons & REPORT_BUTTON_A) sum += 1;
+            break;
+        case REPORT_INPUT:
+            if (view.buttons & REPORT_BUTTON_A) sum += 1;
+            break;
+        case REPORT_READ:
+            sum += view.read.error;
+            for (int i = 0; i < view.read.length / 2; i++) sum += report_be16(view.read.data + 2 * i);
+            break;
+        case REPORT_ACK:
+            sum += view.ack.command + view.ack.error;
+            break;
+        case REPORT_STATUS:
+            sum += view.status.battery;
+            break;
+        case REPORT_INVALID:
+            break;
+    }
+    return sum;
+}
+
+// Liest alle Reports des Mitschnitts, jeder n-te wird durch einen der gemischten ersetzt
+static Report* load_capture(const char* path, int every, size_t* count, unsigned char** storage) {
+    FILE* file = fopen(path, "rb");
+    unsigned char header[8];
+    if (file == NULL || fread(header, sizeof(header), 1, file) != 1 || memcmp(header, "YWBC", 4) != 0) {
+        fprintf(stderr, "Kein gültiger Mitschnitt: %s\n", path);
+        exit(1);
+    }
+    int boards = header[6] | (header[7] << 8);
+    fseek(file, 18L * boards, SEEK_CUR);
+
+    size_t capacity = 1 << 16;
+    *count = 0;
+    *storage = malloc(capacity * 24);
+    Report* reports = malloc(capacity * sizeof(Report));
+    unsigned char record[11];
+    while (fread(record, sizeof(record), 1, file) == 1) {
+        int length = record[10];
+        if (*count == capacity) {
+            capacity *= 2;
+            *storage = realloc(*storage, capacity * 24);
+            reports = realloc(reports, capacity * sizeof(Report));
+        }
+        unsigned char* data = *storage + *count * 24;
+        if (length > 24 || fread(data, (size_t)length, 1, file) != 1) break;
+        reports[*count].length = length;
+        (*count)++;
+    }
+    fclose(file);
+    // Zeiger erst nach dem letzten realloc setzen
+    for (size_t i = 0; i < *count; i++) {
+        if (every > 0 && i % every == (size_t)every - 1) reports[i] = mixed[(i / every) % (sizeof(mixed) / sizeof(mixed[0]))];
+        else reports[i].data = *storage + i * 24;
+    }
+    return reports;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Kürzeste Zeit aus mehreren Durchläufen in ns pro Report
+static double measure(uint64_t (*extract)(const Report*), const Report* reports, size_t count, int repeats, uint64_t* sum) {
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < repeats; r++) {
+        uint64_t start = now_ns(), total = 0;
+        for (size_t i = 0; i < count; i++) total += extract(&reports[i]);
+        uint64_t elapsed = now_ns() - start;
+        if (elapsed < best) best = elapsed;
+        *sum = total;
+    }
+    return (double)best / count;
+}
+
+int main(int argc, char* argv[]) {
+    int every = 50, repeats = 20, opt;
+    while ((opt = getopt(argc, argv, "n:r:")) != -1) {
+        if (opt == 'n') every = atoi(optarg);
+        else if (opt == 'r') repeats = atoi(optarg);
+        else break;
+    }
+    if (optind >= argc || repeats < 1) {
+        fprintf(stderr, "Aufruf: %s [-n jeder n-te gemischt, 0 = aus] [-r Durchläufe] mitschnitt.ywbc\n", argv[0]);
+        return 1;
+    }
+
+    size_t count;
+    unsigned char* storage;
+    Report* reports = load_capture(argv[optind], every, &count, &storage);
+    if (count == 0) {
+        fprintf(stderr, "Keine Reports im Mitschnitt\n");
+        return 1;
+    }
+
+    static const char* const kinds[] = { "ungültig", "Status", "Lesen", "Bestätigung", "Daten", "Eingabe" };
+    size_t per_kind[6] = { 0 };
+    for (size_t i = 0; i < count; i++) {
+        ReportView view;
+        per_kind[parse_report(reports[i].data, reports[i].length, &view)]++;
+    }
+    printf("%zu Reports:", count);
+    for (int k = 0; k < 6; k++) printf("%s %s %zu", k ? "," : "", kinds[k], per_kind[k]);
+    printf("\n");
+
+    uint64_t sum_chain, sum_table;
+    double chain = measure(extract_chain, reports, count, repeats, &sum_chain);
+    double table = measure(extract_table, reports, count, repeats, &sum_table);
+    printf("if-Kette:  %.2f ns/Report (Prüfsumme %llu)\n", chain, (unsigned long long)sum_chain);
+    printf("Tabelle:   %.2f ns/Report (Prüfsumme %llu)\n", table, (unsigned long long)sum_table);
+
+    free(reports);
+    free(storage);
+    return 0;
+}
@@ -0,0 +1,204 @@
+// Prüft die Schwankungsmaße (src/YAWiiBBsway.h) gegen eine Referenz mit zwei Durchgängen in long double und gegen
+// die bekannte Kovarianz der erzeugten Werte, und misst sway_update() in ns pro Wert
+// gcc -Wall -O2 -I../src -o benchSway benchSway.c ../src/YAWiiBBsway.c -lm
+// ./benchSway [-n 1000000] [-x 8] [-y 5] [-c 0.6]
+
+#include "YAWiiBBsway.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Standardnormalverteilt (Box-Muller)
+static double gauss(void) {
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+// Massen mit dem Druckmittelpunkt (x, y) bei gesamt Gramm, aufgeteilt als Produkt von rechts/links und vorne/hinten
+static void masses_for(double x, double y, double total, uint32_t mass[4]) {
+    double right = (x / (SHM_SENSOR_DISTANCE_X / 2.0) + 1.0) / 2.0, front = (y / (SHM_SENSOR_DISTANCE_Y / 2.0) + 1.0) / 2.0;
+    mass[0] = (uint32_t)lrint(total * right * front);           // TR
+    mass[1] = (uint32_t)lrint(total * right * (1.0 - front));   // BR
+    mass[2] = (uint32_t)lrint(total * (1.0 - right) * front);   // TL
+    mass[3] = (uint32_t)lrint(total * (1.0 - right) * (1.0 - front)); // BL
+}
+
+/**
+ * @brief Eine erzeugte Sitzung: Massen, Zeitstempel und der Druckmittelpunkt, den sway_cop() daraus berechnet.
+ */
+typedef struct {
+    size_t n;
+    uint32_t (*mass)[4];
+    uint64_t* stamps;
+    float (*cop)[2];
+    bool* valid;
+} Session;
+
+// Bivariat normalverteilter COP um (mean_x, mean_y) mit sd_x, sd_y und Korrelation rho, etwa 100 Hz mit Jitter.
+// Jeder 5000. Wert hat weniger als 1 kg (jemand steigt ab), dann ist der Weg unterbrochen.
+static void make_session(Session* s, size_t n, double mean_x, double mean_y, double sd_x, double sd_y, double rho, bool steps_off) {
+    s->n = n;
+    s->mass = malloc(n * sizeof(*s->mass));
+    s->stamps = malloc(n * sizeof(*s->stamps));
+    s->cop = malloc(n * sizeof(*s->cop));
+    s->valid = malloc(n * sizeof(*s->valid));
+    if (s->mass == NULL || s->stamps == NULL || s->cop == NULL || s->valid == NULL) {
+        perror("Fehler beim Anlegen der Sitzung");
+        exit(1);
+    }
+    uint64_t t = 3000000000ull;
+    for (size_t i = 0; i < n; i++) {
+        double a = gauss(), b = gauss();
+        double x = mean_x + sd_x * a, y = mean_y + sd_y * (rho * a + sqrt(1.0 - rho * rho) * b);
+        if (steps_off && i % 5000 == 4999) memset(s->mass[i], 0, sizeof(s->mass[i]));
+        else masses_for(x, y, 70000.0 + 500.0 * gauss(), s->mass[i]);
+        s->valid[i] = sway_cop(s->mass[i], s->cop[i]);
+        s->stamps[i] = t;
+        t += 10000000ull + (uint64_t)(rand() % 4000000) - 2000000ull;
+    }
+}
+
+static void free_session(Session* s) {
+    free(s->mass);
+    free(s->stamps);
+    free(s->cop);
+    free(s->valid);
+}
+
+// Referenz: Weg und Zeit Schritt für Schritt, Mittelwert im ersten, Varianzen und Kovarianz im zweiten Durchgang
+static void reference(const Session* s, SwayMetrics* m) {
+    long double path = 0, sum_x = 0, sum_y = 0;
+    uint64_t path_ns = 0, count = 0;
+    for (size_t i = 0; i < s->n; i++) {
+        if (!s->valid[i]) continue;
+        if (i > 0 && s->valid[i - 1]) {
+            path += hypotl((long double)s->cop[i][0] - s->cop[i - 1][0], (long double)s->cop[i][1] - s->cop[i - 1][1]);
+            path_ns += s->stamps[i] - s->stamps[i - 1];
+        }
+        sum_x += s->cop[i][0];
+        sum_y += s->cop[i][1];
+        count++;
+    }
+    long double mean_x = sum_x / count, mean_y = sum_y / count, sxx = 0, syy = 0, sxy = 0;
+    for (size_t i = 0; i < s->n; i++) {
+        if (!s->valid[i]) continue;
+        long double dx = s->cop[i][0] - mean_x, dy = s->cop[i][1] - mean_y;
+        sxx += dx * dx;
+        syy += dy * dy;
+        sxy += dx * dy;
+    }
+    long double var_x = sxx / count, var_y = syy / count, cov = sxy / count;
+    m->count = count;
+    m->duration_s = path_ns / 1e9;
+    m->path_mm = (double)path;
+    m->velocity_mm_s = (double)(path / (path_ns / 1e9L));
+    m->rms_x_mm = (double)sqrtl(var_x);
+    m->rms_y_mm = (double)sqrtl(var_y);
+    m->rms_mm = (double)sqrtl(var_x + var_y);
+    m->ellipse_mm2 = (double)(M_PI * SWAY_CHI2_95 * sqrtl(var_x * var_y - cov * cov));
+}
+
+// Relative Abweichung, bei 0 absolut
+static double deviation(double value, double expected) {
+    return expected == 0 ? fabs(value) : fabs(value - expected) / fabs(expected);
+}
+
+// Vergleicht alle Maße, gibt die Zahl der Abweichungen über tolerance aus
+static int compare(const char* name, const SwayMetrics* got, const SwayMetrics* want, double tolerance) {
+    const char* labels[] = { "Weg", "v", "RMS x", "RMS y", "RMS", "Ellipse" };
+    double g[] = { got->path_mm, got->velocity_mm_s, got->rms_x_mm, got->rms_y_mm, got->rms_mm, got->ellipse_mm2 };
+    double w[] = { want->path_mm, want->velocity_mm_s, want->rms_x_mm, want->rms_y_mm, want->rms_mm, want->ellipse_mm2 };
+    int bad = got->count != want->count;
+    double worst = 0;
+    for (int i = 0; i < 6; i++) {
+        double d = deviation(g[i], w[i]);
+        worst = fmax(worst, d);
+        if (d > tolerance) {
+            fprintf(stderr, "%s: %s %.9g statt %.9g\n", name, labels[i], g[i], w[i]);
+            bad++;
+        }
+    }
+    printf("%-36s Weg %10.1f mm  RMS %6.3f %6.3f %6.3f mm  Ellipse %9.2f mm²  größte rel. Abweichung %.1e\n",
+           name, got->path_mm, got->rms_x_mm, got->rms_y_mm, got->rms_mm, got->ellipse_mm2, worst);
+    return bad;
+}
+
+static void run_module(const Session* s, SwayMetrics* m) {
+    SwayStats stats;
+    memset(&stats, 0, sizeof(stats));
+    for (size_t i = 0; i < s->n; i++) sway_update(&stats, s->mass[i], s->stamps[i]);
+    sway_metrics(&stats, m);
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = 1000000;
+    double sd_x = 8.0, sd_y = 5.0, rho = 0.6;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:x:y:c:")) != -1) {
+        if (opt == 'n') n = strtoull(optarg, NULL, 10);
+        else if (opt == 'x') sd_x = atof(optarg);
+        else if (opt == 'y') sd_y = atof(optarg);
+        else if (opt == 'c') rho = atof(optarg);
+        else {
+            fprintf(stderr, "Aufruf: %s [-n Werte] [-x sd_x in mm] [-y sd_y in mm] [-c Korrelation]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (n < 10000 || sd_x <= 0 || sd_y <= 0 || !(rho > -1 && rho < 1)) {
+        fprintf(stderr, "Mindestens 10000 Werte, Standardabweichungen positiv, Korrelation zwischen -1 und 1\n");
+        return 1;
+    }
+    srand(1);
+    int bad = 0;
+    SwayMetrics got, want;
+
+    // 1. Gegen die Referenz mit zwei Durchgängen, mit Unterbrechungen des Wegs
+    Session s;
+    make_session(&s, n, 12.0, -30.0, sd_x, sd_y, rho, true);
+    run_module(&s, &got);
+    reference(&s, &want);
+    bad += compare("Zwei Durchgänge, mit Absteigen", &got, &want, 1e-9);
+
+    // 2. Gegen die bekannte Kovarianz (ohne Absteigen, die Stichprobe streut um etwa 1/sqrt(n))
+    Session k;
+    make_session(&k, n, 0.0, 0.0, sd_x, sd_y, rho, false);
+    run_module(&k, &got);
+    SwayMetrics known = got;
+    known.rms_x_mm = sd_x;
+    known.rms_y_mm = sd_y;
+    known.rms_mm = sqrt(sd_x * sd_x + sd_y * sd_y);
+    known.ellipse_mm2 = M_PI * SWAY_CHI2_95 * sd_x * sd_y * sqrt(1.0 - rho * rho);
+    // Die Massen sind auf Gramm gerundet, das verschiebt den COP um bis zu etwa 0.01 mm
+    bad += compare("Bekannte Kovarianz", &got, &known, 20.0 / sqrt((double)n) + 1e-3);
+
+    // 3. Lange Sitzung weit weg von der Mitte mit kleiner Streuung: keine Auslöschung
+    Session f;
+    make_session(&f, n, 180.0, 100.0, 0.05, 0.03, -0.3, false);
+    run_module(&f, &got);
+    reference(&f, &want);
+    bad += compare("Weit außen, 0.05/0.03 mm Streuung", &got, &want, 1e-6);
+
+    // Zeit pro Wert
+    SwayStats stats;
+    memset(&stats, 0, sizeof(stats));
+    uint64_t start = now_ns();
+    for (int r = 0; r < 5; r++)
+        for (size_t i = 0; i < s.n; i++) sway_update(&stats, s.mass[i], s.stamps[i] + (uint64_t)r * 100000000000ull);
+    double ns = (double)(now_ns() - start) / (5.0 * s.n);
+    sway_metrics(&stats, &got);
+    printf("sway_update(): %.1f ns pro Wert (Weg %.0f mm)\n", ns, got.path_mm);
+
+    free_session(&s);
+    free_session(&k);
+    free_session(&f);
+    printf("Abweichungen: %d\n", bad);
+    return bad == 0 ? 0 : 1;
+}
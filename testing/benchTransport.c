@@ -0,0 +1,160 @@
+// Misst einen Transport (-b l2cap oder -b hidraw) an einem echten Board: CPU-Zeit und Systemaufrufe pro Report im
+// Empfangspfad, Zeit vom Kernel bis zum Treiber (nur L2CAP hat einen Empfangszeitstempel) und die Antwortzeit der
+// Statusanfrage 0x15 (bis zum 0x20-Report). Für den Vergleich einmal mit hidraw (Board vom Kernel gekoppelt und
+// verbunden) und einmal mit L2CAP (Board vorher mit "bluetoothctl disconnect" vom Kernel trennen) laufen lassen.
+// gcc -Wall -O2 -I../src -o benchTransport benchTransport.c $(ls ../src/YAWiiBB*.c | grep -v YAWiiBBD.c) -lbluetooth -lpthread -lm
+// sudo ./benchTransport -b hidraw [-t 30] [-q 200] [00:23:CC:43:DC:C2]
+
+#include "YAWiiBBtransport.h"
+
+// Globale Variablen, die sonst YAWiiBBD.c definiert
+LogLevel debug_level = RAW;
+OutputFormat output_format = OUTPUT_TEXT;
+ShmRing shm_output;
+bool text_timestamps = false;
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Quantil q (0 bis 1) einer sortierten Liste in µs
+static double quantile_us(const uint64_t* sorted, size_t count, double q) {
+    return count ? sorted[(size_t)(q * (count - 1))] / 1000.0 : 0;
+}
+
+static void print_quantiles(const char* label, uint64_t* values, size_t count) {
+    qsort(values, count, sizeof(uint64_t), compare_u64);
+    printf("%-28s %7zu Werte  Median %8.1f µs  p90 %8.1f µs  p99 %8.1f µs  max %8.1f µs\n", label, count,
+           quantile_us(values, count, 0.5), quantile_us(values, count, 0.9), quantile_us(values, count, 0.99),
+           quantile_us(values, count, 1.0));
+}
+
+// Wartet höchstens timeout_ms auf Reports und empfängt sie; gibt die Zahl der Slots zurück, -1 wenn die Verbindung weg ist
+static int receive(WiiBalanceBoard* board, ReportSlot** slots, int timeout_ms, uint64_t* cpu) {
+    struct pollfd pfd = { .fd = board->receive_sock, .events = POLLIN };
+    if (poll(&pfd, 1, timeout_ms) <= 0) return 0;
+    int64_t realtime_offset = (int64_t)(realtime_ns() - monotonic_ns());
+    bool drained = false;
+    uint64_t start = thread_cpu_ns();
+    int filled = board->transport->receive(board, slots, RECEIVE_BATCH, realtime_offset, &drained);
+    *cpu += thread_cpu_ns() - start;
+    return filled;
+}
+
+int main(int argc, char* argv[]) {
+    const char* transport = "l2cap";
+    int seconds = 30, requests = 200, opt;
+    while ((opt = getopt(argc, argv, "b:t:q:")) != -1) {
+        if (opt == 'b') transport = optarg;
+        else if (opt == 't') seconds = atoi(optarg);
+        else if (opt == 'q') requests = atoi(optarg);
+        else {
+            fprintf(stderr, "Aufruf: %s [-b l2cap|hidraw] [-t Sekunden] [-q Statusanfragen] [MAC]\n", argv[0]);
+            return 1;
+        }
+    }
+    WiiBalanceBoard board = { .control_sock = -1, .receive_sock = -1, .transport = find_transport(transport) };
+    if (optind < argc) snprintf(board.mac, sizeof(board.mac), "%s", argv[optind]);
+    if (board.transport != &l2cap_transport && board.transport != &hidraw_transport) {
+        fprintf(stderr, "Fehler: nur l2cap und hidraw senden Befehle, nicht \"%s\"\n", transport);
+        return 1;
+    }
+    if (seconds < 1 || requests < 1) {
+        fprintf(stderr, "Dauer und Statusanfragen positiv\n");
+        return 1;
+    }
+
+    if (board.transport == &l2cap_transport) {
+        if (board.mac[0] == '\0') {
+            fprintf(stderr, "Fehler: L2CAP braucht die MAC-Adresse des Boards\n");
+            return 1;
+        }
+        l2cap_transport_init();
+        board.control_sock = connect_l2cap(board.mac, 0x11);
+        board.receive_sock = connect_l2cap(board.mac, 0x13);
+        board.transport->prepare(&board);
+    } else if (hidraw_open(&board) != 0) {
+        return 1;
+    }
+    printf("%s, Board %s\n", board.transport->name, board.mac);
+
+    static ReportSlot slot_storage[RECEIVE_BATCH];
+    ReportSlot* slots[RECEIVE_BATCH];
+    for (int i = 0; i < RECEIVE_BATCH; i++) slots[i] = &slot_storage[i];
+
+    // Dauerhaft senden lassen wie die Init-Sequenz (ohne Kalibrierung, die Massen werden nicht gebraucht);
+    // die Längen der Befehle stehen in YAWiiBBessentials.h
+    if (board.transport->send(&board, status_command, 4) < 0 ||
+        board.transport->send(&board, activate_command, 3) < 0 ||
+        board.transport->send(&board, data_dump_command, 4) < 0)
+        return 1;
+
+    // 1. Empfangspfad: CPU-Zeit und Aufrufe pro Report, Abstand vom Kernel-Zeitstempel zum Treiber
+    size_t capacity = (size_t)seconds * 400 + RECEIVE_BATCH;
+    uint64_t* delays = malloc(capacity * sizeof(uint64_t));
+    uint64_t* intervals = malloc(capacity * sizeof(uint64_t));
+    if (delays == NULL || intervals == NULL) {
+        perror("Fehler beim Anlegen der Messwerte");
+        return 1;
+    }
+    uint64_t reports = 0, data_reports = 0, cpu = 0, last_data_ns = 0;
+    size_t delay_count = 0, interval_count = 0;
+    uint64_t end = monotonic_ns() + (uint64_t)seconds * 1000000000ull;
+    while (monotonic_ns() < end) {
+        int filled = receive(&board, slots, 100, &cpu);
+        if (filled < 0) {
+            fprintf(stderr, "Fehler: Verbindung getrennt (%s)\n", errno ? strerror(errno) : "vom Board");
+            return 1;
+        }
+        uint64_t now = monotonic_ns();
+        for (int i = 0; i < filled; i++, reports++) {
+            const ReportSlot* slot = slots[i];
+            if (slot->length < 2 || slot->data[1] != 0x32) continue;
+            data_reports++;
+            if (board.transport == &l2cap_transport && delay_count < capacity) delays[delay_count++] = now - slot->received_ns;
+            if (last_data_ns != 0 && interval_count < capacity) intervals[interval_count++] = slot->received_ns - last_data_ns;
+            last_data_ns = slot->received_ns;
+        }
+    }
+    if (data_reports == 0) {
+        fprintf(stderr, "Fehler: keine Daten-Reports (0x32) empfangen\n");
+        return 1;
+    }
+    printf("Empfang: %llu Reports (%llu Daten) in %d s, %.2f Aufrufe/Report, %.0f ns CPU/Report\n",
+           (unsigned long long)reports, (unsigned long long)data_reports, seconds,
+           (double)board.stats.receive_calls / reports, (double)cpu / reports);
+    print_quantiles("Abstand der Daten-Reports", intervals, interval_count);
+    if (board.transport == &l2cap_transport) print_quantiles("Kernel bis Treiber", delays, delay_count);
+    else printf("%-28s kein Empfangszeitstempel bei hidraw\n", "Kernel bis Treiber");
+
+    // 2. Antwortzeit: Statusanfrage senden, bis zum Empfang des 0x20-Reports
+    uint64_t* replies = malloc((size_t)requests * sizeof(uint64_t));
+    if (replies == NULL) {
+        perror("Fehler beim Anlegen der Messwerte");
+        return 1;
+    }
+    size_t reply_count = 0, lost = 0;
+    for (int r = 0; r < requests; r++) {
+        uint64_t sent = monotonic_ns(), deadline = sent + 500000000ull, answer = 0;
+        if (board.transport->send(&board, data_dump_command, 4) < 0) return 1;
+        while (answer == 0 && monotonic_ns() < deadline) {
+            int filled = receive(&board, slots, 50, &cpu);
+            if (filled < 0) return 1;
+            for (int i = 0; i < filled; i++)
+                if (slots[i]->length >= 2 && slots[i]->data[1] == 0x20 && answer == 0) answer = slots[i]->received_ns;
+        }
+        if (answer > sent) replies[reply_count++] = answer - sent;
+        else lost++;
+        usleep(20000);
+    }
+    print_quantiles("Antwort auf Statusanfrage", replies, reply_count);
+    if (lost > 0) printf("Ohne Antwort: %zu von %d Anfragen\n", lost, requests);
+
+    free(delays);
+    free(intervals);
+    free(replies);
+    if (board.control_sock >= 0) close(board.control_sock);
+    close(board.receive_sock);
+    return lost == 0 ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+// Liest den Binärstrom von "YAWiiBBD -o binary" und gibt jeden Record als CSV-Zeile aus
+// gcc -Wall -o readBinary readBinary.c
+// ./YAWiiBBD -o binary | ./readBinary
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/YAWiiBBbinary.h"
+
+int main() {
+    unsigned char header_bytes[YAWIIBB_BINARY_HEADER_SIZE];
+    BinaryHeader header;
+
+    if (fread(header_bytes, sizeof(header_bytes), 1, stdin) != 1 ||
+        binary_decode_header(header_bytes, &header) != 0) {
+        fprintf(stderr, "Kein gültiger YAWiiBBD-Binärstrom\n");
+        return 1;
+    }
+    fprintf(stderr, "Version %u, Recordgröße %u, Boards %u\n",
+            header.version, header.record_size, header.board_count);
+
+    // Spätere Versionen dürfen Records verlängern, unbekannte Bytes werden übersprungen
+    unsigned char* record = malloc(header.record_size);
+    BinarySample sample;
+
+    printf("timestamp_ns,board,type,flags,raw_tr,raw_br,raw_tl,raw_bl,g_tr,g_br,g_tl,g_bl\n");
+    while (fread(record, header.record_size, 1, stdin) == 1) {
+        binary_decode_sample(record, &sample);
+        printf("%llu,%u,0x%02x,%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+               (unsigned long long)sample.timestamp_ns, sample.board_id, sample.report_type, sample.flags,
+               sample.raw[0], sample.raw[1], sample.raw[2], sample.raw[3],
+               sample.mass[0], sample.mass[1], sample.mass[2], sample.mass[3]);
+    }
+
+    free(record);
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Liest den Shared-Memory-Ring von "YAWiiBBD -o shm" und gibt jeden Record als CSV-Zeile aus
+// gcc -Wall -o readShm readShm.c
+// ./YAWiiBBD -o shm &   ./readShm [Name]
+// Mit -l <Hz> wird stattdessen der Latest-Slot jedes Boards in dieser Bildrate ausgegeben
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../src/YAWiiBBshm.h"
+
+// Gibt den Latest-Slot jedes Boards mit der gewünschten Rate aus, bis der Treiber endet
+static void print_latest(const ShmRingHeader* header, int rate) {
+    ShmLatest latest;
+    struct timespec frame = { 0, 1000000000L / rate };
+
+    printf("timestamp_ns,board,count,flags,raw_tr,raw_br,raw_tl,raw_bl,total_g,cop_x_mm,cop_y_mm\n");
+    while (__atomic_load_n(&header->running, __ATOMIC_ACQUIRE)) {
+        for (uint32_t i = 0; i < header->board_count; i++) {
+            if (!shm_latest_read(header, i, &latest) || latest.count == 0) continue;
+            printf("%llu,%u,%llu,%u,%u,%u,%u,%u,%u,%.1f,%.1f\n", (unsigned long long)latest.timestamp_ns,
+                   latest.board_id, (unsigned long long)latest.count, latest.flags, latest.raw[0], latest.raw[1],
+                   latest.raw[2], latest.raw[3], latest.total, latest.cop[0], latest.cop[1]);
+        }
+        fflush(stdout);
+        nanosleep(&frame, NULL);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int rate = 0;
+    if (argc > 2 && strcmp(argv[1], "-l") == 0) {
+        rate = atoi(argv[2]);
+        argc -= 2;
+        argv += 2;
+    }
+    const char* name = argc > 1 ? argv[1] : YAWIIBB_SHM_DEFAULT_NAME;
+    int fd = shm_open(name, O_RDONLY, 0);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror("Fehler beim Öffnen des Shared-Memory-Rings");
+        return 1;
+    }
+    // Nur lesend abgebildet, der Treiber bemerkt die Leser nicht
+    const ShmRingHeader* header = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED || (size_t)st.st_size < sizeof(ShmRingHeader) || !shm_ring_valid(header)) {
+        fprintf(stderr, "Kein gültiger YAWiiBBD-Ring\n");
+        return 1;
+    }
+    fprintf(stderr, "Version %u, Recordgröße %u, %u Records, Boards %u, Treiber %u\n", header->version,
+            header->record_size, header->capacity, header->board_count, header->writer_pid);
+    for (uint32_t i = 0; i < header->board_count; i++) fprintf(stderr, "[%u] %s\n", i, shm_ring_mac(header, i));
+
+    if (rate > 0) {
+        print_latest(header, rate);
+        return 0;
+    }
+
+    // Ab dem nächsten Record lesen, ältere stehen noch im Ring, sind aber schon vergangen
+    uint64_t next = __atomic_load_n(&header->write_seq, __ATOMIC_ACQUIRE);
+    uint64_t start = next, lost = 0;
+    BinarySample sample;
+
+    printf("timestamp_ns,board,type,flags,raw_tr,raw_br,raw_tl,raw_bl,g_tr,g_br,g_tl,g_bl\n");
+    while (true) {
+        while (shm_ring_read(header, &next, &sample, &lost)) {
+            printf("%llu,%u,0x%02x,%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+                   (unsigned long long)sample.timestamp_ns, sample.board_id, sample.report_type, sample.flags,
+                   sample.raw[0], sample.raw[1], sample.raw[2], sample.raw[3],
+                   sample.mass[0], sample.mass[1], sample.mass[2], sample.mass[3]);
+        }
+        fflush(stdout);
+        if (!__atomic_load_n(&header->running, __ATOMIC_ACQUIRE) &&
+            next == __atomic_load_n(&header->write_seq, __ATOMIC_ACQUIRE)) break;
+        // Ein abgestürzter Treiber setzt running nicht mehr zurück
+        if (kill((pid_t)header->writer_pid, 0) < 0 && errno == ESRCH) break;
+        shm_ring_wait(header, next, 1000);
+    }
+
+    fprintf(stderr, "%llu Records gelesen, %llu verpasst\n", (unsigned long long)(next - start - lost), (unsigned long long)lost);
+    return 0;
+}
@@ -0,0 +1,358 @@
+/**
+ * @file simBoard.c
+ * @brief Simulated Wii Balance Boards for load tests without hardware.
+ *
+ * Every simulated board listens on two Unix SEQPACKET sockets `<dir>/<MAC>.11` and
+ * `<dir>/<MAC>.13` that stand in for the L2CAP control and data channel. The driver
+ * connects to them with `YAWiiBBD -s <dir> <MAC> ...` (see `connect_simulator()`).
+ *
+ * The board side of the protocol is answered on the data channel like a real board:
+ * - `0x12` (report mode, `status_command`): 0x22 acknowledge, mode 0x32 starts the stream
+ * - `0x15` (status request, `data_dump_command`): 0x20 status report
+ * - `0x17` (read memory, `calibration_command`): two 0x21 packets with the calibration,
+ *   delayed by `-l` milliseconds like the round trip of a real board
+ * - `0x11` (LED), `0x13` and everything else: 0x22 acknowledge
+ *
+ * With `-x` the first commands of every connection are ignored like commands lost on
+ * the radio link, which exercises the repetition of unanswered init commands.
+ *
+ * The 0x32 reports are sent at the rate given with `-r` (up to several kHz) and carry a
+ * synthetic sway: the center of pressure moves on two overlaid sine waves per axis plus
+ * a little noise, the total mass stays at `-m` kg. With `-t` the board presses its power
+ * button after the given time, which stops the board in the driver. After a disconnect
+ * a board accepts the next connection, so reconnects can be tested by stopping
+ * (`kill -STOP`/`-CONT`) or restarting the simulator.
+ *
+ * Several instances can run in parallel (`-i` keeps the MAC addresses apart), e.g. to
+ * find the point where the driver saturates:
+ * @code
+ * gcc -Wall -O2 -o simBoard simBoard.c -lpthread -lm
+ * ./simBoard -n 4 -r 2000 -t 10 > macs.txt &
+ * ./YAWiiBBD -s /tmp/wbsim -o binary $(cat macs.txt) > /dev/null
+ * @endcode
+ * The MAC addresses of the simulated boards are printed to stdout as one line,
+ * the achieved rate of every board to stderr at the end.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/prctl.h>
+
+#define SIM_DEFAULT_DIR "/tmp/wbsim"
+
+/**
+ * @struct SimBoard
+ * @brief State of one simulated board.
+ */
+typedef struct {
+    int index;                      /**< Index within this instance */
+    char mac[19];                   /**< MAC address, 02:00:00:00:<instance>:<index> */
+    struct sockaddr_un path[2];     /**< Socket addresses of control (0x11) and data (0x13) channel */
+    int listen_sock[2];             /**< Listening sockets of both channels */
+    uint16_t calibration[3][4];     /**< Raw values at 0, 17 and 34 kg (TR, BR, TL, BL) */
+    double rate;                    /**< Reports per second */
+    double seconds;                 /**< Stream duration until the button is pressed, 0 = unlimited */
+    double mass;                    /**< Total mass in kg */
+    uint64_t latency_ns;            /**< Delay of the answer to a memory read (0x17) */
+    uint32_t lost;                  /**< Commands ignored after every connect (`-x`) */
+    uint64_t sent;                  /**< Number of 0x32 reports sent */
+    double elapsed;                 /**< Duration of the stream in seconds */
+    uint32_t connections;           /**< Number of accepted connections (1 + reconnects) */
+    uint32_t calibration_reads;     /**< Number of memory reads (0x17) received */
+    pthread_t thread;               /**< Thread serving this board */
+} SimBoard;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void put_be16(unsigned char* p, uint16_t value) {
+    p[0] = value >> 8;
+    p[1] = value & 0xff;
+}
+
+// Kleiner xorshift-Generator für das Rauschen, damit jeder Thread seinen eigenen Zustand hat
+static double noise(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (*state / 4294967296.0) - 0.5;
+}
+
+/**
+ * @brief Converts a mass in kg into the raw value of a sensor (inverse of calc_mass()).
+ */
+static uint16_t raw_from_mass(const SimBoard* sim, int pos, double kg) {
+    double kg0 = sim->calibration[0][pos], kg17 = sim->calibration[1][pos], kg34 = sim->calibration[2][pos];
+    double raw;
+    if (kg < 0) kg = 0;
+    if (kg < 17) raw = kg0 + kg * (kg17 - kg0) / 17.0;
+    else raw = kg17 + (kg - 17) * (kg34 - kg17) / 17.0;
+    return raw > 0xffff ? 0xffff : (uint16_t)raw;
+}
+
+static bool send_packet(int sock, const unsigned char* packet, size_t length) {
+    return send(sock, packet, length, MSG_NOSIGNAL) == (ssize_t)length;
+}
+
+static bool send_ack(int sock, unsigned char command, unsigned char error) {
+    const unsigned char ack[] = { 0xa1, 0x22, 0x00, 0x00, command, error };
+    return send_packet(sock, ack, sizeof(ack));
+}
+
+/**
+ * @brief Sends the two 0x21 packets answering `calibration_command`.
+ *
+ * First packet: 0 kg in bytes 7-14, 17 kg in bytes 15-22. Second packet: 34 kg in
+ * bytes 7-14, the rest is 0 (the driver recognises it by byte 15 == 0).
+ */
+static bool send_calibration(int sock, const SimBoard* sim) {
+    unsigned char first[23] = { 0xa1, 0x21, 0x00, 0x00, 0xf0, 0x00, 0x24 };
+    unsigned char second[23] = { 0xa1, 0x21, 0x00, 0x00, 0x70, 0x00, 0x34 };
+    for (int i = 0; i < 4; i++) {
+        put_be16(first + 7 + 2 * i, sim->calibration[0][i]);
+        put_be16(first + 15 + 2 * i, sim->calibration[1][i]);
+        put_be16(second + 7 + 2 * i, sim->calibration[2][i]);
+    }
+    return send_packet(sock, first, sizeof(first)) && send_packet(sock, second, sizeof(second));
+}
+
+/**
+ * @brief Answers one command received on the control channel.
+ *
+ * @return `false` if the data channel is gone.
+ */
+static bool handle_command(int data, SimBoard* sim, const unsigned char* command, ssize_t length, bool* streaming, uint64_t* calibration_due) {
+    if (length < 2 || command[0] != 0x52) return send_ack(data, length > 1 ? command[1] : 0, 0x03);
+    switch (command[1]) {
+        case 0x12:
+            *streaming = (length >= 4 && command[3] == 0x32);
+            return send_ack(data, 0x12, 0x00);
+        case 0x15: {
+            // Status: LED 1 an, Batterie in Byte 7 (Basis 200)
+            const unsigned char status[] = { 0xa1, 0x20, 0x00, 0x00, 0x10, 0x00, 0x00, 0xc0 };
+            return send_packet(data, status, sizeof(status));
+        }
+        case 0x17:
+            sim->calibration_reads++;
+            if (sim->latency_ns == 0) return send_calibration(data, sim);
+            *calibration_due = now_ns() + sim->latency_ns;
+            return true;
+        default:
+            return send_ack(data, command[1], 0x00);
+    }
+}
+
+/**
+ * @brief Fills a 0x32 report with the synthetic sway at time @p t.
+ */
+static void build_report(unsigned char* report, const SimBoard* sim, double t, uint32_t* seed, bool button) {
+    // Schwerpunkt in [-1, 1], x nach rechts, y nach vorne
+    double x = 0.30 * sin(2 * M_PI * 0.23 * t) + 0.08 * sin(2 * M_PI * 1.7 * t + 0.5) + 0.02 * noise(seed);
+    double y = 0.25 * sin(2 * M_PI * 0.17 * t + 1.0) + 0.06 * sin(2 * M_PI * 1.3 * t) + 0.02 * noise(seed);
+    double quarter = sim->mass / 4.0;
+    const double kg[4] = {
+        quarter * (1 + x) * (1 + y),   // TR
+        quarter * (1 + x) * (1 - y),   // BR
+        quarter * (1 - x) * (1 + y),   // TL
+        quarter * (1 - x) * (1 - y)    // BL
+    };
+
+    memset(report, 0, 24);
+    report[0] = 0xa1;
+    report[1] = 0x32;
+    report[3] = button ? 0x08 : 0x00;
+    for (int i = 0; i < 4; i++) put_be16(report + 4 + 2 * i, raw_from_mass(sim, i, kg[i]));
+}
+
+static int accept_channel(SimBoard* sim, int channel) {
+    int sock = accept(sim->listen_sock[channel], NULL, NULL);
+    if (sock < 0) perror("Fehler beim Annehmen der Verbindung");
+    return sock;
+}
+
+/**
+ * @brief Thread serving one simulated board.
+ *
+ * After a disconnect the board accepts the next connection (reconnect of the driver);
+ * the thread ends when the driver disconnects after the power button was pressed.
+ */
+static void* board_thread(void* arg) {
+    SimBoard* sim = (SimBoard*)arg;
+    const uint64_t period = (uint64_t)(1e9 / sim->rate);
+    uint32_t seed = 0x9e3779b9u ^ (uint32_t)(sim->index + 1);
+    bool pressed = false;
+    uint64_t start = 0, next = 0;
+    unsigned char buffer[32];
+    unsigned char report[24];
+
+    while (!pressed) {
+        int control = accept_channel(sim, 0);
+        int data = accept_channel(sim, 1);
+        if (control < 0 || data < 0) break;
+        sim->connections++;
+        bool streaming = false;
+        uint64_t calibration_due = 0;
+        uint32_t lost = sim->lost;
+        // Nach einem Reconnect nicht die verpasste Zeit nachholen
+        if (start != 0 && next < now_ns()) next = now_ns();
+
+        while (true) {
+            // Kommandos: blockierend, solange nicht gestreamt wird, sonst nur abholen
+            ssize_t length = recv(control, buffer, sizeof(buffer), streaming || pressed || calibration_due ? MSG_DONTWAIT : 0);
+            if (length == 0) break; // Treiber hat getrennt
+            if (length > 0) {
+                if (lost > 0) { lost--; continue; } // Kommando geht verloren
+                if (!handle_command(data, sim, buffer, length, &streaming, &calibration_due)) break;
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) break;
+
+            // Verzögerte Antwort auf das Lesen der Kalibrierung
+            if (calibration_due != 0 && now_ns() >= calibration_due) {
+                if (!send_calibration(data, sim)) break;
+                calibration_due = 0;
+                continue;
+            }
+            if (!streaming && !pressed) {
+                usleep(100);
+                continue;
+            }
+
+            if (pressed) {
+                // Taste gedrückt, nur noch auf das Trennen warten
+                if (recv(control, buffer, sizeof(buffer), 0) <= 0) break;
+                continue;
+            }
+            if (start == 0) start = next = now_ns();
+
+            // Absolute Zeitpunkte, damit sich kein Fehler aufsummiert
+            struct timespec ts = { .tv_sec = next / 1000000000ull, .tv_nsec = next % 1000000000ull };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+            double t = (next - start) / 1e9;
+            pressed = sim->seconds > 0 && t >= sim->seconds;
+            build_report(report, sim, t, &seed, pressed);
+            if (!send_packet(data, report, sizeof(report))) break;
+            sim->sent++;
+            next += period;
+        }
+
+        close(control);
+        close(data);
+    }
+
+    if (start != 0) sim->elapsed = (now_ns() - start) / 1e9;
+    return NULL;
+}
+
+static int listen_channel(SimBoard* sim, int channel, const char* dir, int psm) {
+    struct sockaddr_un* addr = &sim->path[channel];
+    addr->sun_family = AF_UNIX;
+    if (snprintf(addr->sun_path, sizeof(addr->sun_path), "%s/%s.%02x", dir, sim->mac, psm) >= (int)sizeof(addr->sun_path)) {
+        fprintf(stderr, "Fehler: Pfad zu lang\n");
+        return -1;
+    }
+    unlink(addr->sun_path);
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (sock < 0 || bind(sock, (struct sockaddr*)addr, sizeof(*addr)) < 0 || listen(sock, 1) < 0) {
+        perror("Fehler beim Anlegen des Simulator-Sockets");
+        return -1;
+    }
+    sim->listen_sock[channel] = sock;
+    return 0;
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Aufruf: %s [-d Verzeichnis] [-n Boards] [-i Instanz] [-r Hz] [-t Sekunden] [-m kg] [-l ms] [-x Kommandos]\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    const char* dir = SIM_DEFAULT_DIR;
+    int count = 1, instance = 0, lost = 0;
+    double rate = 100, seconds = 0, mass = 70, latency = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:n:i:r:t:m:l:x:")) != -1) {
+        switch (opt) {
+            case 'd': dir = optarg; break;
+            case 'n': count = atoi(optarg); break;
+            case 'i': instance = atoi(optarg); break;
+            case 'r': rate = atof(optarg); break;
+            case 't': seconds = atof(optarg); break;
+            case 'm': mass = atof(optarg); break;
+            case 'l': latency = atof(optarg); break;
+            case 'x': lost = atoi(optarg); break;
+            default: print_usage(argv[0]); return 1;
+        }
+    }
+    if (count < 1 || count > 256 || instance < 0 || instance > 255 || rate <= 0 || lost < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+        perror("Fehler beim Anlegen des Verzeichnisses");
+        return 1;
+    }
+    // Genauere Wecker für Raten im kHz-Bereich
+    prctl(PR_SET_TIMERSLACK, 1UL);
+
+    SimBoard* boards = calloc(count, sizeof(SimBoard));
+    for (int i = 0; i < count; i++) {
+        SimBoard* sim = &boards[i];
+        sim->index = i;
+        sim->rate = rate;
+        sim->seconds = seconds;
+        sim->mass = mass;
+        sim->latency_ns = (uint64_t)(latency * 1e6);
+        sim->lost = (uint32_t)lost;
+        snprintf(sim->mac, sizeof(sim->mac), "02:00:00:00:%02X:%02X", instance, i);
+        // Typische Kalibrierwerte mit etwas Streuung je Sensor
+        for (int pos = 0; pos < 4; pos++) {
+            sim->calibration[0][pos] = 0x0500 + 0x20 * pos + i;
+            sim->calibration[1][pos] = 0x0e00 + 0x18 * pos + i;
+            sim->calibration[2][pos] = 0x1700 + 0x10 * pos + i;
+        }
+        // Erst alle Sockets anlegen, damit der Treiber sofort verbinden kann
+        if (listen_channel(sim, 0, dir, 0x11) < 0 || listen_channel(sim, 1, dir, 0x13) < 0) return 1;
+    }
+
+    // MAC-Adressen als eine Zeile für die Kommandozeile des Treibers
+    for (int i = 0; i < count; i++) printf("%s%s", boards[i].mac, i + 1 < count ? " " : "\n");
+    fflush(stdout);
+
+    for (int i = 0; i < count; i++) {
+        if (pthread_create(&boards[i].thread, NULL, board_thread, &boards[i]) != 0) {
+            perror("Fehler beim Erstellen des Threads");
+            return 1;
+        }
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++) {
+        SimBoard* sim = &boards[i];
+        pthread_join(sim->thread, NULL);
+        for (int c = 0; c < 2; c++) {
+            close(sim->listen_sock[c]);
+            unlink(sim->path[c].sun_path);
+        }
+        fprintf(stderr, "%s: %llu Reports in %.3f s = %.0f Hz (Soll %.0f Hz), %u Verbindungen, %u Kalibrier-Abfragen\n", sim->mac,
+                (unsigned long long)sim->sent, sim->elapsed, sim->elapsed > 0 ? sim->sent / sim->elapsed : 0.0, sim->rate, sim->connections, sim->calibration_reads);
+        total += sim->sent;
+    }
+    fprintf(stderr, "Gesamt: %llu Reports\n", (unsigned long long)total);
+    free(boards);
+    return 0;
+}